@@ -0,0 +1,81 @@
+# ROM build profiles: the game built under several compiler settings, each with a size and speed report
+#
+# Every profile runs SGDK's makefile.gen (release target) twice with the same flags: once with BENCH=1 for
+# the benchmark screen (src/bench.c), once for the game. Results go to build/<profile>/:
+#   rom.bin, rom.out (linked ELF), bench.bin, bench.log (benchmark console output), report.csv, budget.csv
+# report.csv (tools/romreport) holds the ROM size, the RAM taken by .data and .bss, and the benchmark
+# cycles per operation when bench.log exists. budget.csv (tools/rambudget) lists RAM per module and per
+# symbol and the worst stack depth (main plus the V-int handler, from -fcallgraph-info); the profile
+# fails when RAM_BUDGET or STACK_BUDGET is exceeded. -flto writes no call graph (not even with
+# -ffat-lto-objects), so the lto profile checks RAM only; its stack use is close to the o3 profile's.
+#
+# Profiles: os (-Os), o2 (-O2), o3 (-O3), lto (makefile.gen's own release flags: -O3 with LTO)
+#
+# Usage, from the project root with GDK set as for a normal build:
+#   make -f rom.mk                 every profile, then the combined report
+#   make -f rom.mk profile-o2      one profile
+#   make -f rom.mk report          build/*/report.csv again as one table (picks up bench.log files
+#                                  saved by hand from an emulator's debug console)
+#   make -f rom.mk budget          o2 build (out/) with the RAM and stack budget check only
+# BENCH_RUN="command" runs each bench.bin (the command gets the ROM path and prints the emulator's debug
+# console to stdout). EXTRA_FLAGS (e.g. -DSIM_ASM=1) goes to every build.
+# The last build leaves the lto game ROM in out/, as a plain release build would.
+
+GDK ?= $(error set GDK to the SGDK install directory)
+SGDK = $(MAKE) -f $(GDK)/makefile.gen
+PROFILES := os o2 o3 lto
+FLAGS_os := -Os -fomit-frame-pointer
+FLAGS_o2 := -O2 -fomit-frame-pointer
+FLAGS_o3 := -O3 -fomit-frame-pointer
+FLAGS_lto :=
+
+# Budgets of the 64KB work RAM: .data + .bss, and the stack that grows down from the end of RAM
+RAM_BUDGET ?= 61440
+STACK_BUDGET ?= 4096
+STACK_FLAGS := -fstack-usage -fcallgraph-info=su
+
+# Clean release build with a profile's flags: $(call release,profile,defines). FLAGS replaces the optimization
+# part of makefile.gen's release flags (DEFAULT_FLAGS, which includes EXTRA_FLAGS, is kept)
+release = $(SGDK) clean && $(SGDK) release EXTRA_FLAGS="$(EXTRA_FLAGS) $(2)" \
+          $(if $(FLAGS_$(1)),FLAGS='$$(DEFAULT_FLAGS) $(FLAGS_$(1))')
+
+# Report of one profile directory: $(call report,profile)
+report = tools/bin/romreport -n -p $(1) -r build/$(1)/rom.bin \
+         $$(test -f build/$(1)/bench.log && echo "-l build/$(1)/bench.log") build/$(1)/rom.out
+
+# Budget check of a profile's build in out/ (objects name the modules, .ci files give frames and calls):
+# $(call budget,profile). No stack budget for lto, which has no call graph
+budget = tools/bin/rambudget -r $(RAM_BUDGET) -s $(if $(filter lto,$(1)),0,$(STACK_BUDGET)) -i renderVInt \
+         out/rom.out $$(find out -name '*.o' -o -name '*.ci')
+
+all: $(addprefix profile-,$(PROFILES))
+	@$(MAKE) -s -f rom.mk report
+
+profile-%: tools/bin/romreport tools/bin/rambudget
+	mkdir -p build/$*
+	$(call release,$*,-DBENCH=1)
+	cp out/rom.bin build/$*/bench.bin
+	$(call release,$*,$(STACK_FLAGS))
+	cp out/rom.bin out/rom.out build/$*/
+	$(call budget,$*) > build/$*/budget.csv
+	$(if $(BENCH_RUN),$(BENCH_RUN) build/$*/bench.bin > build/$*/bench.log)
+	$(call report,$*) > build/$*/report.csv
+
+report: tools/bin/romreport
+	@echo profile,metric,value
+	@for p in $(PROFILES); do \
+	    if test -f build/$$p/rom.out; then $(call report,$$p); fi; \
+	done
+
+budget: tools/bin/rambudget
+	$(call release,o2,$(STACK_FLAGS))
+	$(call budget,o2)
+
+tools/bin/%: tools/%.c tools/elf.c tools/elf.h
+	$(MAKE) -C tools bin/$*
+
+clean:
+	rm -rf build
+
+.NOTPARALLEL:
+.PHONY: all report budget clean
@@ -0,0 +1,388 @@
+// Snake AI shared by the ROM (AI demo) and the host tools (see ai.h)
+
+#include "ai.h"
+#include "ai_weights.h"
+
+#define CELL_COUNT (GRID_WIDTH * GRID_HEIGHT)
+#define CELL_BLOCKED 0x01      // Wall, border or body
+#define CELL_PORTAL 0x02       // Portal tile (entering it lands on its partner)
+#define CELL_TAIL 0x04         // Tail tile (free once the snake moves)
+#define NUM_PORTAL_CELLS (NUM_PORTALS * 2)
+
+// Cell index helpers: y = c / 40 via one 16x16 multiply (exact for c < 1120)
+#define CELL(x, y) ((u16)((y) * GRID_WIDTH + (x)))
+#define CELL_Y(c) ((u16)(((u32)(c) * 1639) >> 16))
+#define CELL_X(c) ((u16)((c) - CELL_Y(c) * GRID_WIDTH))
+#define HEAP_NONE 0xFFFF       // heapPos value: not in the open set
+#define HEAP_CLOSED 0xFFFE     // heapPos value: already expanded
+#define LANDMARK_FAR 0xFF      // landmarkDist value: not reached from the landmark (or 255+ steps away)
+
+const AiWeights aiDefaultWeights = { AI_WEIGHT_FOOD, AI_WEIGHT_AREA, AI_WEIGHT_TAIL, AI_WEIGHT_PORTAL };
+
+// Search scratch buffers (static: no heap allocation on the cartridge; per thread on the host). newSearch()
+// resets them in O(1): a cell counts as untouched until its stamp matches the current search id
+static SIM_THREAD_LOCAL u8 grid[CELL_COUNT] SIM_WORD_ALIGNED; // CELL_* flags for the current decision
+static SIM_THREAD_LOCAL u16 stamp[CELL_COUNT];        // Search id that last touched the cell (lazy reset)
+static SIM_THREAD_LOCAL u16 gScore[CELL_COUNT];       // A* path length from the start
+static SIM_THREAD_LOCAL u16 fScore[CELL_COUNT];       // A* g + heuristic
+static SIM_THREAD_LOCAL u16 heapPos[CELL_COUNT];      // Position in the open-set heap (or HEAP_NONE/HEAP_CLOSED)
+static SIM_THREAD_LOCAL u16 work[CELL_COUNT];         // A* heap or flood fill queue (never used at the same time)
+static SIM_THREAD_LOCAL u16 heapSize;                 // Entries in the open-set heap
+static SIM_THREAD_LOCAL u16 searchId;                 // Current search id for stamp[]
+static SIM_THREAD_LOCAL AiPeaks peaks;                // High-water marks since the last aiPeaks()
+static SIM_THREAD_LOCAL u16 portalCell[NUM_PORTAL_CELLS]; // Portal tiles
+static SIM_THREAD_LOCAL u16 portalPartner[NUM_PORTAL_CELLS]; // Tile each portal lands on
+static SIM_THREAD_LOCAL u16 portalInward[NUM_PORTAL_CELLS]; // Only legal direction out of each portal tile
+static SIM_THREAD_LOCAL Point portalPos[NUM_PORTAL_CELLS]; // Portal coordinates (heuristic)
+static SIM_THREAD_LOCAL Point portalExitPos[NUM_PORTAL_CELLS]; // Landing coordinates (heuristic)
+#if AI_LANDMARKS
+static SIM_THREAD_LOCAL u8 landmarkDist[AI_LANDMARKS][CELL_COUNT] SIM_WORD_ALIGNED; // Wall-only BFS distance from each landmark
+static SIM_THREAD_LOCAL u16 landmarkCount;            // Landmarks placed for the level
+static SIM_THREAD_LOCAL u16 landmarkReady;            // landmarkDist[] matches landmarkWalls[] and landmarkPortals[]
+static SIM_THREAD_LOCAL WallSegment landmarkWalls[MAX_WALLS]; // Maze the tables were built for
+static SIM_THREAD_LOCAL u16 landmarkWallCount;
+static SIM_THREAD_LOCAL Portal landmarkPortals[NUM_PORTALS];
+#endif
+
+// Starts a new search; stamps wrap after 65535 searches and force one full reset
+static void newSearch(void) {
+    searchId++;
+    if (searchId == 0) {
+        simFillWords(stamp, 0, CELL_COUNT);
+        searchId = 1;
+    }
+}
+
+// Raises a high-water mark
+static void peak(u16* mark, u16 value) {
+    if (value > *mark) *mark = value;
+}
+
+// Marks walls and borders as blocked and sets up the portals (the level part of the grid)
+static void buildLevelGrid(const SimState* s) {
+    // Whole rows per fill (HUD row and top border, playfield rows, bottom border), then the side borders
+    simFillBytes(grid, CELL_BLOCKED, CELL(0, 2));
+    simFillBytes(&grid[CELL(0, 2)], 0, CELL(0, GRID_HEIGHT - 1) - CELL(0, 2));
+    simFillBytes(&grid[CELL(0, GRID_HEIGHT - 1)], CELL_BLOCKED, GRID_WIDTH);
+    for (u16 y = 2; y < GRID_HEIGHT - 1; y++) grid[CELL(0, y)] = grid[CELL(GRID_WIDTH - 1, y)] = CELL_BLOCKED;
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        const Portal* p = &s->portals[i];
+        for (u16 k = 0; k < 2; k++) {
+            const u16 n = i * 2 + k;
+            const Point from = k ? p->exit : p->entry;
+            const Point to = k ? p->entry : p->exit;
+            portalCell[n] = CELL(from.x, from.y);
+            portalPartner[n] = CELL(to.x, to.y);
+            portalPos[n] = from;
+            portalExitPos[n] = to;
+            grid[portalCell[n]] = CELL_PORTAL;
+        }
+        // Landing on a portal tile leaves it inward only
+        portalInward[i * 2] = (p->entry.y == 1) ? DIR_DOWN : DIR_RIGHT;
+        portalInward[i * 2 + 1] = (p->exit.y == GRID_HEIGHT - 1) ? DIR_UP : DIR_LEFT;
+    }
+    for (u16 i = 0; i < s->wallSegmentCount; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        for (u16 k = 0; k < w->length; k++) {
+            if (!WALL_SKIPPED(w, k)) grid[CELL(WALL_TILE_X(w, k), WALL_TILE_Y(w, k))] |= CELL_BLOCKED;
+        }
+    }
+}
+
+// Marks walls, borders and body as blocked; portals and the tail stay passable
+static void buildGrid(const SimState* s) {
+    buildLevelGrid(s);
+    for (u16 i = 0; i + 1 < s->snakeLength; i++) grid[CELL(s->snakeBody[i].x, s->snakeBody[i].y)] |= CELL_BLOCKED;
+    const Point tail = s->snakeBody[s->snakeLength - 1];
+    grid[CELL(tail.x, tail.y)] |= CELL_TAIL;
+}
+
+// Index of a portal tile in portalCell[]
+static u16 portalIndex(u16 c) {
+    for (u16 i = 0; i < NUM_PORTAL_CELLS; i++) {
+        if (portalCell[i] == c) return i;
+    }
+    return 0;
+}
+
+// Cell reached from c in direction dir (portals applied), or -1 if the move is blocked
+static s16 neighbor(u16 c, u16 dir) {
+    if (grid[c] & CELL_PORTAL) {
+        if (dir != portalInward[portalIndex(c)]) return -1;
+    }
+    u16 n = c + simDirCell[dir];
+    if (grid[n] & CELL_PORTAL) n = portalPartner[portalIndex(n)];
+    if (grid[n] & CELL_BLOCKED) return -1;
+    return n;
+}
+
+// Manhattan distance, also through each portal (admissible with teleports), raised to the landmark bound
+static u16 heuristic(u16 c, Point goal, u16 goalCell) {
+    const s16 x = CELL_X(c);
+    const s16 y = CELL_Y(c);
+    u16 best = abs(x - goal.x) + abs(y - goal.y);
+    for (u16 i = 0; i < NUM_PORTAL_CELLS; i++) {
+        const u16 d = abs(x - portalPos[i].x) + abs(y - portalPos[i].y) +
+                      abs(portalExitPos[i].x - goal.x) + abs(portalExitPos[i].y - goal.y);
+        if (d < best) best = d;
+    }
+#if AI_LANDMARKS
+    // d(c, goal) >= d(L, goal) - d(L, c) always. d(c, goal) >= d(c, L) - d(goal, L) needs d(x, L) = d(L, x),
+    // true between non-portal cells (a path reverses through a portal) but not for a portal tile, which
+    // can only be landed on from its partner's side
+    const u16 reversible = !((grid[c] | grid[goalCell]) & CELL_PORTAL);
+    for (u16 k = 0; k < landmarkCount; k++) {
+        const u16 dc = landmarkDist[k][c];
+        const u16 dg = landmarkDist[k][goalCell];
+        if (dc == LANDMARK_FAR || dg == LANDMARK_FAR) continue;
+        if (dg > dc) {
+            if (dg - dc > best) best = dg - dc;
+        } else if (reversible && dc - dg > best) {
+            best = dc - dg;
+        }
+    }
+#else
+    (void)goalCell;
+#endif
+    return best;
+}
+
+static void heapSwap(u16 a, u16 b) {
+    const u16 t = work[a];
+    work[a] = work[b];
+    work[b] = t;
+    heapPos[work[a]] = a;
+    heapPos[work[b]] = b;
+}
+
+static void heapUp(u16 i) {
+    while (i > 0) {
+        const u16 parent = (i - 1) >> 1;
+        if (fScore[work[parent]] <= fScore[work[i]]) break;
+        heapSwap(i, parent);
+        i = parent;
+    }
+}
+
+static u16 heapPop(void) {
+    const u16 top = work[0];
+    heapSize--;
+    if (heapSize > 0) {
+        work[0] = work[heapSize];
+        heapPos[work[0]] = 0;
+        u16 i = 0;
+        for (;;) {
+            const u16 l = i * 2 + 1;
+            const u16 r = l + 1;
+            u16 m = i;
+            if (l < heapSize && fScore[work[l]] < fScore[work[m]]) m = l;
+            if (r < heapSize && fScore[work[r]] < fScore[work[m]]) m = r;
+            if (m == i) break;
+            heapSwap(i, m);
+            i = m;
+        }
+    }
+    heapPos[top] = HEAP_CLOSED;
+    return top;
+}
+
+// A* from start to goal over the current grid
+static u16 astar(u16 start, Point goal) {
+    u16 goalCell = CELL(goal.x, goal.y);
+    if (grid[goalCell] & CELL_PORTAL) goalCell = portalPartner[portalIndex(goalCell)]; // Eaten on entry, head lands on partner
+    newSearch();
+    heapSize = 0;
+    stamp[start] = searchId;
+    gScore[start] = 0;
+    fScore[start] = heuristic(start, goal, goalCell);
+    work[heapSize] = start;
+    heapPos[start] = heapSize++;
+    u16 expanded = 0;
+    u16 length = AI_NO_PATH;
+    while (heapSize > 0) {
+        const u16 c = heapPop();
+        expanded++;
+        if (c == goalCell) {
+            length = gScore[c];
+            break;
+        }
+        for (u16 dir = 0; dir < 4; dir++) {
+            const s16 n = neighbor(c, dir);
+            if (n < 0) continue;
+            const u16 g = gScore[c] + 1;
+            if (stamp[n] != searchId) {
+                stamp[n] = searchId;
+                heapPos[n] = HEAP_NONE;
+            } else if (heapPos[n] == HEAP_CLOSED || g >= gScore[n]) {
+                continue;
+            }
+            gScore[n] = g;
+            fScore[n] = (n == goalCell) ? g : g + heuristic(n, goal, goalCell);
+            if (heapPos[n] == HEAP_NONE) {
+                work[heapSize] = n;
+                heapPos[n] = heapSize++;
+                peak(&peaks.open, heapSize);
+            }
+            heapUp(heapPos[n]);
+        }
+    }
+    peak(&peaks.expanded, expanded);
+    return length;
+}
+
+// Flood fill from start: counts reachable cells (up to AI_AREA_CAP) and reports if the tail is reachable
+// (reaching the cap counts as reachable, otherwise the snake would circle its own tail in open space)
+static u16 floodArea(u16 start, u16* tailReachable) {
+    u16 head = 0;
+    u16 tailIdx = 0;
+    newSearch();
+    stamp[start] = searchId;
+    work[tailIdx++] = start;
+    *tailReachable = FALSE;
+    while (head < tailIdx && tailIdx < AI_AREA_CAP) {
+        const u16 c = work[head++];
+        for (u16 dir = 0; dir < 4; dir++) {
+            const s16 n = neighbor(c, dir);
+            if (n < 0 || stamp[n] == searchId) continue;
+            stamp[n] = searchId;
+            if (grid[n] & CELL_TAIL) *tailReachable = TRUE;
+            work[tailIdx++] = n;
+        }
+    }
+    peak(&peaks.queue, tailIdx);
+    if (tailIdx >= AI_AREA_CAP) {
+        *tailReachable = TRUE;                            // Hit the cap: counts as room enough
+        return AI_AREA_CAP;
+    }
+    return tailIdx;
+}
+
+#if AI_LANDMARKS
+// TRUE when the walls or portals differ from the ones the landmark tables were built for
+static u16 mazeChanged(const SimState* s) {
+    if (!landmarkReady || s->wallSegmentCount != landmarkWallCount) return TRUE;
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        const Portal* p = &s->portals[i];
+        const Portal* q = &landmarkPortals[i];
+        if (p->entry.x != q->entry.x || p->entry.y != q->entry.y || p->exit.x != q->exit.x || p->exit.y != q->exit.y) return TRUE;
+    }
+    for (u16 i = 0; i < landmarkWallCount; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        const WallSegment* v = &landmarkWalls[i];
+        if (w->x != v->x || w->y != v->y || w->length != v->length || w->flags != v->flags) return TRUE;
+    }
+    return FALSE;
+}
+
+// BFS from one landmark over the level grid (work[] is the queue); stops at 254 steps
+static void landmarkFill(u8* dist, u16 from) {
+    u16 head = 0;
+    u16 tailIdx = 0;
+    simFillBytes(dist, LANDMARK_FAR, CELL_COUNT);
+    dist[from] = 0;
+    work[tailIdx++] = from;
+    while (head < tailIdx) {
+        const u16 c = work[head++];
+        if (dist[c] == LANDMARK_FAR - 1) continue;
+        for (u16 dir = 0; dir < 4; dir++) {
+            const s16 n = neighbor(c, dir);
+            if (n < 0 || dist[n] != LANDMARK_FAR) continue;
+            dist[n] = dist[c] + 1;
+            work[tailIdx++] = n;
+        }
+    }
+    peak(&peaks.queue, tailIdx);
+}
+
+// Places the landmarks and fills their tables (leaves the level grid in grid[]). The first landmark is
+// the free cell nearest the top-left corner; each next one is the reachable cell farthest from all
+// landmarks so far, which spreads them to the maze's extremities where their bounds are tightest.
+static void prepareLevel(const SimState* s) {
+    if (!mazeChanged(s)) return;
+    buildLevelGrid(s);
+    u16 next = CELL(1, 2);
+    while (grid[next]) next++;
+    for (landmarkCount = 0; landmarkCount < AI_LANDMARKS; ) {
+        landmarkFill(landmarkDist[landmarkCount++], next);
+        u16 farthest = 0;
+        for (u16 c = CELL(1, 2); c < CELL(0, GRID_HEIGHT - 1); c++) {
+            if (grid[c] || landmarkDist[0][c] == LANDMARK_FAR) continue;
+            u16 d = LANDMARK_FAR;
+            for (u16 k = 0; k < landmarkCount; k++) {
+                if (landmarkDist[k][c] < d) d = landmarkDist[k][c];
+            }
+            if (d > farthest) {
+                farthest = d;
+                next = c;
+            }
+        }
+        if (farthest == 0) break;     // Every reachable cell is a landmark already
+    }
+    for (u16 i = 0; i < s->wallSegmentCount; i++) landmarkWalls[i] = s->mazeWalls[i];
+    for (u16 i = 0; i < NUM_PORTALS; i++) landmarkPortals[i] = s->portals[i];
+    landmarkWallCount = s->wallSegmentCount;
+    landmarkReady = TRUE;
+}
+#endif
+
+void aiPrepareLevel(const SimState* s) {
+#if AI_LANDMARKS
+    prepareLevel(s);
+#else
+    (void)s;
+#endif
+}
+
+void aiPeaks(AiPeaks* out) {
+    *out = peaks;
+    peaks.open = peaks.queue = peaks.expanded = 0;
+}
+
+u16 aiPathLength(const SimState* s, Point from, Point to) {
+    aiPrepareLevel(s);
+    buildGrid(s);
+    return astar(CELL(from.x, from.y), to);
+}
+
+u16 aiChooseMove(const SimState* s, const AiWeights* w) {
+    u16 best = s->direction;
+    s32 bestScore = -0x7FFFFFFF;
+    u16 deadEnd = 0;                  // Search id of the last A* that failed from a non-portal start (0: none)
+    aiPrepareLevel(s);
+    buildGrid(s);
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (dir == simDirOpposite[s->direction]) continue;
+        Point head;
+        simNextHead(s, dir, &head);
+        if (simIsBlocked(s, head.x, head.y)) continue;
+
+        // Evaluate from the new head: the old head becomes body, which the grid already blocks
+        const u16 start = CELL(head.x, head.y);
+        const u8 saved = grid[start];
+        // A failed A* stamped every cell reachable from its start. Paths between non-portal cells reverse,
+        // so a start among them shares that region and cannot reach the food either: skip its search
+        const u16 cutOff = deadEnd && stamp[start] == deadEnd && !(saved & CELL_PORTAL);
+        grid[start] |= CELL_BLOCKED;
+        u16 tailReachable;
+        const u16 area = floodArea(start, &tailReachable);
+        u16 dist = 0;
+        if (head.x != s->food.x || head.y != s->food.y) {
+            dist = cutOff ? AI_NO_PATH : astar(start, s->food);
+            if (dist == AI_NO_PATH && !cutOff && !(saved & CELL_PORTAL)) deadEnd = searchId;
+        }
+        grid[start] = saved;
+
+        // Path length is capped so an unreachable food cannot overflow the 16x16 product
+        const s16 distTerm = dist > 1000 ? 1000 : dist;
+        s32 score = (s32)w->area * (s16)area - (s32)w->food * distTerm;
+        if (tailReachable) score += w->tail;
+        const s16 rawX = s->snakeBody[0].x + simDirDX[dir];
+        const s16 rawY = s->snakeBody[0].y + simDirDY[dir];
+        if (rawX != head.x || rawY != head.y) score += w->portal;
+        if (score > bestScore) {
+            bestScore = score;
+            best = dir;
+        }
+    }
+    return best;
+}
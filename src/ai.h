@@ -0,0 +1,57 @@
+// Snake AI shared by the ROM (AI demo) and the host tools
+//
+// Overview:
+// One-step lookahead over the three non-reversing moves. Each surviving move is scored with weighted
+// heuristics evaluated from the head position it leads to:
+// - food:   A* path length to the food, shorter is better
+// - area:   cells reachable by flood fill (capped at AI_AREA_CAP), more room is better
+// - tail:   whether the tail is reachable (a path to the tail means the snake can always follow it)
+// - portal: whether the move goes through a portal
+// Weights are small integers so the evaluation is 16x16-bit multiplies on the 68000. The defaults in
+// ai_weights.h are generated by tools/tuner.
+//
+// A* heuristic: portal-aware Manhattan distance. With AI_LANDMARKS > 0 it is raised to the landmark (ALT)
+// bound: walls and portals are fixed for a level, so once per level a BFS over the wall-only graph (portals
+// included, body ignored) stores each cell's distance from a few landmark cells as u8 tables, and the
+// triangle inequality turns them into a lower bound that follows the maze's corridors. The body only
+// removes moves, so the bound holds during play. The generated mazes are too sparse for it to pay (a few
+// short wall runs: Manhattan is within ~11% of the path length), hence off by default.
+// Most A* work goes into searches that fail because the body cuts the food off; a failed search's region
+// is reused for the other moves of the same decision (see aiChooseMove()).
+//
+// Memory: every search runs in fixed static buffers of one cell per entry (no MEM_alloc, whose small heap
+// fragments), reset in O(1) per search by a search id stamp. The A* heap and the BFS queues share one of
+// them. aiPeaks() reports how much of it the searches really used, to size it for the worst level.
+
+#ifndef _AI_H_
+#define _AI_H_
+
+#include "sim.h"
+
+#define AI_AREA_CAP 160        // Flood fill stops after this many cells (2x max snake length)
+#define AI_NO_PATH 0x7FFF      // Path length reported when the food is unreachable
+#ifndef AI_LANDMARKS
+#define AI_LANDMARKS 0         // Landmark distance tables (1120 bytes of RAM each); 0 = Manhattan heuristic only
+#endif
+
+typedef struct {
+    s16 food;                  // Weight per step of path length to food (subtracted)
+    s16 area;                  // Weight per reachable cell (up to AI_AREA_CAP)
+    s16 tail;                  // Bonus when the tail is reachable
+    s16 portal;                // Bonus (or penalty) for moving through a portal
+} AiWeights;
+
+typedef struct {
+    u16 open;                  // Most cells in the A* open set (heap) at once
+    u16 queue;                 // Longest flood fill or landmark BFS queue
+    u16 expanded;              // Most cells expanded by one A* search
+} AiPeaks;
+
+extern const AiWeights aiDefaultWeights;  // Tuned weights from ai_weights.h
+
+u16 aiChooseMove(const SimState* s, const AiWeights* w); // Best direction for the next step
+u16 aiPathLength(const SimState* s, Point from, Point to); // A* path length (AI_NO_PATH if none)
+void aiPrepareLevel(const SimState* s);   // Builds the level's landmark tables ahead of the first move (else done then)
+void aiPeaks(AiPeaks* out);               // Scratch high-water marks of this thread since the last call (then reset)
+
+#endif // _AI_H_
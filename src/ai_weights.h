@@ -0,0 +1,13 @@
+// AI heuristic weights
+// Generated by tools/tuner -p 48 -g 20 -k 24 -m 5000 -s 1 (individual 0: 33,27,1953,95)
+// Regenerate rather than edit
+
+#ifndef _AI_WEIGHTS_H_
+#define _AI_WEIGHTS_H_
+
+#define AI_WEIGHT_FOOD 2       // Per step of path length to food
+#define AI_WEIGHT_AREA 12      // Per reachable cell
+#define AI_WEIGHT_TAIL 1413    // Tail reachable
+#define AI_WEIGHT_PORTAL 66    // Move goes through a portal
+
+#endif // _AI_WEIGHTS_H_
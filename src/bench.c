@@ -0,0 +1,443 @@
+// Hot-path benchmarks shared by the ROM benchmark screen and tools/simbench (see bench.h)
+
+#include "bench.h"
+#ifndef SIM_HOST
+#include "ai.h"
+#endif
+
+// simIsBlocked() before the wall index and body bounding box (every wall tile is compared)
+u16 benchRefIsBlocked(const SimState* s, s16 x, s16 y) {
+    if (x <= 0 || x >= GRID_WIDTH - 1 || y <= 1 || y >= GRID_HEIGHT - 1) {
+        u16 isPortal = FALSE;
+        for (u16 i = 0; i < NUM_PORTALS; i++) {
+            if ((x == s->portals[i].entry.x && y == s->portals[i].entry.y) ||
+                (x == s->portals[i].exit.x && y == s->portals[i].exit.y)) {
+                isPortal = TRUE;
+            }
+        }
+        if (!isPortal) return TRUE;
+    }
+    for (u16 i = 1; i < s->snakeLength; i++) {
+        if (s->snakeBody[i].x == x && s->snakeBody[i].y == y) return TRUE;
+    }
+    for (u16 i = 0; i < s->wallSegmentCount; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        for (u16 k = 0; k < w->length; k++) {
+            if (!WALL_SKIPPED(w, k) && WALL_TILE_X(w, k) == x && WALL_TILE_Y(w, k) == y) return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Free list updates as simStep() does them without SIM_FREE_BITMAP
+void benchRefFreeAdd(BenchFreeList* l, Point p) {
+    l->tiles[l->count++] = p;
+}
+
+void benchRefFreeRemove(BenchFreeList* l, Point p) {
+    for (u16 i = 0; i < l->count; i++) {
+        if (l->tiles[i].x == p.x && l->tiles[i].y == p.y) {
+            l->tiles[i] = l->tiles[--l->count];
+            return;
+        }
+    }
+}
+
+// Food candidates: playfield and portal cells that hold no wall, body segment or food
+void benchFreeCells(const SimState* s, BenchFreeList* l, FreeMap* m) {
+    l->count = 0;
+    simFreeMapClear(m);
+    for (s16 y = 1; y < GRID_HEIGHT; y++) {
+        for (s16 x = 0; x < GRID_WIDTH; x++) {
+            const Point p = { x, y };
+            if (simIsBlocked(s, x, y)) continue; // Border outside the portals, wall, body behind the head
+            if ((x == s->food.x && y == s->food.y) || (x == s->snakeBody[0].x && y == s->snakeBody[0].y)) continue;
+            benchRefFreeAdd(l, p);
+            simFreeMapAdd(m, x, y);
+        }
+    }
+}
+
+u16 benchFreeSame(const BenchFreeList* l, const FreeMap* m) {
+    u16 mapCount = 0;
+    for (u16 y = 0; y < GRID_HEIGHT; y++) mapCount += m->rowCount[y];
+    if (mapCount != l->count) return FALSE;
+    for (u16 i = 0; i < l->count; i++) {
+        const Point p = l->tiles[i];
+        if (!(m->bits[p.y][p.x >> 3] & (0x80 >> (p.x & 7)))) return FALSE;
+    }
+    return TRUE;
+}
+
+// Free set changes of one simStep() that did not end the level or the game, in simStep()'s order
+u16 benchFreeOps(const SimState* before, const SimState* after, u16 events, BenchFreeOp* ops) {
+    const Point head = after->snakeBody[0];
+    const u16 onFood = head.x == before->food.x && head.y == before->food.y;
+    u16 n = 0;
+    if (!(events & SIM_EVENT_GREW)) {
+        ops[n].p = before->snakeBody[before->snakeLength - 1];
+        ops[n++].remove = FALSE;
+    }
+    if (!onFood) {
+        ops[n].p = head;
+        ops[n++].remove = TRUE;
+    }
+    if (events & SIM_EVENT_ATE) {
+        if (!onFood) {                    // Food taken through a portal
+            ops[n].p = before->food;
+            ops[n++].remove = FALSE;
+        }
+        ops[n].p = after->food;
+        ops[n++].remove = TRUE;
+    }
+    return n;
+}
+
+#if SIM_FOOD_REGIONS
+// Reachable food placement before the region labels: a breadth-first search from the head over the cells
+// simIsBlocked() lets it enter, with portals applied (a portal tile stepped on counts as reached), then the
+// draw-th reached free cell in free set order. One search per food, however little the body moved
+u16 benchRefPlaceFood(const SimState* s, u16 draw, u8* reached, Point* food) {
+    static u16 queue[GRID_WIDTH * GRID_HEIGHT];
+    const Point head = s->snakeBody[0];
+    u16 readPos = 0;
+    u16 writePos = 0;
+    simFillBytes(reached, 0, GRID_WIDTH * GRID_HEIGHT);
+    reached[head.y * GRID_WIDTH + head.x] = 3;
+    queue[writePos++] = head.y * GRID_WIDTH + head.x;
+    while (readPos < writePos) {
+        const u16 c = queue[readPos++];
+        for (u16 dir = 0; dir < 4; dir++) {
+            Point to = { c % GRID_WIDTH + simDirDX[dir], c / GRID_WIDTH + simDirDY[dir] };
+            Point tile = to;
+            for (u16 i = 0; i < NUM_PORTALS; i++) {
+                if (to.x == s->portals[i].entry.x && to.y == s->portals[i].entry.y) {
+                    to = s->portals[i].exit;
+                    break;
+                } else if (to.x == s->portals[i].exit.x && to.y == s->portals[i].exit.y) {
+                    to = s->portals[i].entry;
+                    break;
+                }
+            }
+            if (simIsBlocked(s, to.x, to.y)) continue;
+            reached[tile.y * GRID_WIDTH + tile.x] |= 1;
+            const u16 cell = to.y * GRID_WIDTH + to.x;
+            if (reached[cell] & 2) continue; // Bit 1: queued (a tile stepped on is reached, not expanded)
+            reached[cell] = 3;
+            queue[writePos++] = cell;
+        }
+    }
+    u16 count = 0;
+#if SIM_FREE_BITMAP
+    for (u16 y = 0; y < GRID_HEIGHT; y++) {
+        for (u16 x = 0; x < GRID_WIDTH; x++) {
+            if ((s->freeMap.bits[y][x >> 3] & (0x80 >> (x & 7))) && reached[y * GRID_WIDTH + x]) count++;
+        }
+    }
+    if (!count) return 0;
+    draw %= count;
+    for (u16 y = 0; y < GRID_HEIGHT; y++) {
+        for (u16 x = 0; x < GRID_WIDTH; x++) {
+            if ((s->freeMap.bits[y][x >> 3] & (0x80 >> (x & 7))) && reached[y * GRID_WIDTH + x] && draw-- == 0) {
+                food->x = x;
+                food->y = y;
+                return count;
+            }
+        }
+    }
+#else
+    for (u16 i = 0; i < s->freeTileCount; i++) count += reached[s->freeTiles[i].y * GRID_WIDTH + s->freeTiles[i].x] != 0;
+    if (!count) return 0;
+    draw %= count;
+    for (u16 i = 0; i < s->freeTileCount; i++) {
+        if (reached[s->freeTiles[i].y * GRID_WIDTH + s->freeTiles[i].x] && draw-- == 0) {
+            *food = s->freeTiles[i];
+            return count;
+        }
+    }
+#endif
+    return count;
+}
+#endif
+
+#ifndef SIM_HOST
+#define BENCH_SEED 0x5EED      // First game seed (the next game uses seed + 1, ...)
+#define BENCH_STEPS 300        // AI steps sampled per case
+#define BENCH_REPEAT 8         // Timed passes per state (subtick timer resolution is ~100 cycles)
+#define CYCLES_PER_SUBTICK 100 // 7.67 MHz / 76800 subticks per second (NTSC)
+
+typedef u16 (*BlockedFn)(const SimState* s, s16 x, s16 y);
+
+static SimState benchGame;                // Game the cases sample their states from
+static volatile u16 benchSink;            // Keeps the timed results alive
+static u16 benchRow;                      // Next text row on the result screen
+
+// Plays one AI step on benchGame, restarting or advancing levels as needed
+static void benchAdvance(void) {
+    const u16 events = simStep(&benchGame, aiChooseMove(&benchGame, &aiDefaultWeights));
+    if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) simInitGame(&benchGame, benchGame.seed + 1);
+    else if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&benchGame);
+}
+
+static u32 timeBlocked(BlockedFn fn, const Point* cells, u16 count) {
+    const u32 start = getSubTick();
+    for (u16 r = 0; r < BENCH_REPEAT; r++) {
+        for (u16 i = 0; i < count; i++) benchSink += fn(&benchGame, cells[i].x, cells[i].y);
+    }
+    return getSubTick() - start;
+}
+
+// Prints one case: reference and optimized cycles per operation, and result mismatches
+static void benchReport(const char* name, u32 refTicks, u32 newTicks, u32 ops, u16 mismatches) {
+    char line[40];
+    const u32 refCycles = refTicks * CYCLES_PER_SUBTICK / ops;
+    const u32 newCycles = newTicks * CYCLES_PER_SUBTICK / ops;
+    sprintf(line, "REF %5u NEW %5u", (u16)refCycles, (u16)newCycles); // SGDK's sprintf: no 'l' or '-'
+    VDP_drawText(name, 1, benchRow);
+    VDP_drawText(line, 12, benchRow++);
+    if (mismatches) {
+        sprintf(line, "  %u MISMATCHES", mismatches);
+        VDP_drawText(line, 1, benchRow++);
+    }
+    kprintf("bench,%s,%u,%u,%u", name, (u16)refCycles, (u16)newCycles, mismatches); // Read by tools/romreport
+}
+
+// Collision queries for the four moves out of the head (what simStep() and the policies ask)
+static void benchCollision(void) {
+    u32 refTicks = 0;
+    u32 newTicks = 0;
+    u16 mismatches = 0;
+    Point cells[4];
+    simInitGame(&benchGame, BENCH_SEED);
+    for (u16 step = 0; step < BENCH_STEPS; step++) {
+        for (u16 dir = 0; dir < 4; dir++) {
+            simNextHead(&benchGame, dir, &cells[dir]);
+            mismatches += simIsBlocked(&benchGame, cells[dir].x, cells[dir].y) !=
+                          benchRefIsBlocked(&benchGame, cells[dir].x, cells[dir].y);
+        }
+        refTicks += timeBlocked(benchRefIsBlocked, cells, 4);
+        newTicks += timeBlocked(simIsBlocked, cells, 4);
+        benchAdvance();
+    }
+    benchReport("COLLISION", refTicks, newTicks, (u32)BENCH_STEPS * 4 * BENCH_REPEAT, mismatches);
+}
+
+// Free set upkeep of each step (head cell taken, tail released) and a food pick per step
+static void benchFree(void) {
+    static SimState before;
+    static BenchFreeList list;
+    static FreeMap map;
+    u32 refTicks = 0, newTicks = 0, refPickTicks = 0, newPickTicks = 0;
+    u16 mismatches = 0;
+    u16 steps = 0;                        // Steps that kept the level (the others rebuild both sets)
+    BenchFreeOp ops[4];
+    simInitGame(&benchGame, BENCH_SEED);
+    benchFreeCells(&benchGame, &list, &map);
+    for (u16 step = 0; step < BENCH_STEPS; step++) {
+        const u16 rank = (step * 7) % list.count;
+        Point p;
+        u32 start = getSubTick();
+        for (u16 r = 0; r < BENCH_REPEAT; r++) {
+            p = list.tiles[rank];
+            benchSink += p.x;
+        }
+        refPickTicks += getSubTick() - start;
+        start = getSubTick();
+        for (u16 r = 0; r < BENCH_REPEAT; r++) {
+            simFreeMapSelect(&map, rank, &p);
+            benchSink += p.x;
+        }
+        newPickTicks += getSubTick() - start;
+
+        before = benchGame;
+        const u16 events = simStep(&benchGame, aiChooseMove(&benchGame, &aiDefaultWeights));
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN | SIM_EVENT_LEVEL_UP)) {
+            mismatches += !benchFreeSame(&list, &map);
+            if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&benchGame);
+            else simInitGame(&benchGame, benchGame.seed + 1);
+            benchFreeCells(&benchGame, &list, &map);
+            continue;
+        }
+        const u16 n = benchFreeOps(&before, &benchGame, events, ops);
+        start = getSubTick();
+        for (u16 i = 0; i < n; i++) {
+            if (ops[i].remove) benchRefFreeRemove(&list, ops[i].p);
+            else benchRefFreeAdd(&list, ops[i].p);
+        }
+        refTicks += getSubTick() - start;
+        start = getSubTick();
+        for (u16 i = 0; i < n; i++) {
+            if (ops[i].remove) simFreeMapRemove(&map, ops[i].p.x, ops[i].p.y);
+            else simFreeMapAdd(&map, ops[i].p.x, ops[i].p.y);
+        }
+        newTicks += getSubTick() - start;
+        steps++;
+    }
+    mismatches += !benchFreeSame(&list, &map);
+    benchReport("FREE STEP", refTicks, newTicks, steps, mismatches);
+    benchReport("FREE PICK", refPickTicks, newPickTicks, (u32)BENCH_STEPS * BENCH_REPEAT, 0);
+}
+
+#if SIM_FOOD_REGIONS
+// Steps of a reachable policy game: simStep() with its region upkeep vs the same step without it plus a
+// search from the head per food. Per food, as that is what the search costs; each new food is checked
+// against a search on the state it was placed in
+static void benchEat(void) {
+    static SimState ref;
+    static u8 reached[GRID_WIDTH * GRID_HEIGHT];
+    u32 refTicks = 0, newTicks = 0;
+    u16 mismatches = 0;
+    u16 foods = 0;
+    Point food;
+    simInitGameEx(&benchGame, BENCH_SEED, SIM_FOOD_REACHABLE);
+    for (u16 step = 0; step < BENCH_STEPS; step++) {
+        const u16 dir = aiChooseMove(&benchGame, &aiDefaultWeights);
+        ref = benchGame;
+        ref.foodPolicy = SIM_FOOD_UNIFORM;
+        u32 start = getSubTick();
+        const u16 refEvents = simStep(&ref, dir);
+        if ((refEvents & SIM_EVENT_ATE) && !(refEvents & (SIM_EVENT_LEVEL_UP | SIM_EVENT_WIN))) {
+            benchSink += benchRefPlaceFood(&ref, step, reached, &food);
+        }
+        refTicks += getSubTick() - start;
+        start = getSubTick();
+        const u16 events = simStep(&benchGame, dir);
+        newTicks += getSubTick() - start;
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) {
+            simInitGameEx(&benchGame, benchGame.seed + 1, SIM_FOOD_REACHABLE);
+        } else if (events & SIM_EVENT_LEVEL_UP) {
+            simInitLevel(&benchGame);
+        } else if ((events & (SIM_EVENT_ATE | SIM_EVENT_FOOD)) && benchGame.food.y) { // Not held back
+            benchRefPlaceFood(&benchGame, 0, reached, &food);
+            mismatches += !reached[benchGame.food.y * GRID_WIDTH + benchGame.food.x];
+        }
+        if ((events & SIM_EVENT_ATE) && !(events & (SIM_EVENT_LEVEL_UP | SIM_EVENT_WIN))) foods++;
+    }
+    benchReport("EAT", refTicks, newTicks, foods ? foods : 1, mismatches);
+}
+#endif
+
+#if SIM_ASM
+typedef void (*FillFn)(u8* dst, u8 value, u16 count);
+typedef u16 (*BodyHitFn)(const Point* body, u16 count, s16 x, s16 y);
+typedef void (*SelectFn)(const FreeMap* m, u16 rank, Point* p);
+typedef void (*FillWordsFn)(u16* dst, u16 value, u16 count);
+typedef void (*StampFn)(u16* dst, u16 value, u16 length, u16 stride);
+
+static u8 benchGrid[2][GRID_WIDTH * GRID_HEIGHT] SIM_WORD_ALIGNED; // C and assembly results
+static u16 benchMap[2][GRID_HEIGHT][GRID_WIDTH];
+
+static u32 timeFill(FillFn fn, u8* grid, u8 value) {
+    const u32 start = getSubTick();
+    for (u16 r = 0; r < BENCH_REPEAT; r++) fn(grid, value, GRID_WIDTH * GRID_HEIGHT);
+    return getSubTick() - start;
+}
+
+static u32 timeBodyHit(BodyHitFn fn, const Point* cells) {
+    const u32 start = getSubTick();
+    for (u16 r = 0; r < BENCH_REPEAT; r++) {
+        for (u16 i = 0; i < 4; i++) {
+            benchSink += fn(&benchGame.snakeBody[1], benchGame.snakeLength - 1, cells[i].x, cells[i].y);
+        }
+    }
+    return getSubTick() - start;
+}
+
+// Stamps the current level as initLevel() does: sand, border runs, wall runs
+static u32 timeStamp(FillWordsFn fill, StampFn stamp, u16 (*map)[GRID_WIDTH]) {
+    const u32 start = getSubTick();
+    fill(map[1], 1, GRID_WIDTH * (GRID_HEIGHT - 1));
+    stamp(map[1], 2, GRID_WIDTH, 1);
+    stamp(map[GRID_HEIGHT - 1], 2, GRID_WIDTH, 1);
+    stamp(&map[2][0], 2, GRID_HEIGHT - 3, GRID_WIDTH);
+    stamp(&map[2][GRID_WIDTH - 1], 2, GRID_HEIGHT - 3, GRID_WIDTH);
+    for (u16 i = 0; i < benchGame.wallSegmentCount; i++) {
+        const WallSegment* w = &benchGame.mazeWalls[i];
+        for (u16 k = 0, n; (n = simWallRun(w, &k)) != 0; k += n) {
+            stamp(&map[WALL_TILE_Y(w, k)][WALL_TILE_X(w, k)], 2, n, WALL_IS_VERTICAL(w) ? GRID_WIDTH : 1);
+        }
+    }
+    return getSubTick() - start;
+}
+
+static u32 timeSelect(SelectFn fn, const FreeMap* m, u16 count, Point* p) {
+    const u32 start = getSubTick();
+    for (u16 rank = 0; rank < count; rank += 7) fn(m, rank, &p[rank / 7]);
+    return getSubTick() - start;
+}
+
+// SIM_ASM kernels (sim_asm.s) against the C versions they replace, on the same states and inputs
+static void benchAsm(void) {
+    static BenchFreeList list;
+    static FreeMap map;
+    static Point picks[2][(MAX_FREE_TILES + NUM_PORTALS * 2 + 6) / 7];
+    u16 mismatches = 0;
+    Point cells[4];
+
+    // Grid clear of every flood fill and AI decision
+    u32 refTicks = timeFill(simFillBytesC, benchGrid[0], 0x5A);
+    u32 newTicks = timeFill(simFillBytes, benchGrid[1], 0x5A);
+    for (u16 i = 0; i < GRID_WIDTH * GRID_HEIGHT; i++) mismatches += benchGrid[0][i] != benchGrid[1][i];
+    benchReport("ASM FILL", refTicks, newTicks, BENCH_REPEAT, mismatches);
+
+    // Body scan of simIsBlocked() for the four moves out of the head
+    refTicks = newTicks = 0;
+    mismatches = 0;
+    simInitGame(&benchGame, BENCH_SEED);
+    for (u16 step = 0; step < BENCH_STEPS; step++) {
+        for (u16 dir = 0; dir < 4; dir++) {
+            simNextHead(&benchGame, dir, &cells[dir]);
+            mismatches += simBodyHitC(&benchGame.snakeBody[1], benchGame.snakeLength - 1, cells[dir].x, cells[dir].y) !=
+                          simBodyHit(&benchGame.snakeBody[1], benchGame.snakeLength - 1, cells[dir].x, cells[dir].y);
+        }
+        refTicks += timeBodyHit(simBodyHitC, cells);
+        newTicks += timeBodyHit(simBodyHit, cells);
+        benchAdvance();
+    }
+    benchReport("ASM BODY", refTicks, newTicks, (u32)BENCH_STEPS * 4 * BENCH_REPEAT, mismatches);
+
+    // Playfield tilemap and food picks of the first levels
+    u32 refPickTicks = 0, newPickTicks = 0, picksDone = 0;
+    u16 pickMismatches = 0;
+    refTicks = newTicks = 0;
+    mismatches = 0;
+    simInitGame(&benchGame, BENCH_SEED);
+    for (u16 level = 0; level < BENCH_REPEAT; level++) {
+        refTicks += timeStamp(simFillWordsC, simStampRunC, benchMap[0]);
+        newTicks += timeStamp(simFillWords, simStampRun, benchMap[1]);
+        for (u16 y = 1; y < GRID_HEIGHT; y++) {
+            for (u16 x = 0; x < GRID_WIDTH; x++) mismatches += benchMap[0][y][x] != benchMap[1][y][x];
+        }
+        benchFreeCells(&benchGame, &list, &map);
+        refPickTicks += timeSelect(simFreeMapSelectC, &map, list.count, picks[0]);
+        newPickTicks += timeSelect(simFreeMapSelect, &map, list.count, picks[1]);
+        for (u16 i = 0; i < (list.count + 6) / 7; i++) {
+            pickMismatches += picks[0][i].x != picks[1][i].x || picks[0][i].y != picks[1][i].y;
+        }
+        picksDone += (list.count + 6) / 7;
+        simInitGame(&benchGame, benchGame.seed + 1);
+    }
+    benchReport("ASM STAMP", refTicks, newTicks, BENCH_REPEAT, mismatches);
+    benchReport("ASM PICK", refPickTicks, newPickTicks, picksDone, pickMismatches);
+}
+#endif
+
+void benchRun(void) {
+    VDP_drawText("BENCHMARK (CYCLES PER OP)", 1, 1);
+    benchRow = 3;
+    benchCollision();
+    benchFree();
+#if SIM_FOOD_REGIONS
+    benchEat();
+#else
+    VDP_drawText("EAT OFF (SIM_FOOD_REGIONS=0)", 1, benchRow++);
+#endif
+#if SIM_ASM
+    benchAsm();
+#else
+    VDP_drawText("ASM KERNELS OFF (SIM_ASM=0)", 1, benchRow++);
+#endif
+    VDP_drawText("DONE", 1, benchRow + 1);
+    while (TRUE) SYS_doVBlankProcess();
+}
+#endif
@@ -0,0 +1,44 @@
+// Hot-path benchmarks shared by the ROM benchmark screen (BENCH=1 in main.c) and tools/simbench
+//
+// Overview:
+// When a hot path of the sim core is rewritten, the straightforward version it replaced is kept here
+// as a reference. Both benchmarks time the two versions on the same game states and check that they
+// agree, so every speedup claim has a matching correctness check on the host and on the 68000.
+//
+// Cases:
+// - collision: simIsBlocked() (indexed wall runs, body bounding box) vs a linear scan of body and wall tiles
+// - free_step, free_pick: the SIM_FREE_BITMAP free cell bitmap vs the freeTiles[] list, for the per-step
+//   update (head cell taken, tail cell released) and for picking the food cell of a given rank
+// - eat: reachable food placement (SIM_FOOD_REGIONS), a search from the head per food vs the region
+//   labels simStep() keeps up to date; timed as whole steps per food, since the upkeep runs every step
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "sim.h"
+
+typedef struct {
+    Point tiles[MAX_FREE_TILES + NUM_PORTALS * 2];
+    u16 count;
+} BenchFreeList;                          // Reference: the default build's free tile list
+
+typedef struct {
+    Point p;
+    u16 remove;                           // TRUE: p is taken, FALSE: p is released
+} BenchFreeOp;
+
+u16 benchRefIsBlocked(const SimState* s, s16 x, s16 y); // Reference: border, full body scan, full wall scan
+void benchRefFreeAdd(BenchFreeList* l, Point p);     // Reference: append
+void benchRefFreeRemove(BenchFreeList* l, Point p);  // Reference: linear search, swap with the last tile
+void benchFreeCells(const SimState* s, BenchFreeList* l, FreeMap* m); // Both sets from a state's cells
+u16 benchFreeSame(const BenchFreeList* l, const FreeMap* m);         // TRUE if both hold the same cells
+u16 benchFreeOps(const SimState* before, const SimState* after, u16 events, BenchFreeOp* ops); // Up to 4 ops
+#if SIM_FOOD_REGIONS
+u16 benchRefPlaceFood(const SimState* s, u16 draw, u8* reached, Point* food); // Reference: candidates, 0: none
+#endif
+
+#ifndef SIM_HOST
+void benchRun(void);                      // ROM benchmark screen: runs every case, prints the results, never returns
+#endif
+
+#endif // _BENCH_H_
@@ -0,0 +1,46 @@
+// Position heatmaps (see heatmap.h)
+
+#include "heatmap.h"
+
+void heatmapClear(Heatmap* h) {
+    for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+        h->visits[i] = 0;
+        h->deaths[i] = 0;
+    }
+}
+
+void heatmapDeath(Heatmap* h, const SimState* s, u16 dir) {
+    Point p;
+    simNextHead(s, dir, &p);              // simStep() leaves the snake in place on a fatal move
+    h->deaths[HEATMAP_CELL(p)]++;
+}
+
+#ifndef SIM_HOST
+// Adds value to a saturating SRAM counter
+static void sramAdd(u32 offset, u16 value) {
+    const u32 sum = (u32)SRAM_readWord(offset) + value;
+    SRAM_writeWord(offset, sum > 0xFFFF ? 0xFFFF : sum);
+}
+
+void heatmapPrepare(void) {
+    SRAM_enable();
+    if (SRAM_readLong(HEATMAP_SRAM_BASE) != HEATMAP_MAGIC || SRAM_readByte(HEATMAP_SRAM_BASE + 4) != HEATMAP_VERSION) {
+        for (u32 i = 0; i < HEATMAP_SRAM_SIZE; i += 4) SRAM_writeLong(HEATMAP_SRAM_BASE + i, 0); // Blank or stale SRAM
+        SRAM_writeLong(HEATMAP_SRAM_BASE, HEATMAP_MAGIC);
+        SRAM_writeByte(HEATMAP_SRAM_BASE + 4, HEATMAP_VERSION);
+    }
+    SRAM_disable();
+}
+
+void heatmapFlush(Heatmap* h, u16 level) {
+    const u16 bucket = (level < HEATMAP_LEVELS ? level : HEATMAP_LEVELS) - 1;
+    const u32 base = HEATMAP_SRAM_BASE + HEATMAP_SRAM_HEADER + (u32)bucket * HEATMAP_BUCKET_SIZE;
+    SRAM_enable();
+    for (u16 i = 0; i < HEATMAP_CELLS; i++) { // Only touched cells cost SRAM cycles
+        if (h->visits[i]) sramAdd(base + i * 2, h->visits[i]);
+        if (h->deaths[i]) sramAdd(base + HEATMAP_CELLS * 2 + i * 2, h->deaths[i]);
+    }
+    SRAM_disable();
+    heatmapClear(h);
+}
+#endif
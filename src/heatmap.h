@@ -0,0 +1,55 @@
+// Position heatmaps: per-cell visit and death counters for balance analysis
+//
+// Overview:
+// A Heatmap holds one u16 counter per grid cell for head visits and one for deaths. Recording is one
+// increment per logic step (HEATMAP_VISIT), so it can run in every game. Counters cover one level at a
+// time: the owner folds them into its long-term totals at each level end and clears them, which keeps
+// u16 enough (a level would need 65536 steps on one cell to wrap).
+//
+// A death is counted on the cell the head was about to enter (wall, border tile or body segment), so
+// death maps show the obstacles that kill, not the cell before them.
+//
+// ROM (optional, HEATMAP_SRAM=1 in main.c): level totals are added into cartridge SRAM after the
+// replay area, so they accumulate over every game played on the cartridge. SRAM layout (byte offsets
+// as used by SGDK's SRAM_* functions, multi-byte values big-endian):
+//   HEATMAP_SRAM_BASE + 0    u32 HEATMAP_MAGIC
+//   HEATMAP_SRAM_BASE + 4    u8  HEATMAP_VERSION
+//   HEATMAP_SRAM_BASE + 16   HEATMAP_LEVELS buckets of HEATMAP_BUCKET_SIZE bytes: u16 visits[cells]
+//                            then u16 deaths[cells]; level n goes to bucket n - 1, the last bucket
+//                            collects every level from HEATMAP_LEVELS on. Counters saturate at 65535.
+// heatmapPrepare() validates the header once per game and blanks the whole area if it is missing or
+// stale (about 27KB of SRAM writes), so heatmapFlush() inside a game step only writes touched cells.
+//
+// Host side: tools/heatmap accumulates games or SRAM dumps and renders one image per level.
+
+#ifndef _HEATMAP_H_
+#define _HEATMAP_H_
+
+#include "sim.h"
+
+#define HEATMAP_CELLS (GRID_WIDTH * GRID_HEIGHT)
+#define HEATMAP_MAGIC 0x48454154 // "HEAT"
+#define HEATMAP_VERSION 1
+#define HEATMAP_SRAM_BASE 0x8000 // Right after the replay area (see replay.h)
+#define HEATMAP_SRAM_HEADER 16
+#define HEATMAP_LEVELS 6       // SRAM buckets (levels 1..5, then 6 and up)
+#define HEATMAP_BUCKET_SIZE (HEATMAP_CELLS * 4)
+#define HEATMAP_SRAM_SIZE (HEATMAP_SRAM_HEADER + HEATMAP_LEVELS * HEATMAP_BUCKET_SIZE)
+
+typedef struct {
+    u16 visits[HEATMAP_CELLS]; // Steps that ended with the head on the cell
+    u16 deaths[HEATMAP_CELLS]; // Deaths caused by entering the cell
+} Heatmap;
+
+#define HEATMAP_CELL(p) ((p).y * GRID_WIDTH + (p).x)
+#define HEATMAP_VISIT(h, s) ((h)->visits[HEATMAP_CELL((s)->snakeBody[0])]++) // Call after a surviving step
+
+void heatmapClear(Heatmap* h);
+void heatmapDeath(Heatmap* h, const SimState* s, u16 dir); // Call after simStep(s, dir) reported a death
+
+#ifndef SIM_HOST
+void heatmapPrepare(void);                // Blanks stale SRAM totals; call at game start, never mid-game
+void heatmapFlush(Heatmap* h, u16 level); // Adds the counters to the level's SRAM bucket and clears them
+#endif
+
+#endif // _HEATMAP_H_
@@ -18,38 +18,96 @@
 //    - Playfield: Sand tile background, wall tiles for borders/maze, sand tiles as portals.
 //    - Text: Dark green (PAL0 index 15) for score, level info, intro, pause, and game-over screens.
 // 4. Audio: Chiptune melody with capped tempo, intro tune, "chomp" sound, game-over tune, level-up jingle, toggleable.
-// 5. Controls: Start toggles states/pauses; D-pad moves snake; B toggles music in intro.
+// 5. Controls: Start toggles states/pauses; D-pad moves snake; B toggles music in intro; A/C start an AI/NN demo game.
+//
+// Rendering:
+// During play the logic step never draws. It fills a RenderSnapshot (head, the one body sprite that
+// moved, food, HUD text) in the back half of a double buffer and publishes it; the V-int handler applies
+// the published snapshot at the start of the next vertical blank and uploads the sprite table right away.
+// The display therefore changes on a fixed frame even when a step (AI search) overruns the frame, and
+// the step can use the whole active display period. Body sprites form a ring: each step moves only the
+// tail sprite to the neck cell (or adds a new one on growth) instead of repositioning every segment.
+// Rule: between renderPublish() and the next SYS_doVBlankProcess() the main loop leaves the VDP and the
+// sprite engine alone, so the handler never interrupts another VDP access.
+//
+// Main loop:
+// Each state is a row of stateTable[] (enter, update, exit). The loop reads the joypad once per frame and
+// then runs one tick of the current state's update per elapsed V-int (fixed timestep), catching up on
+// frames lost to a long step. No state blocks: timers count ticks since the state was entered, so the
+// game over sequence, the chomp sound and the level transition all advance one tick at a time.
+// STATE_PROFILE=1 measures each state's per-tick cost.
+//
+// Boot:
+// main() only sets up what the intro needs, so the title text shows on the first frames. The sprite
+// engine and the state hash keys start with the first game (game tiles already load with the level), and the
+// intro image streams in behind the text over a few ticks under a black palette, then fades in.
+// STATE_PROFILE=1 also logs the frames from boot to the first intro frame and to the complete image.
 
 #include <genesis.h>
 #include "resource.h"
+#include "sim.h"
+#include "ai.h"
+#include "nn.h"
+#include "replay.h"
+#include "heatmap.h"
+#include "bench.h"
 
-// Game constants
-#define GRID_WIDTH 40          // Total grid width in tiles (including borders)
-#define GRID_HEIGHT 28         // Total grid height in tiles (including borders)
-#define SNAKE_START_X 20       // Snake head’s starting X position
-#define SNAKE_START_Y 14       // Snake head’s starting Y position
-#define SNAKE_START_LENGTH 3   // Initial snake length
-#define SNAKE_MAX_LENGTH 80    // Maximum snake length (limited by VDP sprite capacity: 80 sprites)
+// Game constants (grid, snake and maze constants live in sim.h)
 #define INITIAL_DELAY 8        // Initial frame delay between updates (slower speed)
 #define MIN_DELAY 3            // Minimum frame delay (faster speed as score increases)
 #define SNAKE_TILE_SIZE 8      // Sprite tile size (8x8 pixels)
 #define MAX_TEMPO_FACTOR 6     // Minimum tempo factor to cap music speed
-#define MAX_WALLS 50           // Maximum number of maze wall segments (each up to 5 tiles)
-#define MAX_FREE_TILES ((GRID_WIDTH - 2) * (GRID_HEIGHT - 3)) // Max free tiles: 38x25 = 950
-#define NUM_PORTALS 2          // Number of portal pairs (top-bottom, left-right)
 #define TRANSITION_DURATION 90 // Transition display time (~1.5s at 60 FPS, adjustable)
+#define INTRO_TILES_PER_TICK 96 // Intro image tiles queued per tick (3KB of V-blank DMA)
+#define INTRO_ROWS_PER_TICK 4  // Intro tilemap rows written per tick, once the tiles are in VRAM
+#define INTRO_ROWS 28          // Intro image height in tiles (full screen)
+#define INTRO_FADE_FRAMES 20   // Intro palette fade-in once the image is complete
 
-// Snake directions (correspond to head sprite frames)
-#define DIR_UP 0               // Up direction (frame 2)
-#define DIR_RIGHT 1            // Right direction (frame 1)
-#define DIR_DOWN 2             // Down direction (frame 0)
-#define DIR_LEFT 3             // Left direction (frame 3)
+// Debug options (override with -D on the command line)
+#ifndef DEBUG_OVERLAY
+#define DEBUG_OVERLAY 0        // 1 = show the per-step state hash on the HUD
+#endif
+#ifndef DEBUG_TRACE
+#define DEBUG_TRACE 0          // 1 = log "<hash> <step>" after each step to the emulator debug console
+#endif
+#ifndef BENCH
+#define BENCH 0                // 1 = boot into the hot-path benchmark screen (bench.c) instead of the game
+#endif
+#ifndef HEATMAP_SRAM
+#define HEATMAP_SRAM 0         // 1 = accumulate per-level visit/death heatmaps in SRAM (4.4KB of RAM)
+#endif
+#ifndef FOOD_POLICY
+#define FOOD_POLICY SIM_FOOD_UNIFORM // SIM_FOOD_* food placement (recorded in the replay header)
+#endif
+#if FOOD_POLICY != SIM_FOOD_UNIFORM && !SIM_FOOD_REGIONS
+#error "FOOD_POLICY needs SIM_FOOD_REGIONS: pass FOOD_POLICY=1 or 2 on the compiler command line"
+#endif
+#ifndef STATE_PROFILE
+#define STATE_PROFILE 0        // 1 = measure each state's per-tick cost, logged (KLog) when the state exits
+#endif
 
 // Game states
 #define STATE_INTRO 0          // Intro screen state
 #define STATE_PLAYING 1        // Active gameplay state
 #define STATE_GAMEOVER 2       // Game over state
 #define STATE_LEVEL_TRANSITION 3 // Level transition state
+#define STATE_WIN 4            // Board full: the snake stays on screen until Start
+#define STATE_COUNT 5
+
+// Scheduler constants (1 tick = 1 frame)
+#define MAX_CATCHUP_TICKS 2    // Ticks run in one frame at most after a long step
+#define GAMEOVER_PAUSE 12      // Ticks before the snake starts to vanish (~200 ms)
+#define GAMEOVER_VANISH 3      // Ticks between two vanishing sprites (~50 ms)
+#define CHOMP_TICKS 3          // Chomp sound: 1 tick high, 2 ticks low
+#define CYCLES_PER_SUBTICK 100 // 7.67 MHz / 76800 subticks per second (NTSC)
+
+#define DIR_NONE 0xFF          // padDirection[] value: no direction pressed
+#define PAD_MASK (BUTTON_UP | BUTTON_DOWN | BUTTON_LEFT | BUTTON_RIGHT) // The 4 low joypad bits
+
+// Demo modes (who steers instead of the joypad)
+#define DEMO_OFF 0             // Player steers
+#define DEMO_AI 1              // Heuristic search AI (ai.c)
+#define DEMO_NN 2              // Quantized neural network policy (nn.c)
 
 // Music constants (PSG frequencies)
 #define NOTE_C4  262           // C4 (~262 Hz)
@@ -69,69 +127,115 @@
 #define LEVEL_UP_SIZE 4        // Length of level-up jingle
 #define GAMEOVER_SIZE 5        // Length of gameover tune
 
-// Data structures
-typedef struct {
-    s16 x;                     // X position in tiles
-    s16 y;                     // Y position in tiles
-} Point;
+// Render snapshot parts (RenderSnapshot.flags)
+#define RENDER_FOOD 0x01       // Food sprite moved
+#define RENDER_HUD 0x02        // Score digits and level progress changed
+
+#define BODY_RING_SIZE (SNAKE_MAX_LENGTH - 1)
+#define BODY_SPRITE(i) bodyRing[(bodyRingStart + (i) - 1) % BODY_RING_SIZE] // Sprite of body segment i (1 = neck)
 
+// Data structures
 typedef struct {
     u16 frequency;             // PSG frequency in Hz
     u16 baseDuration;          // Base duration in frames
 } Note;
 
 typedef struct {
-    Point entry;               // Entry portal position
-    Point exit;                // Exit portal position
-} Portal;
+    u16 flags;                 // RENDER_* parts to apply besides the head
+    s16 headX, headY;          // Head sprite position in pixels
+    u16 headFrame;             // Head frame (0 down, 1 right, 2 up, 3 left)
+    Sprite* neck;              // Body sprite that moved to the old head cell (NULL: none)
+    s16 neckX, neckY;
+    u16 neckFrame;             // Body frame (0 horizontal, 1 vertical)
+    s16 foodX, foodY;
+    char scoreDigits[6];       // Score ("%4d"), drawn after "SCORE: "
+    char levelText[25];        // "LEVEL n: eaten/target", right-aligned
+} RenderSnapshot;
+
+typedef struct {
+    void (*enter)(void);       // Called when the state is entered (NULL: nothing to do)
+    void (*update)(void);      // Called once per tick while the state is current
+    void (*exit)(void);        // Called when the state is left (NULL: nothing to do)
+    const char* name;          // STATE_PROFILE log label
+} StateHandlers;
+
+typedef struct {
+    u32 ticks;                 // Ticks measured since the state was entered
+    u32 subTicks;              // Total update time
+    u32 maxSubTicks;           // Slowest tick
+} StateProfile;
 
 // Game state variables
-static Point snakeBody[SNAKE_MAX_LENGTH]; // Snake segments (head at index 0)
-static u16 snakeLength;                   // Current length of the snake
-static u16 direction;                     // Current movement direction
+static SimState game;                     // Snake, maze, food, score and level (simulation core)
 static u16 nextDirection;                 // Buffered next direction from input
-static Point food;                        // Current food position
-static u16 score;                         // Player score
-static u16 gameState;                     // Current game state
+static u16 gameState;                     // Current game state (STATE_*)
+static u16 stateTicks;                    // Ticks since the current state was entered
 static u16 frameDelay;                    // Frames between snake updates
 static u16 frameCount;                    // Frame counter for timing updates
 static u16 paused;                        // Pause flag (TRUE/FALSE)
 static u16 prevStartState;                // Previous Start button state for edge detection
-static u16 introAnimFrame;                // Frame counter for intro animation
 static u16 musicEnabled = TRUE;           // Music toggle state (TRUE = on)
-static Point mazeWalls[MAX_WALLS * 5];    // Maze wall positions (up to 50 segments, 5 tiles each)
-static u16 wallCount;                     // Total number of maze wall tiles
-static Point freeTiles[MAX_FREE_TILES];   // List of free tile positions for food placement
-static u16 freeTileCount;                 // Number of free tiles available
-static Portal portals[NUM_PORTALS];       // Array of portal pairs
-static u16 currentLevel = 1;              // Current level number (starts at 1)
-static u16 foodEatenThisLevel = 0;        // Food eaten in the current level
-static u16 foodTarget = 5;                // Target food count for current level
-static u16 transitionTimer = 0;           // Frames remaining for level transition
+static u16 demoMode = DEMO_OFF;           // DEMO_*: who steers the snake
+static u16 causeCount[SIM_CAUSE_COUNT];   // Telemetry: game ends (and refused growths) per SIM_CAUSE_* since power-on
+static u16 gameReady;                     // SPR_init() and simInitKeys() done (deferred to the first game)
+static u16 introTilesLoaded;              // Intro image tiles in VRAM so far (they stay there during games)
+static u16 introRowsDrawn;                // Intro tilemap rows drawn since the intro was entered
+#if STATE_PROFILE
+static u16 bootLogged;                    // Boot time already logged
+#endif
+#if HEATMAP_SRAM
+static Heatmap heatmap;                   // Current level's counters (flushed to SRAM at level end)
+#endif
+
+// Palettes: PAL0 for gameplay and text (black intro background at first), PAL1 for the intro image
+static const u16 gamePalette[16] = {
+    RGB24_TO_VDPCOLOR(0x000000),          // Black (intro background)
+    RGB24_TO_VDPCOLOR(0x008000),          // Dark Green (snake)
+    RGB24_TO_VDPCOLOR(0xFF0000),          // Red (food)
+    RGB24_TO_VDPCOLOR(0xC0C0C0),          // Grey (unused)
+    RGB24_TO_VDPCOLOR(0x800000),          // Dark Red (unused)
+    RGB24_TO_VDPCOLOR(0x000080),          // Dark Blue (unused)
+    RGB24_TO_VDPCOLOR(0x00A000),          // Medium Green (unused)
+    RGB24_TO_VDPCOLOR(0xDEB887),          // Sand (gameplay base)
+    RGB24_TO_VDPCOLOR(0xA52A2A),          // Brown (wall base)
+    RGB24_TO_VDPCOLOR(0xFFD700),          // Gold (unused)
+    RGB24_TO_VDPCOLOR(0xCD7F32),          // Bronze (unused)
+    RGB24_TO_VDPCOLOR(0xFFFFAA),          // Pale Yellow (unused)
+    RGB24_TO_VDPCOLOR(0xD2B48C),          // Light Brown (unused)
+    RGB24_TO_VDPCOLOR(0xF5DEB3),          // Tan (unused)
+    RGB24_TO_VDPCOLOR(0xFFFF00),          // Yellow (unused)
+    RGB24_TO_VDPCOLOR(0x008000)           // Dark Green (text)
+};
+static const u16 introPalette[16] = {
+    RGB24_TO_VDPCOLOR(0x000083), RGB24_TO_VDPCOLOR(0x260081), RGB24_TO_VDPCOLOR(0x3e1179), RGB24_TO_VDPCOLOR(0x641a69),
+    RGB24_TO_VDPCOLOR(0xfe0000), RGB24_TO_VDPCOLOR(0x3b329c), RGB24_TO_VDPCOLOR(0xa12c28), RGB24_TO_VDPCOLOR(0x1f5ba7),
+    RGB24_TO_VDPCOLOR(0x027a00), RGB24_TO_VDPCOLOR(0x1a9a0f), RGB24_TO_VDPCOLOR(0xce7e33), RGB24_TO_VDPCOLOR(0xd8b228),
+    RGB24_TO_VDPCOLOR(0xd0b18f), RGB24_TO_VDPCOLOR(0xe0b889), RGB24_TO_VDPCOLOR(0xfdd800), RGB24_TO_VDPCOLOR(0xf6ddb4)
+};
 
 // Music state variables
-static Note melody[MELODY_SIZE] = {       // Main gameplay melody
+static const Note melody[MELODY_SIZE] = { // Main gameplay melody
     {NOTE_C4, 8}, {NOTE_E4, 8}, {NOTE_G4, 8}, {NOTE_C5, 16},
     {NOTE_G4, 8}, {NOTE_E4, 8}, {NOTE_C5, 16}, {NOTE_REST, 8},
     {NOTE_A4, 8}, {NOTE_G4, 8}, {NOTE_E4, 8}, {NOTE_G4, 16},
     {NOTE_E4, 8}, {NOTE_G4, 8}, {NOTE_A4, 8}, {NOTE_G4, 16}
 };
-static Note bass[BASS_SIZE] = {           // Bassline accompaniment
+static const Note bass[BASS_SIZE] = { // Bassline accompaniment
     {NOTE_C4, 16}, {NOTE_G4/2, 16},
     {NOTE_C4, 16}, {NOTE_G4/2, 16},
     {NOTE_A4/2, 16}, {NOTE_E4/2, 16},
     {NOTE_F4/2, 16}, {NOTE_G4/2, 16}
 };
-static Note levelUpJingle[LEVEL_UP_SIZE] = { // Level-up jingle (rising scale)
+static const Note levelUpJingle[LEVEL_UP_SIZE] = { // Level-up jingle (rising scale)
     {NOTE_C4, 6}, {NOTE_E4, 6}, {NOTE_G4, 6}, {NOTE_C5, 12}
 };
-static Note introMelody[MELODY_SIZE] = {    // Intro melody
+static const Note introMelody[MELODY_SIZE] = { // Intro melody
     {NOTE_E4, 8}, {NOTE_G4, 8}, {NOTE_A4, 8}, {NOTE_G4, 8},
     {NOTE_E4, 8}, {NOTE_G4, 8}, {NOTE_A4, 12}, {NOTE_REST, 8},
     {NOTE_G4, 8}, {NOTE_E4, 8}, {NOTE_G4, 8}, {NOTE_A4, 8},
     {NOTE_G4, 8}, {NOTE_E4, 8}, {NOTE_A4, 12}, {NOTE_REST, 8}
 };
-static Note gameOverTune[GAMEOVER_SIZE] = {
+static const Note gameOverTune[GAMEOVER_SIZE] = {
     {NOTE_G4, 8}, {NOTE_E4, 8}, {NOTE_C4, 8}, {NOTE_G3, 12}, {NOTE_REST, 8}
 };
 static u16 melodyIndex = 0;               // Current melody note index
@@ -140,126 +244,124 @@ static u16 melodyCounter = 0;             // Frames remaining for current melody
 static u16 bassCounter = 0;               // Frames remaining for current bass note
 static u16 jingleIndex = 0;               // Current jingle note index
 static u16 jingleCounter = 0;             // Frames remaining for jingle note
+static u16 tuneIndex;                     // Current game-over tune note index
+static u16 tuneCounter;                   // Frames remaining for game-over tune note
+static u16 chompTicks;                    // Ticks left of the chomp sound (channel 0)
+static u16 vanishSegment;                 // Game over: next body segment to remove (0: head, then food)
+#if STATE_PROFILE
+static StateProfile stateProfile;         // Current state's cost since it was entered
+#endif
 
 // Sprite and tile objects
 static Sprite* spriteHead = NULL;         // Head sprite (4 animation frames)
-static Sprite* spriteBody[SNAKE_MAX_LENGTH - 1]; // Body sprites (2 frames: horizontal, vertical)
+static Sprite* bodyRing[BODY_RING_SIZE];  // Body sprites (2 frames: horizontal, vertical), see BODY_SPRITE()
+static u16 bodyRingStart;                 // bodyRing[] slot of the neck sprite
 static Sprite* spriteFood = NULL;         // Food sprite (single frame)
 static u16 headVramIndexes[4];            // VRAM tile indices for head frames
+
+// Direction tables indexed by DIR_* (cell steps and reversals are shared in sim.h)
+static const u8 headFrame[4] = { 2, 1, 0, 3 };           // Head sprite frame (sheet order: down, right, up, left)
+static const u16 dirButton[4] = { BUTTON_UP, BUTTON_RIGHT, BUTTON_DOWN, BUTTON_LEFT };
+static const u8 padDirection[16] = {      // D-pad bits (up 1, down 2, left 4, right 8) to the direction
+    DIR_NONE, DIR_UP, DIR_DOWN, DIR_UP,   // they steer; up wins over right, right over down, down over left
+    DIR_LEFT, DIR_UP, DIR_DOWN, DIR_UP,
+    DIR_RIGHT, DIR_UP, DIR_RIGHT, DIR_UP,
+    DIR_RIGHT, DIR_UP, DIR_RIGHT, DIR_UP
+};
 static u16 bodyVramIndexes[2];            // VRAM tile indices for body frames
 static u16 wallVramIndex;                 // VRAM index for wall tile
 static u16 sandVramIndex;                 // VRAM index for sand tile
+#if SIM_ASM
+static u16 playfield[GRID_HEIGHT][GRID_WIDTH]; // Plane A tiles of the level, stamped by the kernels (row 0 unused)
+#endif
+
+// Render double buffer (filled by the logic step, applied by the V-int handler)
+static RenderSnapshot renderBuffers[2];
+static volatile u16 renderBack;           // Buffer the logic step fills
+static volatile u16 renderPending;        // TRUE: renderBuffers[renderBack ^ 1] waits for the next V-int
 
 // Function prototypes
 static void initGame(void);               // Initializes game state and first level
-static void initLevel(void);              // Resets maze, portals, and food for a new level
-static void showIntroScreen(void);        // Displays intro screen with title
-static void updateIntroScreen(void);      // Updates intro screen animation
+static void initLevel(void);              // Draws maze and portals of the current level, sets up sprites
+static void setState(u16 state);          // Leaves the current state and enters another one
+static void enterIntro(void);             // Displays intro screen with title
+static void updateIntro(void);            // Updates intro screen animation
+static void exitIntro(void);              // Stops the intro fade
+static void streamIntro(void);            // Uploads the next part of the intro image
+static void updatePlaying(void);          // Steps the game every frameDelay ticks
+static void enterTransition(void);        // Shows "LEVEL X" and starts the level-up jingle
+static void updateTransition(void);       // Blinks "LEVEL X", then builds the level and resumes play
+static void exitTransition(void);         // Clears the "LEVEL X" text
+static void enterGameOver(void);          // Displays the game over text
+static void updateGameOver(void);         // Removes the snake sprite by sprite while the tune plays
+static void exitGameOver(void);           // Removes what is left of the snake, silences the tune (also win)
+static void enterWin(void);               // Displays the win text
 static void startGame(void);              // Transitions to gameplay state
 static void handleInput(void);            // Processes player input from joypad
 static void updateGame(void);             // Updates game logic (movement, collisions, levels)
-static void drawGame(void);               // Renders game sprites
-static void generateFood(void);           // Places new food using free tile list
-static u16 checkCollision(s16 x, s16 y);  // Checks collisions with snake body or walls
-static void showGameOver(void);           // Displays game over screen with animation
-static void playEatSound(void);           // Plays food-eating sound effect
+static RenderSnapshot* renderBegin(void); // Starts the next snapshot in the back buffer
+static void renderPublish(void);          // Hands the snapshot to the V-int handler
+static void renderVInt(void);             // V-int handler: applies the published snapshot
+static void playEatSound(void);           // Starts the food-eating sound effect
+static s16 foodSpriteY(void);             // Food sprite row, off screen while the food is held back
 static void togglePause(void);            // Toggles pause state with tile restoration
+static void restorePlayfield(u16 x, u16 y, u16 width); // Redraws a row part of the level over text
 static void updateMusic(void);            // Updates background music and jingle playback
-static void updateLevelDisplay(void);     // Updates level and food progress display
+static void formatHud(RenderSnapshot* r); // Formats the game's score digits and level progress
+static void drawHud(const RenderSnapshot* r); // Draws the score digits and level progress
+static void debugStep(void);              // Shows/logs the state hash after a logic step
+static void recordCause(u16 cause);       // Counts and traces a SIM_CAUSE_* event
+static void heatmapStep(u16 events);      // Records the step into the heatmap (compiled out unless enabled)
+#if STATE_PROFILE
+static void profileTick(u16 state, u32 subTicks); // Adds one tick's update time to the state profile
+#endif
+
+// State handlers; a new state is a STATE_* value and a row here
+static const StateHandlers stateTable[STATE_COUNT] = {
+    [STATE_INTRO]            = { enterIntro, updateIntro, exitIntro, "INTRO" },
+    [STATE_PLAYING]          = { NULL, updatePlaying, NULL, "PLAYING" },
+    [STATE_GAMEOVER]         = { enterGameOver, updateGameOver, exitGameOver, "GAMEOVER" },
+    [STATE_LEVEL_TRANSITION] = { enterTransition, updateTransition, exitTransition, "TRANSITION" },
+    [STATE_WIN]              = { enterWin, NULL, exitGameOver, "WIN" },
+};
 
 // Main function: Entry point and game loop
 int main() {
     JOY_init();                           // Initialize joypad input system
-    SPR_init();                           // Initialize sprite engine
-    
-    // Set up PAL0 for gameplay (black intro background initially)
-    PAL_setColor(0, RGB24_TO_VDPCOLOR(0x000000));  // Black (intro background)
-    PAL_setColor(1, RGB24_TO_VDPCOLOR(0x008000));  // Dark Green (snake)
-    PAL_setColor(2, RGB24_TO_VDPCOLOR(0xFF0000));  // Red (food)
-    PAL_setColor(3, RGB24_TO_VDPCOLOR(0xC0C0C0));  // Grey (unused)
-    PAL_setColor(4, RGB24_TO_VDPCOLOR(0x800000));  // Dark Red (unused)
-    PAL_setColor(5, RGB24_TO_VDPCOLOR(0x000080));  // Dark Blue (unused)
-    PAL_setColor(6, RGB24_TO_VDPCOLOR(0x00A000));  // Medium Green (unused)
-    PAL_setColor(7, RGB24_TO_VDPCOLOR(0xDEB887));  // Sand (gameplay base)
-    PAL_setColor(8, RGB24_TO_VDPCOLOR(0xA52A2A));  // Brown (wall base)
-    PAL_setColor(9, RGB24_TO_VDPCOLOR(0xFFD700));  // Gold (unused)
-    PAL_setColor(10, RGB24_TO_VDPCOLOR(0xCD7F32)); // Bronze (unused)
-    PAL_setColor(11, RGB24_TO_VDPCOLOR(0xFFFFAA)); // Pale Yellow (unused)
-    PAL_setColor(12, RGB24_TO_VDPCOLOR(0xD2B48C)); // Light Brown (unused)
-    PAL_setColor(13, RGB24_TO_VDPCOLOR(0xF5DEB3)); // Tan (unused)
-    PAL_setColor(14, RGB24_TO_VDPCOLOR(0xFFFF00)); // Yellow (unused)
-    PAL_setColor(15, RGB24_TO_VDPCOLOR(0x008000)); // Dark Green (text)
-    
-    // Set up PAL1 for intro screen
-    PAL_setColor(16, RGB24_TO_VDPCOLOR(0x000083));
-    PAL_setColor(17, RGB24_TO_VDPCOLOR(0x260081));
-    PAL_setColor(18, RGB24_TO_VDPCOLOR(0x3e1179));
-    PAL_setColor(19, RGB24_TO_VDPCOLOR(0x641a69));
-    PAL_setColor(20, RGB24_TO_VDPCOLOR(0xfe0000));
-    PAL_setColor(21, RGB24_TO_VDPCOLOR(0x3b329c));
-    PAL_setColor(22, RGB24_TO_VDPCOLOR(0xa12c28));
-    PAL_setColor(23, RGB24_TO_VDPCOLOR(0x1f5ba7));
-    PAL_setColor(24, RGB24_TO_VDPCOLOR(0x027a00));
-    PAL_setColor(25, RGB24_TO_VDPCOLOR(0x1a9a0f));
-    PAL_setColor(26, RGB24_TO_VDPCOLOR(0xce7e33));
-    PAL_setColor(27, RGB24_TO_VDPCOLOR(0xd8b228));
-    PAL_setColor(28, RGB24_TO_VDPCOLOR(0xd0b18f));
-    PAL_setColor(29, RGB24_TO_VDPCOLOR(0xe0b889));
-    PAL_setColor(30, RGB24_TO_VDPCOLOR(0xfdd800));
-    PAL_setColor(31, RGB24_TO_VDPCOLOR(0xf6ddb4));
+    SYS_setVIntCallback(renderVInt);      // Applies the snapshots published by the logic step
+    PAL_setColors(0, gamePalette, 16, CPU); // PAL1 is set by the intro
     
     VDP_setTextPalette(PAL0);         // Set text to use PAL0 (dark green at index 15)
     VDP_setTextPriority(1);           // Text renders above sprites and background
     PSG_reset();                      // Reset PSG audio channels
+#if BENCH
+    simInitKeys();                    // Build state hash keys
+    benchRun();                       // Never returns
+#endif
     
-    showIntroScreen();                // Display intro screen on startup
+    setState(STATE_INTRO);            // Display intro screen on startup
+    u32 lastVTimer = vtimer - 1;
     
     while (1) {                       // Infinite game loop
         handleInput();                // Process player input
-        if (gameState == STATE_INTRO) {
-            updateIntroScreen();      // Update intro animation
-            SPR_update();             // Update sprite engine
-        }
-        else if (gameState == STATE_PLAYING) {
-            frameCount++;
-            if (frameCount >= frameDelay && !paused) { // Update game logic at intervals
-                frameCount = 0;
-                updateGame();
-            }
-            drawGame();               // Render game state
-            SPR_update();             // Update sprites
-        }
-        else if (gameState == STATE_LEVEL_TRANSITION) { // Handle level transition
-            if (transitionTimer > 0) {
-                transitionTimer--;
-                // Blink "Level X" text (20 frames on, 20 frames off)
-                if ((transitionTimer % 40) < 20) {
-                    char levelText[8];
-                    sprintf(levelText, "LEVEL %d", currentLevel);
-                    VDP_drawText(levelText, 16, 12); // Centered-ish
-                } else {
-                    const u16 sandTileAttr = TILE_ATTR_FULL(PAL0, FALSE, FALSE, FALSE, sandVramIndex);
-                    VDP_clearText(16, 12, 8); // Clear max 8 chars
-                    for (u16 x = 16; x < 24; x++) {
-                        VDP_setTileMapXY(BG_A, sandTileAttr, x, 12);
-                    }
-                }
-                drawGame();           // Keep rendering snake and food
-                SPR_update();         // Update sprites
-            }
-            if (transitionTimer == 0) {
-                VDP_clearText(16, 12, 8); // Ensure text is cleared
-                const u16 sandTileAttr = TILE_ATTR_FULL(PAL0, FALSE, FALSE, FALSE, sandVramIndex);
-                for (u16 x = 16; x < 24; x++) {
-                    VDP_setTileMapXY(BG_A, sandTileAttr, x, 12);
-                }
-                if (currentLevel > 1) initLevel();          // Reset maze and portals
-                gameState = STATE_PLAYING; // Resume gameplay
-                jingleIndex = 0;      // Reset jingle for next transition
-                jingleCounter = 0;
-            }
+    
+        // Fixed timestep: one tick per V-int since the last pass, so a long step does not slow the game
+        // down. A tick that publishes a render snapshot ends the pass (no VDP access until the V-blank).
+        const u32 now = vtimer;
+        const u16 ticks = max(1, min(now - lastVTimer, MAX_CATCHUP_TICKS));
+        lastVTimer = now;
+        for (u16 tick = 0; tick < ticks && !renderPending; tick++) {
+            const u16 state = gameState;
+            stateTicks++;
+#if STATE_PROFILE
+            const u32 start = getSubTick();
+#endif
+            if (stateTable[state].update) stateTable[state].update();
+            updateMusic();            // Update music and jingle playback
+#if STATE_PROFILE
+            profileTick(state, getSubTick() - start);
+#endif
         }
-        updateMusic();                // Update music and jingle playback
         SYS_doVBlankProcess();        // Sync to V-blank (60 FPS)
     }
     
@@ -268,27 +370,33 @@ int main() {
 
 // Initializes game state and sets up the first level with a transition
 static void initGame(void) {
+    if (!gameReady) {                 // Deferred from boot: the intro has no sprites and no game state
+        SPR_init();
+        simInitKeys();                // Build state hash keys
+        gameReady = TRUE;
+    }
     PAL_setColor(0, RGB24_TO_VDPCOLOR(0xDEB887)); // Set gameplay background to sand
     
     // Clean up existing sprites
     if (spriteHead) SPR_releaseSprite(spriteHead);
-    for (u16 i = 0; i < SNAKE_MAX_LENGTH - 1; i++) {
-        if (spriteBody[i]) SPR_releaseSprite(spriteBody[i]);
-        spriteBody[i] = NULL;
+    for (u16 i = 0; i < BODY_RING_SIZE; i++) {
+        if (bodyRing[i]) SPR_releaseSprite(bodyRing[i]);
+        bodyRing[i] = NULL;
     }
+    bodyRingStart = 0;
     if (spriteFood) SPR_releaseSprite(spriteFood);
     spriteHead = NULL;
     spriteFood = NULL;
     
-    // Reset game-wide state
-    snakeLength = SNAKE_START_LENGTH;
-    for (u16 i = 0; i < snakeLength; i++) {
-        snakeBody[i].x = SNAKE_START_X - i; // Snake starts horizontally facing right
-        snakeBody[i].y = SNAKE_START_Y;
-    }
-    direction = DIR_RIGHT;
+    // Reset game-wide state (seeded from the HV counter entropy behind random())
+    const u32 seed = ((u32)random() << 16) | random();
+    simInitGameEx(&game, seed, FOOD_POLICY);
+    replayBegin(&game, demoMode);         // DEMO_* values match REPLAY_POLICY_*
+#if HEATMAP_SRAM
+    heatmapPrepare();                     // Any SRAM blanking happens here, not in a game step
+    heatmapClear(&heatmap);
+#endif
     nextDirection = DIR_RIGHT;
-    score = 0;
     frameDelay = INITIAL_DELAY;
     frameCount = 0;
     paused = FALSE;
@@ -299,23 +407,12 @@ static void initGame(void) {
     bassCounter = 0;
     jingleIndex = 0;
     jingleCounter = 0;
-    currentLevel = 1;
-    foodEatenThisLevel = 0;
-    foodTarget = 5;
-    
-    initLevel();                      // Set up initial level
-    gameState = STATE_LEVEL_TRANSITION; // Start with transition for Level 1
-    transitionTimer = TRANSITION_DURATION;
-    VDP_drawText("LEVEL 1", 16, 12);  // Display "Level 1" immediately
     
-    // Display initial score and level info
-    char scoreText[20];
-    sprintf(scoreText, "SCORE: %4d", score);
-    VDP_drawText(scoreText, 1, 0);
-    updateLevelDisplay();
+    initLevel();                      // Draw initial level
+    setState(STATE_LEVEL_TRANSITION); // Start with transition for Level 1
 }
 
-// Resets maze, portals, and food for a new level while preserving snake state
+// Draws the maze and portals built by simInitLevel() and sets up sprites (snake state is preserved)
 static void initLevel(void) {
     // Load wall tile
     u16 vramIndex = TILE_USER_INDEX + intro.tileset->numTile;
@@ -333,110 +430,54 @@ static void initLevel(void) {
     // Clear playfield and redraw borders
     VDP_clearPlane(BG_A, TRUE);
     VDP_clearPlane(BG_B, TRUE);
-    for (u16 y = 2; y < GRID_HEIGHT - 1; y++) {
-        for (u16 x = 1; x < GRID_WIDTH - 1; x++) {
-            VDP_setTileMapXY(BG_A, sandTileAttr, x, y);
-        }
-    }
-    for (u16 i = 0; i < GRID_WIDTH; i++) {
-        VDP_setTileMapXY(BG_A, wallTileAttr, i, 1);
-        VDP_setTileMapXY(BG_A, wallTileAttr, i, GRID_HEIGHT - 1);
-    }
-    for (u16 i = 2; i < GRID_HEIGHT - 1; i++) {
-        VDP_setTileMapXY(BG_A, wallTileAttr, 0, i);
-        VDP_setTileMapXY(BG_A, wallTileAttr, GRID_WIDTH - 1, i);
-    }
-    
-    // Randomize portal positions
-    portals[0].entry.x = 5 + (random() % (GRID_WIDTH - 10));
-    portals[0].entry.y = 1;
-    portals[0].exit.x = 5 + (random() % (GRID_WIDTH - 10));
-    portals[0].exit.y = GRID_HEIGHT - 1;
-    VDP_setTileMapXY(BG_A, sandTileAttr, portals[0].entry.x, portals[0].entry.y);
-    VDP_setTileMapXY(BG_A, sandTileAttr, portals[0].exit.x, portals[0].exit.y);
-    
-    portals[1].entry.x = 0;
-    portals[1].entry.y = 5 + (random() % (GRID_HEIGHT - 10));
-    portals[1].exit.x = GRID_WIDTH - 1;
-    portals[1].exit.y = 5 + (random() % (GRID_HEIGHT - 10));
-    VDP_setTileMapXY(BG_A, sandTileAttr, portals[1].entry.x, portals[1].entry.y);
-    VDP_setTileMapXY(BG_A, sandTileAttr, portals[1].exit.x, portals[1].exit.y);
-    
-    // Generate random maze walls
-    wallCount = 0;
-    u16 numWalls = 5 + currentLevel;
-    if (numWalls > MAX_WALLS) numWalls = MAX_WALLS;
-    for (u16 w = 0; w < numWalls && wallCount < MAX_WALLS * 5; w++) {
-        u16 isVertical = random() % 2;
-        u16 length = 3 + (random() % 3);
-        u16 x, y;
-        if (isVertical) {
-            x = 2 + (random() % (GRID_WIDTH - 4));
-            y = 3 + (random() % (GRID_HEIGHT - length - 4));
-            for (u16 i = 0; i < length && y + i < GRID_HEIGHT - 1 && wallCount < MAX_WALLS * 5; i++) {
-                u16 valid = TRUE;
-                for (u16 j = 0; j < snakeLength; j++) {
-                    if (x == snakeBody[j].x && y + i == snakeBody[j].y) valid = FALSE;
-                }
-                if (valid) {
-                    VDP_setTileMapXY(BG_A, wallTileAttr, x, y + i);
-                    mazeWalls[wallCount].x = x;
-                    mazeWalls[wallCount].y = y + i;
-                    wallCount++;
-                }
-            }
-        } else {
-            x = 2 + (random() % (GRID_WIDTH - length - 3));
-            y = 3 + (random() % (GRID_HEIGHT - 5));
-            for (u16 i = 0; i < length && x + i < GRID_WIDTH - 1 && wallCount < MAX_WALLS * 5; i++) {
-                u16 valid = TRUE;
-                for (u16 j = 0; j < snakeLength; j++) {
-                    if (x + i == snakeBody[j].x && y == snakeBody[j].y) valid = FALSE;
-                }
-                if (valid) {
-                    VDP_setTileMapXY(BG_A, wallTileAttr, x + i, y);
-                    mazeWalls[wallCount].x = x + i;
-                    mazeWalls[wallCount].y = y;
-                    wallCount++;
-                }
-            }
-        }
+#if SIM_ASM
+    // Stamp the level into the RAM tilemap (sand, border runs, portals, wall runs), then upload it in one DMA
+    simFillWords(playfield[1], sandTileAttr, GRID_WIDTH * (GRID_HEIGHT - 1));
+    simStampRun(playfield[1], wallTileAttr, GRID_WIDTH, 1);
+    simStampRun(playfield[GRID_HEIGHT - 1], wallTileAttr, GRID_WIDTH, 1);
+    simStampRun(&playfield[2][0], wallTileAttr, GRID_HEIGHT - 3, GRID_WIDTH);
+    simStampRun(&playfield[2][GRID_WIDTH - 1], wallTileAttr, GRID_HEIGHT - 3, GRID_WIDTH);
+    
+    // Portals are sand gaps in the border
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        playfield[game.portals[i].entry.y][game.portals[i].entry.x] = sandTileAttr;
+        playfield[game.portals[i].exit.y][game.portals[i].exit.x] = sandTileAttr;
     }
     
-    // Build free tile list
-    freeTileCount = 0;
-    for (u16 y = 2; y < GRID_HEIGHT - 1; y++) {
-        for (u16 x = 1; x < GRID_WIDTH - 1; x++) {
-            u16 isWall = FALSE;
-            for (u16 i = 0; i < wallCount; i++) {
-                if (mazeWalls[i].x == x && mazeWalls[i].y == y) {
-                    isWall = TRUE;
-                    break;
-                }
-            }
-            u16 isSnake = FALSE;
-            for (u16 i = 0; i < snakeLength; i++) {
-                if (snakeBody[i].x == x && snakeBody[i].y == y) {
-                    isSnake = TRUE;
-                    break;
-                }
-            }
-            if (!isWall && !isSnake) {
-                freeTiles[freeTileCount].x = x;
-                freeTiles[freeTileCount].y = y;
-                freeTileCount++;
-            }
+    // Maze walls: one stamp per run
+    for (u16 i = 0; i < game.wallSegmentCount; i++) {
+        const WallSegment* w = &game.mazeWalls[i];
+        for (u16 k = 0, n; (n = simWallRun(w, &k)) != 0; k += n) {
+            simStampRun(&playfield[WALL_TILE_Y(w, k)][WALL_TILE_X(w, k)], wallTileAttr, n,
+                        WALL_IS_VERTICAL(w) ? GRID_WIDTH : 1);
         }
     }
+    VDP_setTileMapDataRect(BG_A, playfield[1], 0, 1, GRID_WIDTH, GRID_HEIGHT - 1, GRID_WIDTH, DMA);
+#else
+    // Whole runs per call: the VDP address auto-increments along each tilemap row
+    VDP_fillTileMapRect(BG_A, sandTileAttr, 1, 2, GRID_WIDTH - 2, GRID_HEIGHT - 3);
+    VDP_fillTileMapRect(BG_A, wallTileAttr, 0, 1, GRID_WIDTH, 1);
+    VDP_fillTileMapRect(BG_A, wallTileAttr, 0, GRID_HEIGHT - 1, GRID_WIDTH, 1);
+    VDP_fillTileMapRect(BG_A, wallTileAttr, 0, 2, 1, GRID_HEIGHT - 3);
+    VDP_fillTileMapRect(BG_A, wallTileAttr, GRID_WIDTH - 1, 2, 1, GRID_HEIGHT - 3);
+    
+    // Portals are sand gaps in the border
     for (u16 i = 0; i < NUM_PORTALS; i++) {
-        freeTiles[freeTileCount].x = portals[i].entry.x;
-        freeTiles[freeTileCount].y = portals[i].entry.y;
-        freeTileCount++;
-        freeTiles[freeTileCount].x = portals[i].exit.x;
-        freeTiles[freeTileCount].y = portals[i].exit.y;
-        freeTileCount++;
+        VDP_setTileMapXY(BG_A, sandTileAttr, game.portals[i].entry.x, game.portals[i].entry.y);
+        VDP_setTileMapXY(BG_A, sandTileAttr, game.portals[i].exit.x, game.portals[i].exit.y);
     }
     
+    // Maze walls: one fill per run
+    for (u16 i = 0; i < game.wallSegmentCount; i++) {
+        const WallSegment* w = &game.mazeWalls[i];
+        for (u16 k = 0, n; (n = simWallRun(w, &k)) != 0; k += n) {
+            VDP_fillTileMapRect(BG_A, wallTileAttr, WALL_TILE_X(w, k), WALL_TILE_Y(w, k), WALL_IS_VERTICAL(w) ? 1 : n,
+                                WALL_IS_VERTICAL(w) ? n : 1);
+        }
+    }
+#endif
+    if (demoMode == DEMO_AI) aiPrepareLevel(&game); // AI_LANDMARKS tables: built here, not on the first move
+    
     // Load head sprite frames
     if (!spriteHead) {
         Animation* headAnim = snake_head_sprite.animations[0];
@@ -447,86 +488,186 @@ static void initLevel(void) {
             vramIndex += tileset->numTile;
         }
         spriteHead = SPR_addSprite(&snake_head_sprite,
-                                  snakeBody[0].x * SNAKE_TILE_SIZE,
-                                  snakeBody[0].y * SNAKE_TILE_SIZE,
+                                  game.snakeBody[0].x * SNAKE_TILE_SIZE,
+                                  game.snakeBody[0].y * SNAKE_TILE_SIZE,
                                   TILE_ATTR(PAL0, TRUE, FALSE, FALSE));
         SPR_setAutoTileUpload(spriteHead, FALSE);
-        SPR_setFrame(spriteHead, direction);
-        SPR_setVRAMTileIndex(spriteHead, headVramIndexes[direction]);
+        SPR_setFrame(spriteHead, headFrame[game.direction]);
+        SPR_setVRAMTileIndex(spriteHead, headVramIndexes[headFrame[game.direction]]);
     }
     
     // Load body sprite frames
     Animation* bodyAnim = snake_body_sprite.animations[0];
-    if (!spriteBody[0]) {
+    if (!BODY_SPRITE(1)) {
         for (u16 i = 0; i < 2; i++) {
             TileSet* tileset = bodyAnim->frames[i]->tileset;
             VDP_loadTileSet(tileset, vramIndex, DMA);
             bodyVramIndexes[i] = vramIndex;
             vramIndex += tileset->numTile;
         }
-        for (u16 i = 1; i < snakeLength; i++) {
-            spriteBody[i-1] = SPR_addSprite(&snake_body_sprite,
-                                           snakeBody[i].x * SNAKE_TILE_SIZE,
-                                           snakeBody[i].y * SNAKE_TILE_SIZE,
+        for (u16 i = 1; i < game.snakeLength; i++) {
+            Sprite* sprite = SPR_addSprite(&snake_body_sprite,
+                                           game.snakeBody[i].x * SNAKE_TILE_SIZE,
+                                           game.snakeBody[i].y * SNAKE_TILE_SIZE,
                                            TILE_ATTR(PAL0, TRUE, FALSE, FALSE));
-            SPR_setAutoTileUpload(spriteBody[i-1], FALSE);
-            SPR_setFrame(spriteBody[i-1], (snakeBody[i-1].x != snakeBody[i].x) ? 0 : 1);
-            SPR_setVRAMTileIndex(spriteBody[i-1], bodyVramIndexes[(snakeBody[i-1].x != snakeBody[i].x) ? 0 : 1]);
+            SPR_setAutoTileUpload(sprite, FALSE);
+            SPR_setFrame(sprite, (game.snakeBody[i-1].x != game.snakeBody[i].x) ? 0 : 1);
+            SPR_setVRAMTileIndex(sprite, bodyVramIndexes[(game.snakeBody[i-1].x != game.snakeBody[i].x) ? 0 : 1]);
+            BODY_SPRITE(i) = sprite;
         }
     }
     
-    // Place initial food
-    generateFood();
+    // Show initial food
     if (!spriteFood) {
         spriteFood = SPR_addSprite(&food_sprite,
-                                  food.x * SNAKE_TILE_SIZE,
-                                  food.y * SNAKE_TILE_SIZE,
+                                  game.food.x * SNAKE_TILE_SIZE,
+                                  foodSpriteY(),
                                   TILE_ATTR(PAL0, TRUE, FALSE, FALSE));
     } else {
-        SPR_setPosition(spriteFood, food.x * SNAKE_TILE_SIZE, food.y * SNAKE_TILE_SIZE);
+        SPR_setPosition(spriteFood, game.food.x * SNAKE_TILE_SIZE, foodSpriteY());
     }
     
     // Display initial score and level info
-    char scoreText[20];
-    sprintf(scoreText, "SCORE: %4d", score);
-    VDP_drawText(scoreText, 1, 0);
-    updateLevelDisplay();
+    RenderSnapshot hud;
+    formatHud(&hud);
+    VDP_drawText("SCORE:", 1, 0);
+    drawHud(&hud);
 }
 
-// Displays intro screen with title
-static void showIntroScreen(void) {
+// Leaves the current state and enters another one (also re-enters the current state)
+static void setState(u16 state) {
+    const StateHandlers* from = &stateTable[gameState];
+#if STATE_PROFILE
+    if (stateProfile.ticks) {
+        KLog_U3(from->name, stateProfile.ticks,
+                " ticks, avg cycles ", stateProfile.subTicks * CYCLES_PER_SUBTICK / stateProfile.ticks,
+                " max ", stateProfile.maxSubTicks * CYCLES_PER_SUBTICK);
+    }
+    stateProfile.ticks = stateProfile.subTicks = stateProfile.maxSubTicks = 0;
+    if (gameState == STATE_PLAYING && demoMode == DEMO_AI) { // Once per level of an AI demo game
+        AiPeaks peaks;
+        aiPeaks(&peaks);
+        KLog_U3("AI peak open ", peaks.open, " queue ", peaks.queue, " expanded ", peaks.expanded);
+    }
+#endif
+    if (from->exit) from->exit();
+    gameState = state;
+    stateTicks = 0;
+    if (stateTable[state].enter) stateTable[state].enter();
+}
+
+// Displays intro screen with title (the image streams in from updateIntro())
+static void enterIntro(void) {
     PAL_setColor(0, RGB24_TO_VDPCOLOR(0x000000));
+    PAL_setColors(16, palette_black, 16, CPU); // Image hidden until it is complete
     VDP_clearPlane(BG_A, TRUE);
     VDP_clearPlane(BG_B, TRUE);
-    
-    VDP_loadTileSet(intro.tileset, TILE_USER_INDEX, DMA);
-    VDP_setMapEx(BG_B, intro.tilemap, TILE_ATTR_FULL(PAL1, FALSE, FALSE, FALSE, TILE_USER_INDEX),
-                 0, 0, 0, 0, 40, 28);
+    introRowsDrawn = 0;
     
     VDP_drawText("AI-MAZE-ING SNAKE", 12, 2);
     VDP_drawText("START TO PLAY", 14, 6);
+    VDP_drawText("A TO WATCH AI", 14, 8);
     VDP_drawText("B TO TOGGLE MUSIC", 12, 10);
+    VDP_drawText("C TO WATCH NN", 14, 12);
     
-    introAnimFrame = 0;
-    gameState = STATE_INTRO;
     melodyIndex = 0;
     bassIndex = 0;
     melodyCounter = 0;
     bassCounter = 0;
-    score = 0;
     paused = FALSE;
     prevStartState = FALSE;
     musicEnabled = TRUE;
 }
 
-// Updates intro screen animation (blinking text)
-static void updateIntroScreen(void) {
-    introAnimFrame++;
-    if (introAnimFrame % 60 < 30) {
+// Updates intro screen animation (blinking text) and streams the image
+static void updateIntro(void) {
+#if STATE_PROFILE
+    if (!bootLogged) {                // First tick: the intro text shows from the next frame
+        KLog_U1("BOOT frames to intro ", vtimer + 1);
+        bootLogged = TRUE;
+    }
+#endif
+    if (stateTicks % 60 < 30) {
         VDP_drawText("START TO PLAY", 14, 6);
     } else {
         VDP_clearText(14, 6, 13);
     }
+    streamIntro();
+}
+
+// Stops the fade if the intro is left before it ends (the game only uses PAL0)
+static void exitIntro(void) {
+    PAL_interruptFade();
+}
+
+// One tick of the intro image: INTRO_TILES_PER_TICK tiles queued for the V-blank DMA until the tileset is
+// in VRAM, then INTRO_ROWS_PER_TICK tilemap rows, then the PAL1 fade-in (run by the V-blank processing)
+static void streamIntro(void) {
+    const TileSet* tileset = intro.tileset;
+    if (introTilesLoaded < tileset->numTile) {
+        const u16 count = min(INTRO_TILES_PER_TICK, tileset->numTile - introTilesLoaded);
+        VDP_loadTileData(tileset->tiles + introTilesLoaded * 8, TILE_USER_INDEX + introTilesLoaded, count, DMA_QUEUE);
+        introTilesLoaded += count;
+    } else if (introRowsDrawn < INTRO_ROWS) {
+        const u16 count = min(INTRO_ROWS_PER_TICK, INTRO_ROWS - introRowsDrawn);
+        VDP_setMapEx(BG_B, intro.tilemap, TILE_ATTR_FULL(PAL1, FALSE, FALSE, FALSE, TILE_USER_INDEX),
+                     0, introRowsDrawn, 0, introRowsDrawn, 40, count);
+        introRowsDrawn += count;
+        if (introRowsDrawn == INTRO_ROWS) {
+            PAL_fadeIn(16, 31, introPalette, INTRO_FADE_FRAMES, TRUE);
+#if STATE_PROFILE
+            KLog_U2("INTRO image complete, frame ", vtimer, " ticks ", stateTicks);
+#endif
+        }
+    }
+}
+
+// Steps the game every frameDelay ticks (the AI or NN picks the move in demo games)
+static void updatePlaying(void) {
+    frameCount++;
+    if (frameCount >= frameDelay && !paused) { // Update game logic at intervals
+        frameCount = 0;
+        if (demoMode == DEMO_AI) nextDirection = aiChooseMove(&game, &aiDefaultWeights);
+        else if (demoMode == DEMO_NN) nextDirection = nnChooseMove(&game, &nnDefaultModel);
+        updateGame();                 // Publishes a render snapshot, shown at the next V-int
+    }
+}
+
+// Shows "LEVEL X" at once and starts the level-up jingle
+static void enterTransition(void) {
+    char levelText[12];
+    sprintf(levelText, "LEVEL %d", game.currentLevel);
+    VDP_drawText(levelText, 16, 12);  // Initial display before blinking
+    jingleIndex = 0;
+    jingleCounter = 0;
+}
+
+// Blinks "LEVEL X" (20 ticks on, 20 off), then builds and draws the next maze and resumes play
+static void updateTransition(void) {
+    const u16 remaining = TRANSITION_DURATION - stateTicks;
+    if (remaining > 0) {
+        if ((remaining % 40) < 20) {
+            char levelText[12];
+            sprintf(levelText, "LEVEL %d", game.currentLevel);
+            VDP_drawText(levelText, 16, 12); // Centered-ish
+        } else {
+            restorePlayfield(16, 12, 8); // Clear max 8 chars
+        }
+    } else {
+        if (game.currentLevel > 1) {  // Build and draw the next maze and portals
+            simInitLevel(&game);
+            initLevel();
+        }
+        setState(STATE_PLAYING);      // Resume gameplay
+    }
+    SPR_update();                     // Sprites set up by initLevel()
+}
+
+// Clears the "LEVEL X" text and restores the playfield under it
+static void exitTransition(void) {
+    restorePlayfield(16, 12, 8);
+    jingleIndex = 0;                  // Reset jingle for next transition
+    jingleCounter = 0;
 }
 
 // Transitions from intro to gameplay with Level 1 transition
@@ -540,11 +681,16 @@ static void handleInput(void) {
     const u16 joy = JOY_readJoypad(JOY_1);
     const u16 startPressed = joy & BUTTON_START;
     const u16 bPressed = joy & BUTTON_B;
+    const u16 aPressed = joy & BUTTON_A;
+    const u16 cPressed = joy & BUTTON_C;
     
     if (startPressed && !prevStartState) {
-        if (gameState == STATE_INTRO) startGame();
+        if (gameState == STATE_INTRO) {
+            demoMode = DEMO_OFF;
+            startGame();
+        }
         else if (gameState == STATE_PLAYING) togglePause();
-        else if (gameState == STATE_GAMEOVER) showIntroScreen();
+        else if (gameState == STATE_GAMEOVER || gameState == STATE_WIN) setState(STATE_INTRO);
     }
     prevStartState = startPressed;
     
@@ -558,270 +704,235 @@ static void handleInput(void) {
     }
     prevBState = bPressed;
     
-    if (gameState == STATE_PLAYING && !paused) {
-        if (joy & BUTTON_UP && direction != DIR_DOWN) nextDirection = DIR_UP;
-        else if (joy & BUTTON_RIGHT && direction != DIR_LEFT) nextDirection = DIR_RIGHT;
-        else if (joy & BUTTON_DOWN && direction != DIR_UP) nextDirection = DIR_DOWN;
-        else if (joy & BUTTON_LEFT && direction != DIR_RIGHT) nextDirection = DIR_LEFT;
+    static u16 prevAState = FALSE;
+    static u16 prevCState = FALSE;
+    if (gameState == STATE_INTRO && aPressed && !prevAState) {
+        demoMode = DEMO_AI;           // Start an AI demo game
+        startGame();
+    }
+    else if (gameState == STATE_INTRO && cPressed && !prevCState) {
+        demoMode = DEMO_NN;           // Start a neural network demo game
+        startGame();
+    }
+    prevAState = aPressed;
+    prevCState = cPressed;
+    
+    if (gameState == STATE_PLAYING && !paused && demoMode == DEMO_OFF) {
+        // The reversing button is masked out, so the next pressed direction in priority order wins
+        const u16 dir = padDirection[joy & PAD_MASK & ~dirButton[simDirOpposite[game.direction]]];
+        if (dir != DIR_NONE) nextDirection = dir;
     }
 }
 
-// Updates game logic (movement, collisions, level progression)
+// Updates game logic (movement, collisions, level progression) and reacts to step events
 static void updateGame(void) {
-    s16 newHeadX = snakeBody[0].x;
-    s16 newHeadY = snakeBody[0].y;
+    replayRecord(nextDirection);
+    const u16 events = simStep(&game, nextDirection);
+    heatmapStep(events);
     
-    direction = nextDirection;
-    switch (direction) {
-        case DIR_UP:    newHeadY--; break;
-        case DIR_RIGHT: newHeadX++; break;
-        case DIR_DOWN:  newHeadY++; break;
-        case DIR_LEFT:  newHeadX--; break;
+    if (events & SIM_EVENT_DEAD) {
+        debugStep();                      // The trace covers the final step too
+        const u16 cause = simEndCause(&game, events); // Classified here only: normal steps pay nothing
+        recordCause(cause);
+        replayEnd(&game, cause);
+        setState(STATE_GAMEOVER);
+        return;
     }
     
-    // Check food collision before teleportation
-    u16 ateFood = (newHeadX == food.x && newHeadY == food.y);
+    RenderSnapshot* r = renderBegin();
+    r->headX = game.snakeBody[0].x * SNAKE_TILE_SIZE;
+    r->headY = game.snakeBody[0].y * SNAKE_TILE_SIZE;
+    r->headFrame = headFrame[game.direction];
     
-    // Portal teleportation
-    for (u16 i = 0; i < NUM_PORTALS; i++) {
-        if (newHeadX == portals[i].entry.x && newHeadY == portals[i].entry.y) {
-            newHeadX = portals[i].exit.x;
-            newHeadY = portals[i].exit.y;
-            break;
-        }
-        else if (newHeadX == portals[i].exit.x && newHeadY == portals[i].exit.y) {
-            newHeadX = portals[i].entry.x;
-            newHeadY = portals[i].entry.y;
-            break;
+    // One body sprite moves per step: a new one on growth (undone if the sprite engine is full),
+    // otherwise the old tail sprite, which goes to the old head cell
+    if (events & SIM_EVENT_GREW) {
+        r->neck = SPR_addSprite(&snake_body_sprite, -16, -16, TILE_ATTR(PAL0, TRUE, FALSE, FALSE));
+        if (!r->neck) {
+            simTrimTail(&game);
+            game.maxLength = game.snakeLength;
+            replaySpriteCap(game.maxLength);
+            recordCause(SIM_CAUSE_SPRITE_LIMIT);
+            VDP_drawText("SPRITE LIMIT!", 14, 10);
+        } else {
+            SPR_setAutoTileUpload(r->neck, FALSE);
         }
     }
-    
-    // Check food collision after teleportation
-    ateFood |= (newHeadX == food.x && newHeadY == food.y);
-    
-    // Collision detection
-    if ((newHeadX <= 0 || newHeadX >= GRID_WIDTH - 1 || newHeadY <= 1 || newHeadY >= GRID_HEIGHT - 1) &&
-        !((newHeadX == portals[0].entry.x && newHeadY == portals[0].entry.y) ||
-          (newHeadX == portals[0].exit.x && newHeadY == portals[0].exit.y) ||
-          (newHeadX == portals[1].entry.x && newHeadY == portals[1].entry.y) ||
-          (newHeadX == portals[1].exit.x && newHeadY == portals[1].exit.y)) ||
-        checkCollision(newHeadX, newHeadY)) {
-        gameState = STATE_GAMEOVER;
-        showGameOver();
-        return;
+    if (!r->neck) {
+        Sprite** tail = &BODY_SPRITE(game.snakeLength - 1);
+        r->neck = *tail;
+        *tail = NULL;
     }
+    bodyRingStart = (bodyRingStart + BODY_RING_SIZE - 1) % BODY_RING_SIZE;
+    BODY_SPRITE(1) = r->neck;
+    r->neckX = game.snakeBody[1].x * SNAKE_TILE_SIZE;
+    r->neckY = game.snakeBody[1].y * SNAKE_TILE_SIZE;
+    r->neckFrame = (game.snakeBody[0].x != game.snakeBody[1].x) ? 0 : 1; // Kept until the segment leaves the cell
     
     // Handle food collision
-    if (ateFood) {
-        foodEatenThisLevel++;
-        if (snakeLength < SNAKE_MAX_LENGTH) {
-            for (u16 i = snakeLength; i > 0; i--) {
-                snakeBody[i] = snakeBody[i - 1];
-            }
-            if (snakeLength > 1 && !spriteBody[snakeLength-2]) {
-                spriteBody[snakeLength-2] = SPR_addSprite(&snake_body_sprite,
-                                                         -16, -16,
-                                                         TILE_ATTR(PAL0, TRUE, FALSE, FALSE));
-                if (!spriteBody[snakeLength-2]) {
-                    snakeLength--;
-                    VDP_drawText("SPRITE LIMIT!", 14, 10);
-                    return;
-                }
-                SPR_setAutoTileUpload(spriteBody[snakeLength-2], FALSE);
-                SPR_setFrame(spriteBody[snakeLength-2], 0);
-                SPR_setVRAMTileIndex(spriteBody[snakeLength-2], bodyVramIndexes[0]);
-            }
-            snakeLength++;
-        } else {
-            for (u16 i = snakeLength - 1; i > 0; i--) {
-                snakeBody[i] = snakeBody[i - 1];
-            }
-        }
-        
+    if (events & SIM_EVENT_ATE) {
         playEatSound();
-        score += 10;
-        char scoreText[20];
-        sprintf(scoreText, "SCORE: %4d", score);
-        VDP_clearText(1, 0, 20);
-        VDP_drawText(scoreText, 1, 0);
-        
-        if (foodEatenThisLevel >= foodTarget) { // Level complete
-            currentLevel++;
-            foodEatenThisLevel = 0;
-            foodTarget = 5 + (currentLevel - 1) * 5;
+        formatHud(r);
+    
+        if (events & SIM_EVENT_LEVEL_UP) { // Level complete
             if (frameDelay > MIN_DELAY) frameDelay--;
             
-            // Trigger transition state
-            gameState = STATE_LEVEL_TRANSITION;
-            transitionTimer = TRANSITION_DURATION;
-            jingleIndex = 0;      // Start level-up jingle
-            jingleCounter = 0;
-            char levelText[8];
-            sprintf(levelText, "LEVEL %d", currentLevel);
-            VDP_drawText(levelText, 16, 12); // Initial display before blinking
+            setState(STATE_LEVEL_TRANSITION); // Level-up jingle and blinking "LEVEL X"
+        } else if (events & SIM_EVENT_WIN) { // No room left for food
+            recordCause(SIM_CAUSE_BOARD_FULL);
+            replayEnd(&game, SIM_CAUSE_BOARD_FULL);
+            setState(STATE_WIN);
         } else {
-            generateFood();
-            SPR_setPosition(spriteFood, food.x * SNAKE_TILE_SIZE, food.y * SNAKE_TILE_SIZE);
-        }
-        
-        updateLevelDisplay();
-    } else { // Move without eating
-        for (u16 i = snakeLength - 1; i > 0; i--) {
-            snakeBody[i] = snakeBody[i - 1];
-        }
-        for (u16 i = 0; i < freeTileCount; i++) {
-            if (freeTiles[i].x == snakeBody[snakeLength - 1].x && freeTiles[i].y == snakeBody[snakeLength - 1].y) {
-                freeTiles[i] = freeTiles[freeTileCount - 1];
-                freeTileCount--;
-                break;
-            }
-        }
-        freeTiles[freeTileCount].x = snakeBody[0].x;
-        freeTiles[freeTileCount].y = snakeBody[0].y;
-        freeTileCount++;
-    }
-    
-    snakeBody[0].x = newHeadX;
-    snakeBody[0].y = newHeadY;
-}
-
-// Renders game sprites
-static void drawGame(void) {
-    SPR_setPosition(spriteHead, snakeBody[0].x * SNAKE_TILE_SIZE, snakeBody[0].y * SNAKE_TILE_SIZE);
-    switch (direction) {
-        case DIR_DOWN:  SPR_setFrame(spriteHead, 0); SPR_setVRAMTileIndex(spriteHead, headVramIndexes[0]); break;
-        case DIR_RIGHT: SPR_setFrame(spriteHead, 1); SPR_setVRAMTileIndex(spriteHead, headVramIndexes[1]); break;
-        case DIR_UP:    SPR_setFrame(spriteHead, 2); SPR_setVRAMTileIndex(spriteHead, headVramIndexes[2]); break;
-        case DIR_LEFT:  SPR_setFrame(spriteHead, 3); SPR_setVRAMTileIndex(spriteHead, headVramIndexes[3]); break;
-    }
-    
-    for (u16 i = 1; i < snakeLength; i++) {
-        if (spriteBody[i-1]) {
-            SPR_setPosition(spriteBody[i-1], snakeBody[i].x * SNAKE_TILE_SIZE, snakeBody[i].y * SNAKE_TILE_SIZE);
-            s16 dx = snakeBody[i-1].x - snakeBody[i].x;
-            s16 dy = snakeBody[i-1].y - snakeBody[i].y;
-            if (dx != 0) {
-                SPR_setFrame(spriteBody[i-1], 0);
-                SPR_setVRAMTileIndex(spriteBody[i-1], bodyVramIndexes[0]);
-            } else if (dy != 0) {
-                SPR_setFrame(spriteBody[i-1], 1);
-                SPR_setVRAMTileIndex(spriteBody[i-1], bodyVramIndexes[1]);
-            }
+            r->foodX = game.food.x * SNAKE_TILE_SIZE;
+            r->foodY = foodSpriteY();
+            r->flags |= RENDER_FOOD;
         }
+    } else if (events & SIM_EVENT_FOOD) { // Food held back by SIM_EVENT_NO_FOOD placed at last
+        r->foodX = game.food.x * SNAKE_TILE_SIZE;
+        r->foodY = foodSpriteY();
+        r->flags |= RENDER_FOOD;
     }
+    
+    debugStep();
+    renderPublish();                      // Last: no VDP access from here to the next V-blank
 }
 
-// Places new food at a random free tile
-static void generateFood(void) {
-    if (freeTileCount == 0) {
-        gameState = STATE_GAMEOVER;
-        VDP_drawText("YOU WIN!", 16, 10);
-        return;
-    }
-    
-    u16 pick = random() % freeTileCount;
-    food.x = freeTiles[pick].x;
-    food.y = freeTiles[pick].y;
-    
-    freeTiles[pick] = freeTiles[freeTileCount - 1];
-    freeTileCount--;
+// Starts the next snapshot in the back buffer (the V-int handler only reads the other one)
+static RenderSnapshot* renderBegin(void) {
+    RenderSnapshot* r = &renderBuffers[renderBack];
+    r->flags = 0;
+    r->neck = NULL;
+    return r;
 }
 
-// Checks collisions with snake body or walls
-static u16 checkCollision(s16 x, s16 y) {
-    for (u16 i = 1; i < snakeLength; i++) {
-        if (snakeBody[i].x == x && snakeBody[i].y == y) return TRUE;
-    }
-    for (u16 i = 0; i < wallCount; i++) {
-        if (mazeWalls[i].x == x && mazeWalls[i].y == y) return TRUE;
+// Hands the back buffer to the V-int handler and flips to the other one
+static void renderPublish(void) {
+    while (renderPending);                // Two steps in one frame: wait until the previous one is shown
+    renderBack ^= 1;
+    renderPending = TRUE;                 // Set last: the handler never sees a half-flipped buffer
+}
+
+// V-int handler: applies the published snapshot and uploads the sprite table at once, so the frame that
+// shows a step does not depend on when the main loop reaches SYS_doVBlankProcess()
+static void renderVInt(void) {
+    if (!renderPending) return;
+    const RenderSnapshot* r = &renderBuffers[renderBack ^ 1];
+    SPR_setPosition(spriteHead, r->headX, r->headY);
+    SPR_setFrame(spriteHead, r->headFrame);
+    SPR_setVRAMTileIndex(spriteHead, headVramIndexes[r->headFrame]);
+    if (r->neck) {
+        SPR_setPosition(r->neck, r->neckX, r->neckY);
+        SPR_setFrame(r->neck, r->neckFrame);
+        SPR_setVRAMTileIndex(r->neck, bodyVramIndexes[r->neckFrame]);
     }
-    return FALSE;
+    if (r->flags & RENDER_FOOD) SPR_setPosition(spriteFood, r->foodX, r->foodY);
+    if (r->flags & RENDER_HUD) drawHud(r);
+    SPR_update();
+    DMA_flushQueue();
+    renderPending = FALSE;
 }
 
-// Displays game over screen with animation
-static void showGameOver(void) {
+// Displays game over text and silences the music
+static void enterGameOver(void) {
     VDP_drawText("GAME OVER", 15, 10);
     VDP_drawText("START TO PLAY AGAIN", 11, 12);
     VDP_drawText("FINAL SCORE:", 14, 14);
-    char scoreText[5];
-    sprintf(scoreText, "%d", score);
-    VDP_drawText(scoreText, 19 - (score >= 10 ? (score >= 100 ? (score >= 1000 ? 3 : 2) : 1) : 0), 16);
-    char levelText[12];
-    sprintf(levelText, "LEVEL: %d", currentLevel);
+    char scoreText[12];
+    sprintf(scoreText, "%d", game.score);
+    VDP_drawText(scoreText, 19 - (game.score >= 10 ? (game.score >= 100 ? (game.score >= 1000 ? 3 : 2) : 1) : 0), 16);
+    char levelText[16];
+    sprintf(levelText, "LEVEL: %d", game.currentLevel);
     VDP_drawText(levelText, 15, 18);
     
     PSG_setEnvelope(1, PSG_ENVELOPE_MIN);
     PSG_setEnvelope(2, PSG_ENVELOPE_MIN);
+    tuneIndex = 0;
+    tuneCounter = 0;
+    vanishSegment = game.snakeLength - 1;
+}
+
+// After a short rest, plays the game-over tune and removes one sprite every GAMEOVER_VANISH ticks:
+// body from the tail, then head, then food
+static void updateGameOver(void) {
+    if (stateTicks < GAMEOVER_PAUSE) return;
     
-    waitMs(200);
-    
-    const u16 tuneSize = 5;
-    u16 tuneIndex = 0;
-    u16 tuneCounter = 0;
-    
-    for (u16 i = snakeLength - 1; i > 0; i--) {
-        if (spriteBody[i-1]) {
-            SPR_releaseSprite(spriteBody[i-1]);
-            spriteBody[i-1] = NULL;
-            SPR_update();
-            SYS_doVBlankProcess();
-            waitMs(50);
-        }
-        
-        if (tuneCounter == 0 && tuneIndex < tuneSize) {
-            PSG_setFrequency(1, gameOverTune[tuneIndex].frequency);
-            PSG_setEnvelope(1, gameOverTune[tuneIndex].frequency != NOTE_REST ? PSG_ENVELOPE_MAX / 4 : PSG_ENVELOPE_MIN);
-            tuneCounter = gameOverTune[tuneIndex].baseDuration * 2;
-            tuneIndex++;
-        }
-        if (tuneCounter > 0) tuneCounter--;
+    if (tuneCounter == 0 && tuneIndex < GAMEOVER_SIZE) {
+        PSG_setFrequency(1, gameOverTune[tuneIndex].frequency);
+        PSG_setEnvelope(1, gameOverTune[tuneIndex].frequency != NOTE_REST ? PSG_ENVELOPE_MAX / 4 : PSG_ENVELOPE_MIN);
+        tuneCounter = gameOverTune[tuneIndex].baseDuration * 2;
+        tuneIndex++;
+    }
+    if (tuneCounter > 0 && --tuneCounter == 0 && tuneIndex == GAMEOVER_SIZE) {
+        PSG_setEnvelope(1, PSG_ENVELOPE_MIN); // Tune over
     }
     
-    if (spriteHead) {
+    if ((stateTicks - GAMEOVER_PAUSE) % GAMEOVER_VANISH) return;
+    if (vanishSegment > 0) {
+        if (BODY_SPRITE(vanishSegment)) {
+            SPR_releaseSprite(BODY_SPRITE(vanishSegment));
+            BODY_SPRITE(vanishSegment) = NULL;
+        }
+        vanishSegment--;
+    } else if (spriteHead) {
         SPR_releaseSprite(spriteHead);
         spriteHead = NULL;
-        SPR_update();
-        SYS_doVBlankProcess();
-        waitMs(50);
-    }
-    
-    if (spriteFood) {
+    } else if (spriteFood) {
         SPR_releaseSprite(spriteFood);
         spriteFood = NULL;
-        SPR_update();
-        SYS_doVBlankProcess();
-        waitMs(50);
     }
-    
-    while (tuneIndex < tuneSize) {
-        if (tuneCounter == 0) {
-            PSG_setFrequency(1, gameOverTune[tuneIndex].frequency);
-            PSG_setEnvelope(1, gameOverTune[tuneIndex].frequency != NOTE_REST ? PSG_ENVELOPE_MAX / 4 : PSG_ENVELOPE_MIN);
-            tuneCounter = gameOverTune[tuneIndex].baseDuration * 2;
-            tuneIndex++;
-        }
-        tuneCounter--;
-        SYS_doVBlankProcess();
+    SPR_update();
+}
+
+// Removes the sprites still on screen (Start pressed early, or after a win) and stops the tune
+static void exitGameOver(void) {
+    for (u16 i = 0; i < BODY_RING_SIZE; i++) {
+        if (bodyRing[i]) SPR_releaseSprite(bodyRing[i]);
+        bodyRing[i] = NULL;
     }
-    
+    if (spriteHead) SPR_releaseSprite(spriteHead);
+    if (spriteFood) SPR_releaseSprite(spriteFood);
+    spriteHead = NULL;
+    spriteFood = NULL;
+    SPR_update();
     PSG_setEnvelope(1, PSG_ENVELOPE_MIN);
-    PSG_setEnvelope(2, PSG_ENVELOPE_MIN);
 }
 
-// Plays "chomp" sound effect
+// Board full: the snake stays on screen until Start
+static void enterWin(void) {
+    VDP_drawText("YOU WIN!", 16, 10);
+}
+
+// Food at row 0 is held back (SIM_EVENT_NO_FOOD): parked one tile above the screen until it is placed
+static s16 foodSpriteY(void) {
+    return game.food.y ? game.food.y * SNAKE_TILE_SIZE : -SNAKE_TILE_SIZE;
+}
+
+// Starts the "chomp" sound effect (updateMusic() plays the rest)
 static void playEatSound(void) {
     PSG_setEnvelope(0, PSG_ENVELOPE_MAX);
     PSG_setFrequency(0, 1000);
-    waitMs(20);
-    PSG_setEnvelope(0, PSG_ENVELOPE_MAX / 2);
-    PSG_setFrequency(0, 400);
-    waitMs(30);
-    PSG_setEnvelope(0, PSG_ENVELOPE_MIN);
+    chompTicks = CHOMP_TICKS;
 }
 
 // Updates chiptune music and level-up jingle playback
 static void updateMusic(void) {
-    if (gameState == STATE_GAMEOVER || (gameState == STATE_PLAYING && paused)) {
+    // Chomp: high for the first tick, low for the others (channel 0)
+    if (chompTicks > 0) {
+        chompTicks--;
+        if (chompTicks == CHOMP_TICKS - 1) {
+            PSG_setEnvelope(0, PSG_ENVELOPE_MAX / 2);
+            PSG_setFrequency(0, 400);
+        } else if (chompTicks == 0) {
+            PSG_setEnvelope(0, PSG_ENVELOPE_MIN);
+        }
+    }
+    
+    if (gameState == STATE_GAMEOVER) {    // Channel 1 plays the game-over tune
+        PSG_setEnvelope(2, PSG_ENVELOPE_MIN);
+        PSG_setEnvelope(3, PSG_ENVELOPE_MIN);
+        return;
+    }
+    if (gameState == STATE_WIN || (gameState == STATE_PLAYING && paused)) {
         PSG_setEnvelope(1, PSG_ENVELOPE_MIN);
         PSG_setEnvelope(2, PSG_ENVELOPE_MIN);
         PSG_setEnvelope(3, PSG_ENVELOPE_MIN); // Silence jingle channel
@@ -845,7 +956,7 @@ static void updateMusic(void) {
         bassVolume /= 2;
     }
     
-    Note* currentMelody = (gameState == STATE_INTRO) ? introMelody : melody;
+    const Note* currentMelody = (gameState == STATE_INTRO) ? introMelody : melody;
     u16 tempoFactor = (gameState == STATE_INTRO) ? 12 : min((frameDelay * 10) / INITIAL_DELAY, MAX_TEMPO_FACTOR);
     const u16 melodyDuration = (currentMelody[melodyIndex].baseDuration * tempoFactor) / 10;
     const u16 bassDuration = (bass[bassIndex].baseDuration * tempoFactor) / 10;
@@ -869,7 +980,7 @@ static void updateMusic(void) {
     bassCounter--;
     
     // Update level-up jingle (channel 3) during transition
-    if (gameState == STATE_LEVEL_TRANSITION && transitionTimer > 0) {
+    if (gameState == STATE_LEVEL_TRANSITION && stateTicks < TRANSITION_DURATION) {
         if (jingleCounter == 0 && jingleIndex < LEVEL_UP_SIZE) {
             PSG_setFrequency(3, levelUpJingle[jingleIndex].frequency);
             PSG_setEnvelope(3, levelUpJingle[jingleIndex].frequency != NOTE_REST ? jingleVolume : PSG_ENVELOPE_MIN);
@@ -885,21 +996,82 @@ static void updateMusic(void) {
 // Toggles pause state
 static void togglePause(void) {
     paused = !paused;
-    const u16 sandTileAttr = TILE_ATTR_FULL(PAL0, FALSE, FALSE, FALSE, sandVramIndex);
     if (paused) {
         VDP_drawText("PAUSE", 17, 14);
     } else {
-        VDP_clearText(17, 14, 5);
-        for (u16 x = 17; x < 22; x++) {
-            VDP_setTileMapXY(BG_A, sandTileAttr, x, 14);
-        }
+        restorePlayfield(17, 14, 5);
     }
 }
 
-// Updates level and food progress display
-static void updateLevelDisplay(void) {
-    char levelText[20];
-    sprintf(levelText, "LEVEL %d: %d/%d", currentLevel, foodEatenThisLevel, foodTarget);
+// Overwrites text on the playfield with the level's tiles: sand or wall from the RAM tilemap (SIM_ASM),
+// else sand
+static void restorePlayfield(u16 x, u16 y, u16 width) {
+#if SIM_ASM
+    VDP_setTileMapDataRect(BG_A, &playfield[y][x], x, y, width, 1, GRID_WIDTH, CPU);
+#else
+    VDP_clearText(x, y, width);
+    VDP_fillTileMapRect(BG_A, TILE_ATTR_FULL(PAL0, FALSE, FALSE, FALSE, sandVramIndex), x, y, width, 1);
+#endif
+}
+
+// Formats the game's score digits and level progress into a snapshot
+static void formatHud(RenderSnapshot* r) {
+    sprintf(r->scoreDigits, "%4d", game.score);
+    sprintf(r->levelText, "LEVEL %d: %d/%d", game.currentLevel, game.foodEatenThisLevel, game.foodTarget);
+    r->flags |= RENDER_HUD;
+}
+
+// Draws the score digits after the "SCORE:" label and the right-aligned level progress
+static void drawHud(const RenderSnapshot* r) {
+    VDP_drawText(r->scoreDigits, 8, 0);
     VDP_clearText(GRID_WIDTH - 14, 0, 14);
-    VDP_drawText(levelText, GRID_WIDTH - strlen(levelText) - 1, 0);
-}
\ No newline at end of file
+    VDP_drawText(r->levelText, GRID_WIDTH - strlen(r->levelText) - 1, 0);
+}
+
+// Counts a game end (or refused growth) by cause and logs it when tracing
+static void recordCause(u16 cause) {
+    causeCount[cause]++;
+#if DEBUG_TRACE
+    KLog(simCauseNames[cause]);
+    KLog_U2("count ", causeCount[cause], " step ", game.stepCount);
+#endif
+}
+
+// Counts the head cell (or the fatal cell) and folds the level into SRAM when it ends
+static void heatmapStep(u16 events) {
+#if HEATMAP_SRAM
+    if (events & SIM_EVENT_DEAD) heatmapDeath(&heatmap, &game, nextDirection);
+    else HEATMAP_VISIT(&heatmap, &game);
+    if (events & SIM_EVENT_LEVEL_UP) heatmapFlush(&heatmap, game.currentLevel - 1); // Level already advanced
+    else if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) heatmapFlush(&heatmap, game.currentLevel);
+#else
+    (void)events;
+#endif
+}
+
+#if STATE_PROFILE
+// Adds one tick's update time to the current state's profile
+static void profileTick(u16 state, u32 subTicks) {
+    if (state != gameState) return;   // The tick changed state: setState() already logged the old one
+    stateProfile.ticks++;
+    stateProfile.subTicks += subTicks;
+    if (subTicks > stateProfile.maxSubTicks) stateProfile.maxSubTicks = subTicks;
+}
+#endif
+
+// Shows the state hash on the HUD and/or logs it per step (compiled out unless enabled)
+static void debugStep(void) {
+#if (DEBUG_OVERLAY || DEBUG_TRACE)
+    const u32 hash = simHash(&game);
+#if DEBUG_OVERLAY
+    char hashText[12];
+    hashText[0] = 'H';
+    hashText[1] = ':';
+    intToHex(hash, hashText + 2, 8);
+    VDP_drawText(hashText, 13, 0);
+#endif
+#if DEBUG_TRACE
+    kprintf("%08lX %lu", hash, game.stepCount); // Same line as the host trace (dsexport -T)
+#endif
+#endif
+}
@@ -0,0 +1,129 @@
+// Quantized MLP policy shared by the ROM (NN demo) and the host tools (see nn.h)
+
+#include "nn.h"
+#include "nn_weights.h"
+
+#define WINDOW_HALF (NN_WINDOW / 2)
+
+const NnModel nnDefaultModel = { &nnW1[0][0], nnB1, nnAct, NN_ACT_SHIFT, &nnW2[0][0], nnB2 };
+
+static u16 isPortal(const SimState* s, s16 x, s16 y) {
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        if ((x == s->portals[i].entry.x && y == s->portals[i].entry.y) ||
+            (x == s->portals[i].exit.x && y == s->portals[i].exit.y)) return TRUE;
+    }
+    return FALSE;
+}
+
+// Marks window cell (x, y) as blocked if it lies inside the window
+static void markWindow(u8* window, s16 x, s16 y, s16 left, s16 top) {
+    const u16 wx = x - left;
+    const u16 wy = y - top;
+    if (wx < NN_WINDOW && wy < NN_WINDOW) window[wy * NN_WINDOW + wx] = 1;
+}
+
+// Marks every wall tile of the segments mazeWalls[from .. to)
+static void markWalls(u8* window, const SimState* s, u16 from, u16 to, s16 left, s16 top) {
+    for (u16 i = from; i < to; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        for (u16 k = 0; k < w->length; k++) {
+            if (!WALL_SKIPPED(w, k)) markWindow(window, WALL_TILE_X(w, k), WALL_TILE_Y(w, k), left, top);
+        }
+    }
+}
+
+// Clamps a window edge to the rows (size GRID_HEIGHT) or columns (GRID_WIDTH) of the wall index
+static s16 clampKey(s16 v, s16 size) {
+    return v < 0 ? 0 : (v > size ? size : v);
+}
+
+u16 nnFeatures(const SimState* s, u8* active) {
+    u8 window[NN_WINDOW_CELLS];
+    const Point head = s->snakeBody[0];
+    const s16 left = head.x - WINDOW_HALF;
+    const s16 top = head.y - WINDOW_HALF;
+    u16 count = 0;
+
+    // Borders (and anything outside the grid) are blocked unless they are portal tiles
+    for (u16 wy = 0; wy < NN_WINDOW; wy++) {
+        const s16 y = top + wy;
+        for (u16 wx = 0; wx < NN_WINDOW; wx++) {
+            const s16 x = left + wx;
+            const u16 border = x <= 0 || x >= GRID_WIDTH - 1 || y <= 1 || y >= GRID_HEIGHT - 1;
+            window[wy * NN_WINDOW + wx] = border && !isPortal(s, x, y);
+        }
+    }
+    // Wall segments are indexed by row (horizontal) and column (vertical): only those crossing the window are scanned
+    markWalls(window, s, s->wallStart[clampKey(top, GRID_HEIGHT)], s->wallStart[clampKey(top + NN_WINDOW, GRID_HEIGHT)],
+              left, top);
+    markWalls(window, s, s->wallStart[GRID_HEIGHT + clampKey(left, GRID_WIDTH)],
+              s->wallStart[GRID_HEIGHT + clampKey(left + NN_WINDOW, GRID_WIDTH)], left, top);
+    for (u16 i = 1; i < s->snakeLength; i++) markWindow(window, s->snakeBody[i].x, s->snakeBody[i].y, left, top);
+
+    for (u16 i = 0; i < NN_WINDOW_CELLS; i++) {
+        if (window[i]) active[count++] = i;
+    }
+    if (s->food.y < head.y) active[count++] = NN_FOOD_INPUT + DIR_UP;
+    if (s->food.x > head.x) active[count++] = NN_FOOD_INPUT + DIR_RIGHT;
+    if (s->food.y > head.y) active[count++] = NN_FOOD_INPUT + DIR_DOWN;
+    if (s->food.x < head.x) active[count++] = NN_FOOD_INPUT + DIR_LEFT;
+    active[count++] = NN_DIR_INPUT + s->direction;
+    return count;
+}
+
+u16 nnLegalMask(const SimState* s) {
+    u16 mask = 0;
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (dir == simDirOpposite[s->direction]) continue;
+        Point head;
+        simNextHead(s, dir, &head);
+        if (!simIsBlocked(s, head.x, head.y)) mask |= 1 << dir;
+    }
+    return mask;
+}
+
+void nnForward(const NnModel* m, const u8* active, u16 count, s32* logits) {
+    s16 hidden[NN_HIDDEN];
+    s8 act[NN_HIDDEN];
+
+    // Layer 1: binary inputs, so only the rows of active inputs are summed
+    for (u16 j = 0; j < NN_HIDDEN; j++) hidden[j] = m->b1[j];
+    for (u16 i = 0; i < count; i++) {
+        const s8* row = &m->w1[active[i] * NN_HIDDEN];
+        for (u16 j = 0; j < NN_HIDDEN; j++) hidden[j] += row[j];
+    }
+    for (u16 j = 0; j < NN_HIDDEN; j++) {
+        s16 k = hidden[j] >> m->actShift;
+        if (k < -128) k = -128;
+        if (k > 127) k = 127;
+        act[j] = m->act[k + 128];
+    }
+
+    // Layer 2: 16x16-bit products (MULS) into 32-bit sums
+    for (u16 o = 0; o < NN_OUTPUTS; o++) logits[o] = m->b2[o];
+    for (u16 j = 0; j < NN_HIDDEN; j++) {
+        const s16 a = act[j];
+        const s8* row = &m->w2[j * NN_OUTPUTS];
+        for (u16 o = 0; o < NN_OUTPUTS; o++) logits[o] += (s16)row[o] * a;
+    }
+}
+
+u16 nnChooseMove(const SimState* s, const NnModel* m) {
+    u8 active[NN_INPUTS];
+    s32 logits[NN_OUTPUTS];
+    const u16 legal = nnLegalMask(s);
+    if (!legal) return s->direction;
+    nnForward(m, active, nnFeatures(s, active), logits);
+    u16 best = s->direction;
+    s32 bestLogit = 0;
+    u16 found = FALSE;
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (!(legal & (1 << dir))) continue;
+        if (!found || logits[dir] > bestLogit) {
+            bestLogit = logits[dir];
+            best = dir;
+            found = TRUE;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,42 @@
+// Quantized MLP policy shared by the ROM (NN demo) and the host tools
+//
+// Overview:
+// A 57-16-4 multilayer perceptron that maps local observations to a direction:
+// - inputs 0..48:  7x7 window centred on the head, 1 = blocked (border, wall, body); portals count as free
+// - inputs 49..52: food direction flags (food above, right, below, left of the head; up to two set)
+// - inputs 53..56: current direction, one-hot
+// Inputs are binary, so the first layer is a sum of int8 weight rows over the active inputs (additions
+// only). Hidden pre-activations go through a 256-entry tanh lookup table to int8; the output layer is
+// 16x4 MULS (16x16->32 bit) plus an int32 bias. Illegal moves (reversing, blocked) are masked before
+// the argmax. Weights are const ROM data generated by tools/nntrain from AI self-play.
+
+#ifndef _NN_H_
+#define _NN_H_
+
+#include "sim.h"
+
+#define NN_WINDOW 7            // Side of the square observation window around the head
+#define NN_WINDOW_CELLS (NN_WINDOW * NN_WINDOW)
+#define NN_FOOD_INPUT NN_WINDOW_CELLS // First food direction input
+#define NN_DIR_INPUT (NN_FOOD_INPUT + 4) // First current-direction input
+#define NN_INPUTS (NN_DIR_INPUT + 4)
+#define NN_HIDDEN 16
+#define NN_OUTPUTS 4           // One logit per DIR_*
+
+typedef struct {
+    const s8* w1;              // [NN_INPUTS][NN_HIDDEN] input weights
+    const s16* b1;             // [NN_HIDDEN] hidden biases (same scale as w1)
+    const s8* act;             // [256] tanh table, indexed by (pre-activation >> actShift) + 128
+    u16 actShift;              // Pre-activation scaling for the table index
+    const s8* w2;              // [NN_HIDDEN][NN_OUTPUTS] output weights
+    const s32* b2;             // [NN_OUTPUTS] output biases (scale of w2 * act)
+} NnModel;
+
+extern const NnModel nnDefaultModel;      // Trained weights from nn_weights.h
+
+u16 nnFeatures(const SimState* s, u8* active); // Fills the indices of the active inputs; returns their count
+u16 nnLegalMask(const SimState* s);       // Bit per direction that neither reverses nor collides
+void nnForward(const NnModel* m, const u8* active, u16 count, s32* logits); // Raw output logits
+u16 nnChooseMove(const SimState* s, const NnModel* m); // Best legal direction (current one if none)
+
+#endif // _NN_H_
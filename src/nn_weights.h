@@ -0,0 +1,111 @@
+// MLP policy weights (see nn.h)
+// Generated by tools/nntrain (589273 samples, held-out accuracy 93.0%, mean score 255) -- regenerate rather than edit
+
+#ifndef _NN_WEIGHTS_H_
+#define _NN_WEIGHTS_H_
+
+#define NN_ACT_SHIFT 0
+
+static const s8 nnW1[NN_INPUTS][NN_HIDDEN] = {
+    { 7, -8, 5, -3, -1, -3, -5, 4, -25, 4, -3, -5, 3, 0, 2, -6 },
+    { 8, 0, 2, -4, -7, -5, -2, 0, -21, 0, -3, -2, 2, 2, -5, -2 },
+    { 13, 0, -3, 0, 2, -2, 3, 0, -13, 2, -4, 1, -11, 1, -13, -2 },
+    { -31, -3, -2, -12, -1, 0, 3, 5, 7, -7, -4, 11, -11, 2, 14, -6 },
+    { -4, -2, -8, 4, 1, 4, -5, -1, 6, 1, -5, 2, -3, -7, 7, -4 },
+    { -7, -3, 3, -2, -9, 2, 2, 3, 12, -5, 7, 1, 7, -4, -6, 0 },
+    { -10, 1, 4, 2, 0, 3, 0, 2, 5, -4, 4, -10, 17, -2, 5, 6 },
+    { 9, -9, 4, -1, -5, -10, 1, 3, -19, 6, 2, -6, 4, 7, 3, 0 },
+    { 14, 7, -1, -8, -5, -10, -3, 3, -1, 10, -3, 1, 14, 0, -2, 2 },
+    { 21, 6, 6, 3, -3, -1, -3, 0, -7, -2, 0, 1, -16, -5, -13, -4 },
+    { -28, -2, 9, -13, -19, 0, 1, 10, 7, -8, -4, -2, -9, -4, 4, -2 },
+    { -2, -2, -12, 13, 17, -1, -4, -11, 0, -8, -6, 13, -7, 0, 8, 3 },
+    { -1, -6, 5, 4, -17, 1, 0, 3, 3, -14, 7, -6, 9, 0, 2, 1 },
+    { -1, -1, 1, 3, -5, 0, -3, 7, 1, 5, -3, -9, 8, 0, 0, 1 },
+    { 0, -9, -1, 1, 3, 43, -4, 2, -12, -5, -2, -3, -14, -7, -5, -11 },
+    { 8, -4, 6, 12, 4, 61, -14, -4, -5, -2, -3, -2, -15, 1, -16, -2 },
+    { 17, 2, 0, -34, -4, 82, 9, -2, 2, -14, -34, 1, -94, -2, -29, -14 },
+    { -20, -1, -3, 33, 26, 52, 20, 66, 9, 50, 16, 7, -38, -28, -8, 31 },
+    { -4, -28, -27, -2, 99, -1, -10, 65, 2, -22, -55, 13, 3, 18, 9, -12 },
+    { 1, -19, 10, -9, 20, -1, -4, 42, -1, 13, -18, -4, 2, 7, 18, 8 },
+    { -8, -7, 4, -3, 6, 3, -6, 32, 2, -4, -15, -10, 5, -1, 11, -1 },
+    { -9, -12, 1, -16, -5, -56, 4, 0, 32, -2, 0, 9, 11, -3, 23, -57 },
+    { -21, -5, -6, 10, 0, -80, 25, -2, 47, 1, 5, -6, 2, 4, -1, -54 },
+    { 18, 18, -15, 5, 16, -24, 52, 4, 17, -12, 25, -11, 6, -1, -28, 19 },
+    { -5, -4, -1, 6, 3, -8, 9, 7, 5, -7, -3, -9, 7, 8, -3, -4 },
+    { -2, 46, -19, 11, 9, 11, -16, 20, -9, -9, 61, 18, 11, -23, 19, -8 },
+    { -7, -16, -25, 14, -36, -1, 0, -30, 8, -5, -16, 2, -30, -8, 11, -9 },
+    { -5, -4, 1, 4, -11, 0, 3, -37, -5, 3, -5, 9, -25, 5, 13, -7 },
+    { -14, -3, 0, 5, -1, 11, -20, -5, -15, 5, -8, 2, -2, -1, 11, 32 },
+    { -9, 6, -3, -4, -1, 5, -21, -2, 9, -1, -4, 5, -1, -3, 21, 53 },
+    { 2, 6, -9, -7, -8, 4, -13, 0, -5, -3, -6, 4, 3, 0, 22, 95 },
+    { 12, 0, 0, 50, -9, 56, 13, 2, -5, 11, -18, -4, -7, 43, 15, 79 },
+    { -10, -3, -90, 32, -6, -6, 16, -5, 1, -33, -14, -11, -5, -11, 5, -1 },
+    { 0, 13, 5, 5, 1, -3, 6, -13, 1, 4, 13, -8, 15, -5, 1, -9 },
+    { 9, 21, -8, 4, 7, 0, 2, -10, 5, 1, 6, -8, 5, -1, -7, -1 },
+    { 7, -4, 0, 0, -2, -3, -7, -1, -18, 2, -1, -4, 2, 1, 4, 0 },
+    { -5, 4, 5, -10, -5, 3, 2, 3, -10, -2, 2, -2, 3, -5, -7, 0 },
+    { -1, 5, -2, -7, 2, -1, -8, 0, -3, 0, 6, 3, -3, -11, 5, 0 },
+    { -13, -5, 20, 28, -3, -2, 7, 1, 10, 6, 0, 6, 8, 17, 3, 6 },
+    { 3, -1, -13, -3, 5, 3, 0, -2, 3, -10, -2, -9, -22, -5, -8, -1 },
+    { 1, 11, -2, -14, 16, 1, -4, 3, 0, 1, 4, -8, 4, 6, 1, -2 },
+    { 5, 8, -2, -1, -8, -6, 9, -8, 8, 0, 0, -3, 2, -21, -1, -2 },
+    { -1, 0, -2, 4, -2, -8, 1, 1, -32, -1, 6, -3, 4, -3, -1, 5 },
+    { -3, -1, 2, -5, -4, -3, -7, 2, -14, 5, 2, 3, 4, 0, 5, -1 },
+    { -7, -2, 6, -14, 1, 3, -7, 3, -10, 7, 0, 5, 5, 0, 2, -7 },
+    { -9, 4, 7, 19, -10, -4, 5, 1, 5, 5, 0, 12, 4, -1, -16, 12 },
+    { 3, 6, -17, -1, 0, -5, 7, -5, 3, -11, -1, -3, -9, 3, 6, -4 },
+    { 1, 11, 1, -2, 0, -3, 2, -3, 5, -5, -1, 0, -9, -3, 2, -1 },
+    { 2, 8, 6, -2, 4, 1, -2, -1, 4, 5, 1, -2, 8, 7, 2, 0 },
+    { 26, -50, 1, 12, -5, -51, -83, -40, 26, 35, -33, -94, -15, -52, -15, -1 },
+    { 23, -17, 61, 38, 27, 26, -28, 19, 37, -48, 15, 79, 17, -117, 27, 13 },
+    { 7, 21, 10, 2, -11, -33, -127, 35, 20, 32, 16, -83, -12, 43, -44, -32 },
+    { -11, 15, 39, -6, 23, 18, 88, 44, -61, -35, -6, -38, 0, -46, 30, 7 },
+    { 10, -23, -14, 28, 21, -18, -28, -21, 12, 33, -84, -28, -26, 34, 7, 28 },
+    { 20, 30, -14, -15, 42, -8, 33, -10, 2, -56, 17, 9, 59, -22, -34, 3 },
+    { -55, 13, -68, 20, -61, -12, -24, 11, -6, 40, -2, -3, -20, 12, -12, -23 },
+    { 5, -22, 86, -26, -2, 34, 5, 34, 19, -14, 48, 3, -5, -9, 30, 28 },
+};
+static const s16 nnB1[NN_HIDDEN] = {
+    -33, 9, -15, -2, 6, -9, -13, 20, 22, 6, -5, -18, -8, 19, 1, 27,
+};
+static const s8 nnAct[256] = {
+    -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127,
+    -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127,
+    -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127, -127,
+    -127, -126, -126, -126, -126, -126, -126, -126, -126, -126, -126, -126, -126, -126, -126, -125,
+    -125, -125, -125, -125, -125, -125, -124, -124, -124, -124, -123, -123, -123, -122, -122, -122,
+    -121, -121, -120, -120, -119, -119, -118, -117, -116, -116, -115, -114, -113, -112, -110, -109,
+    -108, -106, -105, -103, -101, -99, -97, -95, -93, -90, -88, -85, -82, -79, -76, -73,
+    -70, -66, -62, -58, -54, -50, -46, -41, -37, -32, -27, -22, -18, -13, -8, -3,
+    3, 8, 13, 18, 22, 27, 32, 37, 41, 46, 50, 54, 58, 62, 66, 70,
+    73, 76, 79, 82, 85, 88, 90, 93, 95, 97, 99, 101, 103, 105, 106, 108,
+    109, 110, 112, 113, 114, 115, 116, 116, 117, 118, 119, 119, 120, 120, 121, 121,
+    122, 122, 122, 123, 123, 123, 124, 124, 124, 124, 125, 125, 125, 125, 125, 125,
+    125, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 127,
+    127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+    127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+    127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+};
+static const s8 nnW2[NN_HIDDEN][NN_OUTPUTS] = {
+    { -49, -7, -9, 60 },
+    { -45, 21, 47, 3 },
+    { 27, 43, -103, 32 },
+    { -16, 79, 15, -60 },
+    { 27, 75, -74, -30 },
+    { -50, -22, -1, 110 },
+    { -21, -44, -69, 127 },
+    { -53, 96, -13, -2 },
+    { 21, 9, -2, -43 },
+    { 64, -56, -2, 16 },
+    { -75, -46, 27, 74 },
+    { -44, 118, -19, -72 },
+    { -59, 56, 33, -18 },
+    { -42, -102, 116, -3 },
+    { -73, -14, 11, 62 },
+    { -8, -60, -59, 91 },
+};
+static const s32 nnB2[NN_OUTPUTS] = {
+    -301, -3725, 7922, -3897,
+};
+
+#endif // _NN_WEIGHTS_H_
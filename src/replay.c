@@ -0,0 +1,55 @@
+// Replay recorder: writes the running game into cartridge SRAM (see replay.h)
+
+#include "replay.h"
+
+static u32 replaySteps;                   // Steps recorded so far
+static u8 replayByte;                     // Moves not yet flushed (4 per byte)
+static u16 replayRecording;               // FALSE once the SRAM is full
+
+void replayBegin(const SimState* s, u16 policy) {
+    replaySteps = 0;
+    replayByte = 0;
+    replayRecording = TRUE;
+    SRAM_enable();
+    SRAM_writeLong(REPLAY_OFS_MAGIC, REPLAY_MAGIC);
+    SRAM_writeLong(REPLAY_OFS_SEED, s->seed);
+    SRAM_writeLong(REPLAY_OFS_STEPS, 0); // Incomplete until replayEnd()
+    SRAM_writeLong(REPLAY_OFS_HASH, 0);
+    SRAM_writeWord(REPLAY_OFS_SCORE, 0);
+    SRAM_writeByte(REPLAY_OFS_POLICY, policy);
+    SRAM_writeByte(REPLAY_OFS_VERSION, REPLAY_VERSION);
+    SRAM_writeByte(REPLAY_OFS_SPRITE_CAP, 0);
+    SRAM_writeByte(REPLAY_OFS_CAUSE, SIM_CAUSE_NONE);
+    SRAM_writeByte(REPLAY_OFS_FOOD_POLICY, s->foodPolicy);
+    SRAM_disable();
+}
+
+void replayRecord(u16 dir) {
+    if (!replayRecording) return;
+    replayByte |= (dir & 3) << ((replaySteps & 3) << 1);
+    replaySteps++;
+    if ((replaySteps & 3) == 0) { // Byte complete: one SRAM write every 4 steps
+        SRAM_enable();
+        SRAM_writeByte(REPLAY_HEADER_SIZE + ((replaySteps - 1) >> 2), replayByte);
+        SRAM_disable();
+        replayByte = 0;
+        if (replaySteps == REPLAY_MAX_STEPS) replayRecording = FALSE;
+    }
+}
+
+void replaySpriteCap(u16 maxLength) {
+    SRAM_enable();
+    SRAM_writeByte(REPLAY_OFS_SPRITE_CAP, maxLength);
+    SRAM_disable();
+}
+
+void replayEnd(const SimState* s, u16 cause) {
+    SRAM_enable();
+    if (replaySteps & 3) SRAM_writeByte(REPLAY_HEADER_SIZE + (replaySteps >> 2), replayByte);
+    SRAM_writeLong(REPLAY_OFS_HASH, simHash(s));
+    SRAM_writeWord(REPLAY_OFS_SCORE, s->score);
+    SRAM_writeByte(REPLAY_OFS_CAUSE, cause);
+    SRAM_writeLong(REPLAY_OFS_STEPS, replaySteps);
+    SRAM_disable();
+    replayRecording = FALSE;
+}
@@ -0,0 +1,59 @@
+// Game replays in cartridge SRAM
+//
+// Overview:
+// A game is fully determined by its seed and the direction passed to each simStep() call, so a replay
+// is just those, packed 2 bits per step. The ROM records the current game into SRAM as it is played
+// (only the last game is kept); the host tools read the SRAM dump back, re-simulate it with the sim
+// core and check the final state hash.
+//
+// SRAM layout (byte offsets as used by SGDK's SRAM_* functions, multi-byte values big-endian):
+//   0   u32 REPLAY_MAGIC
+//   4   u32 seed passed to simInitGameEx()
+//   8   u32 number of steps (0 while the game is still running)
+//   12  u32 simHash() after the last step
+//   16  u16 final score
+//   18  u8  policy that played (REPLAY_POLICY_*)
+//   19  u8  REPLAY_VERSION
+//   20  u8  sprite cap: maxLength after the ROM ran out of body sprites (0 = never happened)
+//   21  u8  end cause (SIM_CAUSE_*; 0 in replays recorded before causes existed)
+//   22  u8  food placement policy passed to simInitGameEx() (SIM_FOOD_*; version 2 on, version 1 is uniform)
+//   32  moves, 4 per byte, first step in the lowest two bits
+//
+// Host side: tools/dsexport decodes dumps (see README).
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "sim.h"
+
+#define REPLAY_MAGIC 0x534E4B52 // "SNKR"
+#define REPLAY_VERSION 2
+#define REPLAY_HEADER_SIZE 32  // Moves start here
+#define REPLAY_SRAM_SIZE 0x8000 // First 32KB of the odd-byte SRAM declared in rom_head.c (heatmaps follow)
+#define REPLAY_MAX_STEPS ((u32)(REPLAY_SRAM_SIZE - REPLAY_HEADER_SIZE) * 4) // Longer games are truncated
+
+// Header field offsets
+#define REPLAY_OFS_MAGIC 0
+#define REPLAY_OFS_SEED 4
+#define REPLAY_OFS_STEPS 8
+#define REPLAY_OFS_HASH 12
+#define REPLAY_OFS_SCORE 16
+#define REPLAY_OFS_POLICY 18
+#define REPLAY_OFS_VERSION 19
+#define REPLAY_OFS_SPRITE_CAP 20
+#define REPLAY_OFS_CAUSE 21
+#define REPLAY_OFS_FOOD_POLICY 22
+
+// Who played the recorded game
+#define REPLAY_POLICY_HUMAN 0
+#define REPLAY_POLICY_AI 1
+#define REPLAY_POLICY_NN 2
+
+#ifndef SIM_HOST
+void replayBegin(const SimState* s, u16 policy); // Starts recording a new game (invalidates the previous one)
+void replayRecord(u16 dir);               // Records the direction of one simStep() call
+void replaySpriteCap(u16 maxLength);      // Records the length cap applied when body sprites ran out
+void replayEnd(const SimState* s, u16 cause); // Finishes the replay (steps, hash, score, end cause)
+#endif
+
+#endif // _REPLAY_H_
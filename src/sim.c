@@ -0,0 +1,945 @@
+// Snake simulation core shared by the ROM and the host tools (see sim.h)
+
+#include "sim.h"
+
+static u32 zobristKeys[GRID_WIDTH * GRID_HEIGHT]; // Random key per grid cell
+
+// Local helpers
+static void generateFood(SimState* s, u16* events); // Places new food using free tile list
+static void freeTileAdd(SimState* s, Point p);       // Appends a tile to the free list
+static void freeTileRemove(SimState* s, Point p);    // Removes a tile from the free list (if present)
+static void rebuildHash(SimState* s);                // Recomputes the cell hash from scratch
+static void sortWalls(SimState* s);                  // Orders wall runs by row/column and builds the index
+static u16 wallAt(const SimState* s, s16 x, s16 y);  // Indexed wall test for an on-grid cell
+static void bodyBoundsReset(SimState* s);            // Recomputes the body bounding box and counts
+static void bodyBoundsAdd(SimState* s, Point p);     // Updates the box after a segment entered p
+static void bodyBoundsRemove(SimState* s, Point p);  // Updates the box after a segment left p
+#if SIM_FOOD_REGIONS
+static void regionsReset(SimState* s);               // Empties the regions and locates the portal tiles
+static void regionsBuild(SimState* s, const u8* occupied); // Labels the open cells of a new level
+static void regionOpen(SimState* s, Point p);        // p became open: joins the regions around it
+static void regionClose(SimState* s, Point p);       // p was taken: splits its region if p held it together
+static void regionsReach(SimState* s);               // Re-targets the reachable set on the head's regions
+static u16 regionsHideNear(SimState* s);             // Drops cells near the head from the reachable set
+static void regionsShowNear(SimState* s, u16 count); // Undoes regionsHideNear()
+static u16 regionReached(const SimRegions* r, u8 label); // TRUE if label is in the reachable set
+#endif
+
+// Scratch of one call: occupancy while a level is built, walk marks (all zero between calls) afterwards
+static SIM_THREAD_LOCAL u8 cellScratch[GRID_WIDTH * GRID_HEIGHT] SIM_WORD_ALIGNED;
+#if SIM_FOOD_REGIONS
+static SIM_THREAD_LOCAL u16 floodQueue[MAX_FREE_TILES + NUM_PORTALS * 2 + 2]; // Free tiles, food and head
+#endif
+
+// Cell keys: plain key for walls/body, key rotated by 8 for the head, key rotated by 16 for food
+#define CELL_KEY(p) (zobristKeys[(p).y * GRID_WIDTH + (p).x])
+#define CELL(p) ((p).y * GRID_WIDTH + (p).x)
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+// Set bits of a byte: the compiler's builtin on the host (POPCNT where the target has it), a table on the 68000
+#ifdef SIM_HOST
+#define POPCOUNT8(b) ((u16)__builtin_popcount(b))
+#else
+#define B2(n) n, n + 1, n + 1, n + 2
+#define B4(n) B2(n), B2(n + 1), B2(n + 1), B2(n + 2)
+#define B6(n) B4(n), B4(n + 1), B4(n + 1), B4(n + 2)
+const u8 simPopcount8[256] = { B6(0), B6(1), B6(1), B6(2) };
+#define POPCOUNT8(b) simPopcount8[b]
+#endif
+
+// With SIM_ASM the grid kernels come from sim_asm.s; the C versions below keep a C suffix
+#if SIM_ASM
+#define KERNEL(name) name##C
+// Layouts sim_asm.s relies on
+_Static_assert(sizeof(Point) == 4 && __builtin_offsetof(Point, y) == 2, "Point is one long: x high, y low");
+_Static_assert(FREE_MAP_ROW_BYTES == 5 && __builtin_offsetof(FreeMap, rowCount) == 140, "FreeMap layout");
+#else
+#define KERNEL(name) name
+#endif
+
+// Wall index keys: the row of a horizontal segment, GRID_HEIGHT + the column of a vertical one
+#define WALL_KEYS (GRID_HEIGHT + GRID_WIDTH)
+#define WALL_KEY(w) (WALL_IS_VERTICAL(w) ? GRID_HEIGHT + (w)->x : (w)->y)
+
+// Fills the Zobrist key table with xorshift32 output from a fixed seed (identical on every platform)
+void simInitKeys(void) {
+    u32 x = ZOBRIST_SEED;
+    for (u16 i = 0; i < GRID_WIDTH * GRID_HEIGHT; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        zobristKeys[i] = x;
+    }
+}
+
+// Returns the next 16-bit value of the game's xorshift32 generator
+u16 simRandom(SimState* s) {
+    u32 x = s->rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s->rngState = x;
+    return (u16)(x >> 16);
+}
+
+void simInitGame(SimState* s, u32 seed) {
+    simInitGameEx(s, seed, SIM_FOOD_UNIFORM);
+}
+
+// Resets game-wide state and builds level 1
+void simInitGameEx(SimState* s, u32 seed, u16 foodPolicy) {
+    s->foodPolicy = foodPolicy;
+    s->snakeLength = SNAKE_START_LENGTH;
+    s->maxLength = SNAKE_MAX_LENGTH;
+    for (u16 i = 0; i < s->snakeLength; i++) {
+        s->snakeBody[i].x = SNAKE_START_X - i; // Snake starts horizontally facing right
+        s->snakeBody[i].y = SNAKE_START_Y;
+    }
+    s->direction = DIR_RIGHT;
+    s->score = 0;
+    s->currentLevel = 1;
+    s->foodEatenThisLevel = 0;
+    s->foodTarget = 5;
+    s->food.x = 0;
+    s->food.y = 0;
+    s->seed = seed;
+    s->rngState = seed ^ 0x9E3779B9;
+    if (s->rngState == 0) s->rngState = ZOBRIST_SEED; // xorshift must not start at zero
+    s->stepCount = 0;
+    bodyBoundsReset(s);
+    simInitLevel(s);
+}
+
+// Builds portals, maze walls, free tile list and food for the current level (snake is preserved)
+void simInitLevel(SimState* s) {
+    u8* occupied = cellScratch;          // Snake and wall cells of the level being built
+    // Randomize portal positions
+    s->portals[0].entry.x = 5 + (simRandom(s) % (GRID_WIDTH - 10));
+    s->portals[0].entry.y = 1;
+    s->portals[0].exit.x = 5 + (simRandom(s) % (GRID_WIDTH - 10));
+    s->portals[0].exit.y = GRID_HEIGHT - 1;
+    s->portals[1].entry.x = 0;
+    s->portals[1].entry.y = 5 + (simRandom(s) % (GRID_HEIGHT - 10));
+    s->portals[1].exit.x = GRID_WIDTH - 1;
+    s->portals[1].exit.y = 5 + (simRandom(s) % (GRID_HEIGHT - 10));
+
+    // Occupancy grid: walls are marked as they are added, so every test below is a single lookup
+    simFillBytes(occupied, FALSE, GRID_WIDTH * GRID_HEIGHT);
+    for (u16 i = 0; i < s->snakeLength; i++) occupied[s->snakeBody[i].y * GRID_WIDTH + s->snakeBody[i].x] = TRUE;
+
+    // Generate random maze walls (tiles under the snake or already walled are skipped)
+    s->wallCount = 0;
+    s->wallSegmentCount = 0;
+    u16 numWalls = 5 + s->currentLevel;
+    if (numWalls > MAX_WALLS) numWalls = MAX_WALLS;
+    for (u16 w = 0; w < numWalls && s->wallCount < MAX_WALLS * 5; w++) {
+        const u16 isVertical = simRandom(s) % 2;
+        const u16 length = 3 + (simRandom(s) % 3);
+        s16 x, y, dx, dy;
+        if (isVertical) {
+            x = 2 + (simRandom(s) % (GRID_WIDTH - 4));
+            y = 3 + (simRandom(s) % (GRID_HEIGHT - length - 4));
+            dx = 0;
+            dy = 1;
+        } else {
+            x = 2 + (simRandom(s) % (GRID_WIDTH - length - 3));
+            y = 3 + (simRandom(s) % (GRID_HEIGHT - 5));
+            dx = 1;
+            dy = 0;
+        }
+        WallSegment* seg = &s->mazeWalls[s->wallSegmentCount];
+        seg->x = x;
+        seg->y = y;
+        seg->length = 0;
+        seg->flags = isVertical ? WALL_VERTICAL : 0;
+        for (u16 i = 0; i < length && x < GRID_WIDTH - 1 && y < GRID_HEIGHT - 1 && s->wallCount < MAX_WALLS * 5; i++) {
+            u8* cell = &occupied[y * GRID_WIDTH + x];
+            if (!*cell) {
+                *cell = TRUE;
+                seg->length = i + 1;
+                s->wallCount++;
+            } else {
+                seg->flags |= WALL_SKIP(i);
+            }
+            x += dx;
+            y += dy;
+        }
+        seg->flags &= WALL_VERTICAL | (WALL_SKIP(seg->length) - 1); // Trailing skips are cut off with the length
+        if (seg->length) s->wallSegmentCount++;                     // A segment with no wall tile is not kept
+    }
+
+    sortWalls(s);
+
+    // Build free tile list in one pass over the grid (row-major order, as food picks index into it)
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) regionsReset(s);
+#endif
+    s->freeTileCount = 0;
+#if SIM_FREE_BITMAP
+    simFreeMapClear(&s->freeMap);
+#endif
+    for (s16 y = 2; y < GRID_HEIGHT - 1; y++) {
+        const u8* row = &occupied[y * GRID_WIDTH];
+        for (s16 x = 1; x < GRID_WIDTH - 1; x++) {
+            if (!row[x]) {
+#if SIM_FREE_BITMAP
+                simFreeMapAdd(&s->freeMap, x, y);
+#else
+                s->freeTiles[s->freeTileCount].x = x;
+                s->freeTiles[s->freeTileCount].y = y;
+#endif
+                s->freeTileCount++;
+            }
+        }
+    }
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        freeTileAdd(s, s->portals[i].entry);
+        freeTileAdd(s, s->portals[i].exit);
+    }
+
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) regionsBuild(s, occupied);
+#endif
+
+    // Place initial food
+    u16 events = 0;
+    generateFood(s, &events);
+    rebuildHash(s);
+}
+
+// Computes where the head lands when moving in dir, applying portal teleportation
+void simNextHead(const SimState* s, u16 dir, Point* head) {
+    head->x = s->snakeBody[0].x + simDirDX[dir];
+    head->y = s->snakeBody[0].y + simDirDY[dir];
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        if (head->x == s->portals[i].entry.x && head->y == s->portals[i].entry.y) {
+            *head = s->portals[i].exit;
+            break;
+        }
+        else if (head->x == s->portals[i].exit.x && head->y == s->portals[i].exit.y) {
+            *head = s->portals[i].entry;
+            break;
+        }
+    }
+}
+
+// Wall test for any cell (off-grid cells are never walls)
+u16 simIsWall(const SimState* s, s16 x, s16 y) {
+    if (x < 0 || x >= GRID_WIDTH || y < 0 || y >= GRID_HEIGHT) return FALSE;
+    return wallAt(s, x, y);
+}
+
+// Checks collisions with borders (portals excepted), maze walls or snake body, cheapest test first
+u16 simIsBlocked(const SimState* s, s16 x, s16 y) {
+    if (x <= 0 || x >= GRID_WIDTH - 1 || y <= 1 || y >= GRID_HEIGHT - 1) {
+        u16 isPortal = FALSE;
+        for (u16 i = 0; i < NUM_PORTALS; i++) {
+            if ((x == s->portals[i].entry.x && y == s->portals[i].entry.y) ||
+                (x == s->portals[i].exit.x && y == s->portals[i].exit.y)) {
+                isPortal = TRUE;
+            }
+        }
+        if (!isPortal) return TRUE;
+    }
+    if (wallAt(s, x, y)) return TRUE;     // (x, y) is on the grid here: off-grid cells failed the border test
+    if (x < s->bodyMinX || x > s->bodyMaxX || y < s->bodyMinY || y > s->bodyMaxY) return FALSE;
+    return simBodyHit(&s->snakeBody[1], s->snakeLength - 1, x, y);
+}
+
+// Advances the game by one logic step in direction dir
+u16 simStep(SimState* s, u16 dir) {
+    u16 events = 0;
+    const Point oldHead = s->snakeBody[0];
+    const Point oldTail = s->snakeBody[s->snakeLength - 1];
+    const Point eatenFood = s->food;
+    Point head = { oldHead.x + simDirDX[dir], oldHead.y + simDirDY[dir] };
+
+    s->stepCount++;
+    s->direction = dir;
+
+    // Check food collision before and after teleportation
+    u16 ateFood = (head.x == s->food.x && head.y == s->food.y);
+    simNextHead(s, dir, &head);
+    ateFood |= (head.x == s->food.x && head.y == s->food.y);
+
+    if (simIsBlocked(s, head.x, head.y)) return SIM_EVENT_DEAD;
+
+    // Body follows the head; the tail cell is released unless the snake grows
+    u16 grew = FALSE;
+    if (ateFood && s->snakeLength < s->maxLength) {
+        for (u16 i = s->snakeLength; i > 0; i--) {
+            s->snakeBody[i] = s->snakeBody[i - 1];
+        }
+        s->snakeLength++;
+        grew = TRUE;
+        events |= SIM_EVENT_GREW;
+    } else {
+        for (u16 i = s->snakeLength - 1; i > 0; i--) {
+            s->snakeBody[i] = s->snakeBody[i - 1];
+        }
+#if SIM_FOOD_REGIONS
+        if (s->foodPolicy != SIM_FOOD_UNIFORM) regionOpen(s, oldTail);
+#endif
+        freeTileAdd(s, oldTail);
+        bodyBoundsRemove(s, oldTail);
+    }
+
+    // The head cell leaves the free list (the food cell already left it when the food was placed)
+    if (head.x != eatenFood.x || head.y != eatenFood.y) freeTileRemove(s, head);
+    s->snakeBody[0] = head;
+    bodyBoundsAdd(s, head);
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) {
+        regionClose(s, head);
+        regionsReach(s);
+    }
+#endif
+
+    // Incremental hash update: move head key, add new head cell, drop tail cell unless grown
+    const u32 oldHeadKey = CELL_KEY(oldHead);
+    const u32 newHeadKey = CELL_KEY(head);
+    s->cellHash ^= ROTL32(oldHeadKey, 8) ^ ROTL32(newHeadKey, 8) ^ newHeadKey;
+    if (!grew) s->cellHash ^= CELL_KEY(oldTail);
+
+    if (ateFood) {
+        events |= SIM_EVENT_ATE;
+        // Food taken on a portal entry while the head lands on the exit frees the entry tile again
+        if (head.x != eatenFood.x || head.y != eatenFood.y) freeTileAdd(s, eatenFood);
+        s->foodEatenThisLevel++;
+        s->score += 10;
+        if (s->foodEatenThisLevel >= s->foodTarget) { // Level complete
+            s->currentLevel++;
+            s->foodEatenThisLevel = 0;
+            s->foodTarget = 5 + (s->currentLevel - 1) * 5;
+            events |= SIM_EVENT_LEVEL_UP;
+        } else {
+            generateFood(s, &events);
+        }
+    }
+#if SIM_FOOD_REGIONS
+    else if (s->food.y == 0 && s->foodPolicy != SIM_FOOD_UNIFORM && s->regions.reachFree) {
+        generateFood(s, &events);         // Food held back until the head reaches a free tile again
+        events |= SIM_EVENT_FOOD;
+    }
+#endif
+    return events;
+}
+
+// Removes the last body segment and returns its tile to the free list
+void simTrimTail(SimState* s) {
+    if (s->snakeLength <= 1) return;
+    s->snakeLength--;
+    const Point tail = s->snakeBody[s->snakeLength];
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) regionOpen(s, tail);
+#endif
+    freeTileAdd(s, tail);
+    bodyBoundsRemove(s, tail);
+    s->cellHash ^= CELL_KEY(tail);
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) regionsReach(s);
+#endif
+}
+
+// Moves the food to a random free tile (the old food tile stays taken, as if eaten); used by the analysis tools
+u16 simPlaceFood(SimState* s) {
+    u16 events = 0;
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) { // Taken like the head cell that would have eaten it
+        regionClose(s, s->food);
+        regionsReach(s);
+    }
+#endif
+    generateFood(s, &events);
+    return events;
+}
+
+// Returns the full state hash: cell hash mixed with the packed score/level/direction scalars
+u32 simHash(const SimState* s) {
+    return s->cellHash ^ (((u32)s->score << 16) | ((u32)(s->currentLevel & 0xFF) << 8) | s->direction);
+}
+
+const char* const simCauseNames[SIM_CAUSE_COUNT] = { "none", "border", "wall", "self", "sprite_limit", "board_full" };
+const char* const simFoodPolicyNames[SIM_FOOD_COUNT] = { "uniform", "reachable", "distant" };
+
+const s8 simDirDX[4] = { 0, 1, 0, -1 };
+const s8 simDirDY[4] = { -1, 0, 1, 0 };
+const s16 simDirCell[4] = { -GRID_WIDTH, 1, GRID_WIDTH, -1 };
+const u8 simDirOpposite[4] = { DIR_DOWN, DIR_LEFT, DIR_UP, DIR_RIGHT };
+
+// Classifies why a step ended the game; simStep() already stored the fatal direction and left the snake in place
+u16 simEndCause(const SimState* s, u16 events) {
+    if (events & SIM_EVENT_WIN) return SIM_CAUSE_BOARD_FULL;
+    if (!(events & SIM_EVENT_DEAD)) return SIM_CAUSE_NONE;
+    Point head;
+    simNextHead(s, s->direction, &head);
+    for (u16 i = 1; i < s->snakeLength; i++) {
+        if (s->snakeBody[i].x == head.x && s->snakeBody[i].y == head.y) return SIM_CAUSE_SELF;
+    }
+    if (simIsWall(s, head.x, head.y)) return SIM_CAUSE_WALL;
+    return SIM_CAUSE_BORDER;
+}
+
+// Places new food at a random free tile; non-uniform policies draw from the reachable set (see SimRegions)
+static void generateFood(SimState* s, u16* events) {
+    if (s->freeTileCount == 0) {
+        *events |= SIM_EVENT_WIN;
+        return;
+    }
+
+    const u32 oldFoodKey = CELL_KEY(s->food);
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) {
+        SimRegions* r = &s->regions;
+        u16 near = 0;                     // Cells regionsHideNear() took out of the set
+        if (s->foodPolicy == SIM_FOOD_DISTANT) {
+            near = regionsHideNear(s);
+            if (!r->reachFree) {          // Nothing far enough: any reachable tile
+                regionsShowNear(s, near);
+                near = 0;
+            }
+        }
+        if (!r->reachFree) {              // Boxed in: no food until a later step reaches a free tile
+            s->food.x = 0;
+            s->food.y = 0;
+            *events |= SIM_EVENT_NO_FOOD;
+        } else {
+            simFreeMapSelect(&r->reachMap, simRandom(s) % r->reachFree, &s->food);
+            regionsShowNear(s, near);
+            freeTileRemove(s, s->food);
+        }
+        const u32 newFoodKey = CELL_KEY(s->food);
+        s->cellHash ^= ROTL32(oldFoodKey, 16) ^ ROTL32(newFoodKey, 16);
+        return;
+    }
+#endif
+
+    const u16 pick = simRandom(s) % s->freeTileCount;
+#if SIM_FREE_BITMAP
+    simFreeMapSelect(&s->freeMap, pick, &s->food);
+    simFreeMapRemove(&s->freeMap, s->food.x, s->food.y);
+#else
+    s->food = s->freeTiles[pick];
+    s->freeTiles[pick] = s->freeTiles[s->freeTileCount - 1];
+#endif
+    s->freeTileCount--;
+    const u32 newFoodKey = CELL_KEY(s->food);
+    s->cellHash ^= ROTL32(oldFoodKey, 16) ^ ROTL32(newFoodKey, 16);
+}
+
+// The reachable set follows the free set: a free cell is in it while its region is reached
+static void freeTileAdd(SimState* s, Point p) {
+#if SIM_FREE_BITMAP
+    s->freeTileCount += simFreeMapAdd(&s->freeMap, p.x, p.y);
+#else
+    s->freeTiles[s->freeTileCount] = p;
+    s->freeTileCount++;
+#endif
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) {
+        SimRegions* r = &s->regions;
+        if (regionReached(r, r->label[CELL(p)])) r->reachFree += simFreeMapAdd(&r->reachMap, p.x, p.y);
+    }
+#endif
+}
+
+static void freeTileRemove(SimState* s, Point p) {
+#if SIM_FOOD_REGIONS
+    if (s->foodPolicy != SIM_FOOD_UNIFORM) s->regions.reachFree -= simFreeMapRemove(&s->regions.reachMap, p.x, p.y);
+#endif
+#if SIM_FREE_BITMAP
+    s->freeTileCount -= simFreeMapRemove(&s->freeMap, p.x, p.y);
+#else
+    for (u16 i = 0; i < s->freeTileCount; i++) {
+        if (s->freeTiles[i].x == p.x && s->freeTiles[i].y == p.y) {
+            s->freeTiles[i] = s->freeTiles[s->freeTileCount - 1];
+            s->freeTileCount--;
+            return;
+        }
+    }
+#endif
+}
+
+#if SIM_FOOD_REGIONS
+// Region graph over the open cells: a move between two playfield cells links them, and an open portal pair
+// (both tiles open) links its tiles to each other and to the inward cells next to them. A pair with a tile
+// under the body links nothing, so no link stands for a one-way trip: the head can move both ways between
+// any two cells of a region, and every free cell of a region next to the head is reachable.
+#define REGION_LINKS_MAX 6                // Four moves and the two tiles of an open pair
+
+static u16 regionReached(const SimRegions* r, u8 label) {
+    for (u16 i = 0; i < r->reachCount; i++) {
+        if (r->reach[i] == label) return TRUE;
+    }
+    return FALSE;
+}
+
+static void regionUnreach(SimRegions* r, u8 label) {
+    for (u16 i = 0; i < r->reachCount; i++) {
+        if (r->reach[i] == label) {
+            r->reach[i] = r->reach[--r->reachCount];
+            return;
+        }
+    }
+}
+
+// Unused label for a region that starts at cell c (its size is the caller's to set). Labels do not run out:
+// 254 regions would take far more closed cells than the walls and the body hold
+static u8 regionNew(SimRegions* r, u16 c) {
+    u8 label = 1;
+    while (label < SIM_REGION_MARK - 1 && r->size[label]) label++;
+    r->seed[label] = c;
+    return label;
+}
+
+// Links of cell c into out (c open, or the head's cell); returns their count
+static u16 regionLinks(const SimState* s, u16 c, u16* out) {
+    const SimRegions* r = &s->regions;
+    const u8* label = r->label;
+    u16 n = 0;
+    u16 skip = 0;                         // The portal tile next to c links through its pair only
+    for (u16 k = 0; k < NUM_PORTALS * 2; k++) {
+        const u16 open = label[r->tile[k]] && label[r->tile[k ^ 1]];
+        if (r->tile[k] == c) {
+            if (open) {
+                out[n++] = r->tile[k ^ 1];
+                if (label[r->inward[k]]) out[n++] = r->inward[k];
+                if (label[r->inward[k ^ 1]]) out[n++] = r->inward[k ^ 1];
+            }
+            return n;
+        }
+        if (r->inward[k] == c) {
+            skip = r->tile[k];
+            if (open) {
+                out[n++] = r->tile[k];
+                out[n++] = r->tile[k ^ 1];
+            }
+        }
+    }
+    for (u16 dir = 0; dir < 4; dir++) {
+        const u16 next = c + simDirCell[dir];
+        if (label[next] && next != skip) out[n++] = next;
+    }
+    return n;
+}
+
+// The head moves out along its cell's links; from a portal tile (where it landed) only to the inward cell
+static u16 headLinks(const SimState* s, u16* out) {
+    const SimRegions* r = &s->regions;
+    const u16 head = CELL(s->snakeBody[0]);
+    for (u16 k = 0; k < NUM_PORTALS * 2; k++) {
+        if (r->tile[k] == head) {
+            out[0] = r->inward[k];
+            return r->label[r->inward[k]] ? 1 : 0;
+        }
+    }
+    return regionLinks(s, head, out);
+}
+
+// Walks the cells labelled from that link to start, labels them to, and moves their free cells into
+// (bits > 0) or out of (bits < 0) the reachable set. The cells walked are left in floodQueue[0 .. count)
+static u16 regionRelabel(SimState* s, u16 start, u8 from, u8 to, s16 bits) {
+    SimRegions* r = &s->regions;
+    const u16 food = CELL(s->food);
+    u16 links[REGION_LINKS_MAX];
+    u16 count = 0;
+    r->label[start] = to;
+    floodQueue[count++] = start;
+    for (u16 i = 0; i < count; i++) {
+        const u16 c = floodQueue[i];
+        if (bits && c != food) {          // Open cells are free but for the food
+            const s16 x = c % GRID_WIDTH;
+            const s16 y = c / GRID_WIDTH;
+            if (bits > 0) r->reachFree += simFreeMapAdd(&r->reachMap, x, y);
+            else r->reachFree -= simFreeMapRemove(&r->reachMap, x, y);
+        }
+        const u16 n = regionLinks(s, c, links);
+        for (u16 j = 0; j < n; j++) {
+            if (r->label[links[j]] == from) {
+                r->label[links[j]] = to;
+                floodQueue[count++] = links[j];
+            }
+        }
+    }
+    return count;
+}
+
+// Moves a whole region's free cells into or out of the reachable set
+static void regionPaint(SimState* s, u8 label, s16 bits) {
+    const u16 count = regionRelabel(s, s->regions.seed[label], label, SIM_REGION_MARK, bits);
+    for (u16 i = 0; i < count; i++) s->regions.label[floodQueue[i]] = label;
+}
+
+static u16 regionWalk(const u8* parent, u16 w) {
+    while (parent[w] != w) w = parent[w];
+    return w;
+}
+
+// Closing a cell can cut its region apart. A breadth-first walk starts from each of the cell's links, all in
+// lockstep through one queue; walks that meet merge, and the split is settled as soon as at most one walk
+// still grows, so the cost follows the smaller pieces. Each finished walk but the kept one (the one still
+// growing, else the largest) becomes a region of its own, reached if the old region was
+static void regionSplit(SimState* s, u8 label, const u16* links, u16 n) {
+    SimRegions* r = &s->regions;
+    u8* walk = cellScratch;               // 1 + the walk that visited a cell
+    u8 parent[REGION_LINKS_MAX];          // A merged walk points at the walk it joined
+    u16 queued[REGION_LINKS_MAX];         // Cells queued but not expanded yet, per walk
+    u16 size[REGION_LINKS_MAX];           // Cells visited, per walk
+    u16 next[REGION_LINKS_MAX];
+    u16 count = 0;
+    for (u16 i = 0; i < n; i++) {
+        walk[links[i]] = i + 1;
+        parent[i] = i;
+        queued[i] = 1;
+        floodQueue[count++] = links[i];
+    }
+    u16 walks = n;                        // Walks that have not joined another
+    u16 growing = n;                      // Of those, the ones with cells queued
+    for (u16 i = 0; walks > 1 && growing > 1; i++) {
+        const u16 c = floodQueue[i];
+        const u16 w = regionWalk(parent, walk[c] - 1);
+        const u16 k = regionLinks(s, c, next);
+        for (u16 j = 0; j < k; j++) {
+            u8* mark = &walk[next[j]];
+            if (!*mark) {
+                *mark = w + 1;
+                floodQueue[count++] = next[j];
+                queued[w]++;
+            } else {
+                const u16 other = regionWalk(parent, *mark - 1);
+                if (other == w) continue;
+                parent[other] = w;        // Both were growing: a finished walk has no unvisited links
+                queued[w] += queued[other];
+                walks--;
+                growing--;
+            }
+        }
+        if (--queued[w] == 0) growing--;
+    }
+
+    if (walks > 1) {
+        u16 keep = n;
+        for (u16 i = 0; i < n; i++) size[i] = 0;
+        for (u16 i = 0; i < count; i++) size[regionWalk(parent, walk[floodQueue[i]] - 1)]++;
+        for (u16 i = 0; i < n; i++) {
+            if (parent[i] == i && queued[i]) keep = i;
+        }
+        if (keep == n) {
+            for (u16 i = 0; i < n; i++) {
+                if (parent[i] == i && (keep == n || size[i] > size[keep])) keep = i;
+            }
+        }
+        const u16 reached = regionReached(r, label);
+        for (u16 i = 0; i < n; i++) {
+            if (parent[i] != i || i == keep) continue;
+            const u8 piece = regionNew(r, links[i]);
+            r->size[piece] = size[i];
+            r->size[label] -= size[i];
+            for (u16 j = 0; j < count; j++) {
+                if (regionWalk(parent, walk[floodQueue[j]] - 1) == i) r->label[floodQueue[j]] = piece;
+            }
+            if (reached) r->reach[r->reachCount++] = piece;
+        }
+        r->seed[label] = links[keep];
+    }
+    for (u16 i = 0; i < count; i++) walk[floodQueue[i]] = 0;
+}
+
+static void regionsReset(SimState* s) {
+    SimRegions* r = &s->regions;
+    simFillBytes(r->label, 0, sizeof(r->label));
+    for (u16 i = 0; i < SIM_REGION_MARK; i++) r->size[i] = 0;
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        r->tile[i * 2] = CELL(s->portals[i].entry);
+        r->tile[i * 2 + 1] = CELL(s->portals[i].exit);
+    }
+    r->inward[0] = r->tile[0] + GRID_WIDTH; // Top, bottom, left and right border (simInitLevel's layout)
+    r->inward[1] = r->tile[1] - GRID_WIDTH;
+    r->inward[2] = r->tile[2] + 1;
+    r->inward[3] = r->tile[3] - 1;
+    r->reachCount = 0;
+    simFreeMapClear(&r->reachMap);
+    r->reachFree = 0;
+}
+
+// Open cells of a new level (before its food): the playfield cells and portal tiles the snake left empty
+static void regionsBuild(SimState* s, const u8* occupied) {
+    SimRegions* r = &s->regions;
+    for (u16 y = 2; y < GRID_HEIGHT - 1; y++) {
+        for (u16 x = 1; x < GRID_WIDTH - 1; x++) {
+            if (!occupied[y * GRID_WIDTH + x]) r->label[y * GRID_WIDTH + x] = SIM_REGION_MARK;
+        }
+    }
+    for (u16 k = 0; k < NUM_PORTALS * 2; k++) {
+        if (!occupied[r->tile[k]]) r->label[r->tile[k]] = SIM_REGION_MARK;
+    }
+    simFillBytes(cellScratch, 0, sizeof(cellScratch)); // Done with occupancy: walk marks start clear
+    for (u16 c = 0; c < GRID_WIDTH * GRID_HEIGHT; c++) {
+        if (r->label[c] == SIM_REGION_MARK) {
+            const u8 label = regionNew(r, c);
+            r->size[label] = regionRelabel(s, c, SIM_REGION_MARK, label, 0);
+        }
+    }
+    regionsReach(s);
+}
+
+// A released cell joins the regions it links to, under the largest one's label. If one of them was
+// reached, so is the merged region
+static void regionOpen(SimState* s, Point p) {
+    SimRegions* r = &s->regions;
+    const u16 c = CELL(p);
+    u16 links[REGION_LINKS_MAX];
+    if (p.x <= 0 || p.x >= GRID_WIDTH - 1 || p.y <= 1 || p.y >= GRID_HEIGHT - 1) {
+        u16 k = 0;
+        while (k < NUM_PORTALS * 2 && r->tile[k] != c) k++;
+        if (k == NUM_PORTALS * 2) return; // Border cell left by a segment that came through an old portal
+    }
+    r->label[c] = SIM_REGION_MARK;        // Open while its links are read (a portal tile opens its pair)
+    const u16 n = regionLinks(s, c, links);
+    u8 keep = 0;
+    u16 reached = FALSE;
+    for (u16 i = 0; i < n; i++) {
+        const u8 label = r->label[links[i]];
+        if (!keep || r->size[label] > r->size[keep]) keep = label;
+        reached |= regionReached(r, label);
+    }
+    if (!keep) {
+        keep = regionNew(r, c);
+    } else if (reached && !regionReached(r, keep)) {
+        regionPaint(s, keep, 1);
+        r->reach[r->reachCount++] = keep;
+    }
+    for (u16 i = 0; i < n; i++) {
+        const u8 label = r->label[links[i]];
+        if (label == keep) continue;
+        regionRelabel(s, links[i], label, keep, reached && !regionReached(r, label));
+        r->size[keep] += r->size[label];
+        r->size[label] = 0;
+        regionUnreach(r, label);
+    }
+    r->label[c] = keep;
+    r->size[keep]++;
+}
+
+static void regionClose(SimState* s, Point p) {
+    SimRegions* r = &s->regions;
+    const u16 c = CELL(p);
+    const u8 label = r->label[c];
+    if (!label) return;
+    u16 links[REGION_LINKS_MAX];
+    const u16 n = regionLinks(s, c, links);
+    r->label[c] = 0;
+    if (--r->size[label] == 0) {
+        regionUnreach(r, label);
+        return;
+    }
+    if (r->seed[label] == c) r->seed[label] = links[0];
+    if (n > 1) regionSplit(s, label, links, n);
+}
+
+// The regions linked to the head are the reached ones; a region that joins or leaves the set is walked once
+static void regionsReach(SimState* s) {
+    SimRegions* r = &s->regions;
+    u16 links[REGION_LINKS_MAX];
+    u8 next[REGION_LINKS_MAX];
+    u16 count = 0;
+    const u16 n = headLinks(s, links);
+    for (u16 i = 0; i < n; i++) {
+        const u8 label = r->label[links[i]];
+        u16 j = 0;
+        while (j < count && next[j] != label) j++;
+        if (j == count) next[count++] = label;
+    }
+    for (u16 i = 0; i < r->reachCount;) {
+        u16 j = 0;
+        while (j < count && next[j] != r->reach[i]) j++;
+        if (j < count) {
+            i++;
+            continue;
+        }
+        regionPaint(s, r->reach[i], -1);
+        r->reach[i] = r->reach[--r->reachCount];
+    }
+    for (u16 i = 0; i < count; i++) {
+        if (regionReached(r, next[i])) continue;
+        regionPaint(s, next[i], 1);
+        r->reach[r->reachCount++] = next[i];
+    }
+}
+
+// Breadth-first from the head over the links: the cells fewer than SIM_FOOD_MIN_DISTANCE moves away leave
+// the reachable set (cellScratch marks the ones taken out). Returns the cells walked, left in floodQueue
+static u16 regionsHideNear(SimState* s) {
+    SimRegions* r = &s->regions;
+    u8* dist = cellScratch;
+    u16 links[REGION_LINKS_MAX];
+    u16 count = headLinks(s, floodQueue);
+    for (u16 i = 0; i < count; i++) dist[floodQueue[i]] = 1;
+    for (u16 i = 0; i < count; i++) {
+        const u16 c = floodQueue[i];
+        if (dist[c] == SIM_FOOD_MIN_DISTANCE - 1) continue;
+        const u16 n = regionLinks(s, c, links);
+        for (u16 j = 0; j < n; j++) {
+            if (dist[links[j]]) continue;
+            dist[links[j]] = dist[c] + 1;
+            floodQueue[count++] = links[j];
+        }
+    }
+    for (u16 i = 0; i < count; i++) {
+        const u16 c = floodQueue[i];
+        dist[c] = simFreeMapRemove(&r->reachMap, c % GRID_WIDTH, c / GRID_WIDTH);
+        r->reachFree -= dist[c];
+    }
+    return count;
+}
+
+static void regionsShowNear(SimState* s, u16 count) {
+    for (u16 i = 0; i < count; i++) {
+        const u16 c = floodQueue[i];
+        if (cellScratch[c]) s->regions.reachFree += simFreeMapAdd(&s->regions.reachMap, c % GRID_WIDTH, c / GRID_WIDTH);
+        cellScratch[c] = 0;
+    }
+}
+#endif
+
+void simFreeMapClear(FreeMap* m) {
+    for (u16 y = 0; y < GRID_HEIGHT; y++) {
+        for (u16 b = 0; b < FREE_MAP_ROW_BYTES; b++) m->bits[y][b] = 0;
+        m->rowCount[y] = 0;
+    }
+}
+
+u16 simFreeMapAdd(FreeMap* m, s16 x, s16 y) {
+    u8* byte = &m->bits[y][x >> 3];
+    const u8 bit = 0x80 >> (x & 7);
+    if (*byte & bit) return FALSE;
+    *byte |= bit;
+    m->rowCount[y]++;
+    return TRUE;
+}
+
+u16 simFreeMapRemove(FreeMap* m, s16 x, s16 y) {
+    u8* byte = &m->bits[y][x >> 3];
+    const u8 bit = 0x80 >> (x & 7);
+    if (!(*byte & bit)) return FALSE;
+    *byte &= ~bit;
+    m->rowCount[y]--;
+    return TRUE;
+}
+
+// Skips whole rows by their counts, then whole bytes by popcount, then walks the bits of one byte;
+// rank must be below the number of free cells
+void KERNEL(simFreeMapSelect)(const FreeMap* m, u16 rank, Point* p) {
+    u16 y = 0;
+    while (rank >= m->rowCount[y]) rank -= m->rowCount[y++];
+    const u8* row = m->bits[y];
+    u16 b = 0;
+    while (rank >= POPCOUNT8(row[b])) rank -= POPCOUNT8(row[b++]);
+    u8 bits = row[b];
+    u16 x = b * 8;
+    for (;; bits <<= 1, x++) {
+        if ((bits & 0x80) && rank-- == 0) break;
+    }
+    p->x = x;
+    p->y = y;
+}
+
+void KERNEL(simFillBytes)(u8* dst, u8 value, u16 count) {
+    for (u16 i = 0; i < count; i++) dst[i] = value;
+}
+
+void KERNEL(simFillWords)(u16* dst, u16 value, u16 count) {
+    for (u16 i = 0; i < count; i++) dst[i] = value;
+}
+
+void KERNEL(simStampRun)(u16* dst, u16 value, u16 length, u16 stride) {
+    for (u16 i = 0; i < length; i++, dst += stride) *dst = value;
+}
+
+u16 KERNEL(simBodyHit)(const Point* body, u16 count, s16 x, s16 y) {
+    for (u16 i = 0; i < count; i++) {
+        if (body[i].x == x && body[i].y == y) return TRUE;
+    }
+    return FALSE;
+}
+
+// Recomputes the cell part of the state hash (walls, body, head, food); used on level setup
+static void rebuildHash(SimState* s) {
+    u32 h = 0;
+    for (u16 i = 0; i < s->wallSegmentCount; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        for (u16 k = 0; k < w->length; k++) {
+            if (!WALL_SKIPPED(w, k)) h ^= zobristKeys[WALL_TILE_Y(w, k) * GRID_WIDTH + WALL_TILE_X(w, k)];
+        }
+    }
+    for (u16 i = 0; i < s->snakeLength; i++) h ^= CELL_KEY(s->snakeBody[i]);
+    const u32 headKey = CELL_KEY(s->snakeBody[0]);
+    const u32 foodKey = CELL_KEY(s->food);
+    h ^= ROTL32(headKey, 8);
+    h ^= ROTL32(foodKey, 16);
+    s->cellHash = h;
+}
+
+// Counting sort of the wall segments by key; wallStart[k] ends up as the first segment of key k
+static void sortWalls(SimState* s) {
+    static SIM_THREAD_LOCAL WallSegment sorted[MAX_WALLS];
+    u8* start = s->wallStart;
+    for (u16 k = 0; k <= WALL_KEYS; k++) start[k] = 0;
+    for (u16 i = 0; i < s->wallSegmentCount; i++) start[WALL_KEY(&s->mazeWalls[i]) + 1]++;
+    for (u16 k = 1; k <= WALL_KEYS; k++) start[k] += start[k - 1];
+    for (u16 i = 0; i < s->wallSegmentCount; i++) sorted[start[WALL_KEY(&s->mazeWalls[i])]++] = s->mazeWalls[i];
+    for (u16 k = WALL_KEYS; k > 0; k--) start[k] = start[k - 1]; // Shift the filled ends back to starts
+    start[0] = 0;
+    for (u16 i = 0; i < s->wallSegmentCount; i++) s->mazeWalls[i] = sorted[i];
+}
+
+// Only the horizontal segments of row y and the vertical segments of column x can cover (x, y)
+static u16 wallAt(const SimState* s, s16 x, s16 y) {
+    for (u16 i = s->wallStart[y]; i < s->wallStart[y + 1]; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        const u16 k = x - w->x;
+        if (k < w->length && !WALL_SKIPPED(w, k)) return TRUE;
+    }
+    for (u16 i = s->wallStart[GRID_HEIGHT + x]; i < s->wallStart[GRID_HEIGHT + x + 1]; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        const u16 k = y - w->y;
+        if (k < w->length && !WALL_SKIPPED(w, k)) return TRUE;
+    }
+    return FALSE;
+}
+
+u16 simWallRun(const WallSegment* w, u16* k) {
+    while (*k < w->length && WALL_SKIPPED(w, *k)) (*k)++;
+    u16 n = 0;
+    while (*k + n < w->length && !WALL_SKIPPED(w, *k + n)) n++;
+    return n;
+}
+
+static void bodyBoundsReset(SimState* s) {
+    for (u16 x = 0; x < GRID_WIDTH; x++) s->bodyColCount[x] = 0;
+    for (u16 y = 0; y < GRID_HEIGHT; y++) s->bodyRowCount[y] = 0;
+    s->bodyMinX = s->bodyMaxX = s->snakeBody[0].x;
+    s->bodyMinY = s->bodyMaxY = s->snakeBody[0].y;
+    for (u16 i = 0; i < s->snakeLength; i++) bodyBoundsAdd(s, s->snakeBody[i]);
+}
+
+static void bodyBoundsAdd(SimState* s, Point p) {
+    s->bodyColCount[p.x]++;
+    s->bodyRowCount[p.y]++;
+    if (p.x < s->bodyMinX) s->bodyMinX = p.x;
+    if (p.x > s->bodyMaxX) s->bodyMaxX = p.x;
+    if (p.y < s->bodyMinY) s->bodyMinY = p.y;
+    if (p.y > s->bodyMaxY) s->bodyMaxY = p.y;
+}
+
+// An edge only moves when its last segment leaves; it then skips the empty columns/rows (never past the body)
+static void bodyBoundsRemove(SimState* s, Point p) {
+    if (--s->bodyColCount[p.x] == 0) {
+        while (s->bodyColCount[s->bodyMinX] == 0) s->bodyMinX++;
+        while (s->bodyColCount[s->bodyMaxX] == 0) s->bodyMaxX--;
+    }
+    if (--s->bodyRowCount[p.y] == 0) {
+        while (s->bodyRowCount[s->bodyMinY] == 0) s->bodyMinY++;
+        while (s->bodyRowCount[s->bodyMaxY] == 0) s->bodyMaxY--;
+    }
+}
@@ -0,0 +1,245 @@
+// Snake simulation core shared by the ROM and the host tools
+//
+// Overview:
+// Pure game logic with no VDP, sprite or PSG calls: level generation (portals, maze walls, free tile
+// list), food placement, snake movement, collisions, scoring and level progression. All state lives in
+// one fixed-size SimState struct, so cloning a game is a plain struct copy and many games can run side
+// by side on the host. Randomness comes from a per-state xorshift32 generator, so a game is fully
+// determined by its seed and the sequence of directions fed to simStep().
+//
+// Build:
+// - ROM: compiled by SGDK's makefile.gen like any other file in src/ (types come from genesis.h).
+// - Host: compile with -DSIM_HOST (see tools/Makefile); types come from stdint.h.
+// - SIM_FREE_BITMAP=1 (ROM and host alike) keeps the free cells as a bitmap instead of the freeTiles[]
+//   list: 168 bytes instead of 3.8KB, O(1) per-step updates, a rank select per food. Food lands on other
+//   (equally uniform) cells, so games, replays and seed caches differ from the default build.
+// - SIM_ASM=1 (ROM only) takes the grid kernels below from hand-written 68000 assembly (sim_asm.s):
+//   MOVEM block fills, DBcc scan loops. Results are identical, so games and replays are unchanged.
+//   Untested: the assembly has not yet been assembled or run on a 68000 (see README).
+// - SIM_FOOD_REGIONS=1 (host; ROM builds given FOOD_POLICY or BENCH on the command line) keeps the open
+//   cells labelled by connected region, so the reachable and distant food policies pick from a set kept up
+//   to date as the body moves instead of flooding the board per food: 2.3KB of RAM per SimState. Without
+//   it every policy places food as uniform does.
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#ifndef SIM_FREE_BITMAP
+#define SIM_FREE_BITMAP 0
+#endif
+#ifndef SIM_ASM
+#define SIM_ASM 0
+#endif
+#ifndef SIM_FOOD_REGIONS
+#if defined(SIM_HOST) || (defined(FOOD_POLICY) && FOOD_POLICY) || (defined(BENCH) && BENCH)
+#define SIM_FOOD_REGIONS 1
+#else
+#define SIM_FOOD_REGIONS 0
+#endif
+#endif
+#if SIM_ASM && defined(SIM_HOST)
+#error "SIM_ASM=1 needs the 68000 kernels of sim_asm.s (ROM builds only)"
+#endif
+
+#ifdef SIM_HOST
+#include <stdint.h>
+#include <stdlib.h>
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+#define SIM_THREAD_LOCAL _Thread_local // Scratch buffers are per thread in the parallel host tools
+#else
+#include <genesis.h>
+#define SIM_THREAD_LOCAL
+#endif
+#define SIM_WORD_ALIGNED __attribute__((aligned(2))) // Byte grids the fill kernels write as longs
+
+// Game constants
+#define GRID_WIDTH 40          // Total grid width in tiles (including borders)
+#define GRID_HEIGHT 28         // Total grid height in tiles (including borders)
+#define SNAKE_START_X 20       // Snake head’s starting X position
+#define SNAKE_START_Y 14       // Snake head’s starting Y position
+#define SNAKE_START_LENGTH 3   // Initial snake length
+#define SNAKE_MAX_LENGTH 80    // Maximum snake length (limited by VDP sprite capacity: 80 sprites)
+#define MAX_WALLS 50           // Maximum number of maze wall segments (each up to 5 tiles)
+#define MAX_FREE_TILES ((GRID_WIDTH - 2) * (GRID_HEIGHT - 3)) // Max free tiles: 38x25 = 950
+#define FREE_MAP_ROW_BYTES ((GRID_WIDTH + 7) / 8) // Bytes per free bitmap row
+#define NUM_PORTALS 2          // Number of portal pairs (top-bottom, left-right)
+#define ZOBRIST_SEED 0x2545F491 // Fixed xorshift32 seed so hashes match across ROM, host and replays
+
+// Snake directions (correspond to head sprite frames)
+#define DIR_UP 0               // Up direction (frame 2)
+#define DIR_RIGHT 1            // Right direction (frame 1)
+#define DIR_DOWN 2             // Down direction (frame 0)
+#define DIR_LEFT 3             // Left direction (frame 3)
+
+// Step events (bit flags returned by simStep)
+#define SIM_EVENT_ATE 0x01     // Head reached the food
+#define SIM_EVENT_GREW 0x02    // Snake length increased
+#define SIM_EVENT_LEVEL_UP 0x04 // Food target reached; call simInitLevel() to build the next level
+#define SIM_EVENT_DEAD 0x08    // Collision with border, maze wall or body
+#define SIM_EVENT_WIN 0x10     // No free tile left for food
+#define SIM_EVENT_NO_FOOD 0x20 // Food policy found no free tile the head can reach: food stays off the board
+#define SIM_EVENT_FOOD 0x40    // Food held back by SIM_EVENT_NO_FOOD was placed (the head reaches a free tile again)
+
+// End causes (simEndCause); classified only on the step that ends the game, so normal steps pay nothing
+#define SIM_CAUSE_NONE 0       // Game still running (or stopped by a host step cap)
+#define SIM_CAUSE_BORDER 1     // Head hit the border outside a portal
+#define SIM_CAUSE_WALL 2       // Head hit a maze wall
+#define SIM_CAUSE_SELF 3       // Head hit the body
+#define SIM_CAUSE_SPRITE_LIMIT 4 // Growth refused because the ROM ran out of body sprites (not fatal)
+#define SIM_CAUSE_BOARD_FULL 5 // No free tile left for food (the win)
+#define SIM_CAUSE_COUNT 6
+
+// Food placement policies (simInitGameEx); every policy makes one generator draw per food placed, so a
+// seed builds the same mazes under each of them. When no tile qualifies, reachable and distant hold the
+// food back (SIM_EVENT_NO_FOOD) and place it on the first later step that has one (SIM_EVENT_FOOD)
+#define SIM_FOOD_UNIFORM 0     // Any free tile
+#define SIM_FOOD_REACHABLE 1   // Free tiles the head can reach now (body treated as fixed)
+#define SIM_FOOD_DISTANT 2     // Reachable tiles at least SIM_FOOD_MIN_DISTANCE moves from the head
+#define SIM_FOOD_COUNT 3
+#define SIM_FOOD_MIN_DISTANCE 8 // Fewer candidates fall back to reachable
+
+// Data structures
+typedef struct {
+    s16 x;                     // X position in tiles
+    s16 y;                     // Y position in tiles
+} Point;
+
+// One generated wall segment in 4 bytes. Tiles that were under the snake or already walled are skipped
+// (a skip bit each), so a segment can hold up to 3 runs; simWallRun() walks them for collision and drawing
+typedef struct {
+    u8 x;                      // First tile of the segment
+    u8 y;
+    u8 length;                 // Tiles spanned, skipped ones included (1..5; the last one is a wall)
+    u8 flags;                  // WALL_VERTICAL, plus WALL_SKIP(k) for each skipped tile k
+} WallSegment;
+
+#define WALL_VERTICAL 0x80     // The segment goes down from (x, y); else right
+#define WALL_SKIP(k) (1 << (k))
+
+// Tile k of a wall segment, and whether it was skipped (not a wall)
+#define WALL_IS_VERTICAL(w) ((w)->flags & WALL_VERTICAL)
+#define WALL_TILE_X(w, k) ((w)->x + (WALL_IS_VERTICAL(w) ? 0 : (k)))
+#define WALL_TILE_Y(w, k) ((w)->y + (WALL_IS_VERTICAL(w) ? (k) : 0))
+#define WALL_SKIPPED(w, k) ((w)->flags & WALL_SKIP(k))
+
+typedef struct {
+    u8 bits[GRID_HEIGHT][FREE_MAP_ROW_BYTES]; // 1 = free; bit 7 of a row's byte 0 is x = 0 (row-major order)
+    u8 rowCount[GRID_HEIGHT];             // Free cells per row (rank select skips whole rows)
+} FreeMap;
+
+typedef struct {
+    Point entry;               // Entry portal position
+    Point exit;                // Exit portal position
+} Portal;
+
+#define SIM_REGION_MARK 255    // Label of a cell being labelled; regions use 1..254
+#define SIM_REGION_REACH_MAX 16 // Reached regions: up to 6 next to the head, plus pieces split off in one step
+
+// Open cells (free or food) grouped into connected regions, updated as the tail releases a cell and the head
+// takes one. The head reaches the regions next to it; their free cells are the reachable food candidates
+typedef struct {
+    u8 label[GRID_WIDTH * GRID_HEIGHT];   // Region of each open cell, 0 = closed (border, wall, body)
+    u16 size[SIM_REGION_MARK];            // Open cells per label (0 = label unused)
+    u16 seed[SIM_REGION_MARK];            // One cell of each region, where a walk over it starts
+    u16 tile[NUM_PORTALS * 2];            // Portal tile cells: entry, exit of portal 0, then portal 1
+    u16 inward[NUM_PORTALS * 2];          // Playfield cell next to each portal tile
+    u8 reach[SIM_REGION_REACH_MAX];       // Labels of the regions the head reaches
+    u16 reachCount;
+    FreeMap reachMap;                     // Free cells of those regions
+    u16 reachFree;                        // Cells in reachMap
+} SimRegions;
+
+typedef struct {
+    Point snakeBody[SNAKE_MAX_LENGTH];    // Snake segments (head at index 0)
+    u16 snakeLength;                      // Current length of the snake
+    u16 maxLength;                        // Growth cap (ROM lowers it when sprites run out)
+    u16 direction;                        // Direction of the last step
+    Point food;                           // Current food position ((0, 0) while SIM_EVENT_NO_FOOD holds it back)
+    u16 score;                            // Player score
+    u16 currentLevel;                     // Current level number (starts at 1)
+    u16 foodEatenThisLevel;               // Food eaten in the current level
+    u16 foodTarget;                       // Target food count for current level
+    WallSegment mazeWalls[MAX_WALLS];     // Maze wall segments: horizontal ones sorted by row, then vertical ones by column
+    u16 wallSegmentCount;                 // Number of wall segments
+    u16 wallCount;                        // Total number of maze wall tiles
+    u8 wallStart[GRID_HEIGHT + GRID_WIDTH + 1]; // Segments of key k are mazeWalls[wallStart[k] .. wallStart[k + 1]);
+                                          // the key is y for horizontal segments, GRID_HEIGHT + x for vertical ones
+    s16 bodyMinX, bodyMaxX;               // Bounding box of all snake segments (collision early-out)
+    s16 bodyMinY, bodyMaxY;
+    u8 bodyColCount[GRID_WIDTH];          // Segments per column and row (keep the box exact as the tail leaves)
+    u8 bodyRowCount[GRID_HEIGHT];
+#if SIM_FREE_BITMAP
+    FreeMap freeMap;                      // Free tiles for food placement
+#else
+    Point freeTiles[MAX_FREE_TILES + NUM_PORTALS * 2]; // Free tile positions for food placement
+#endif
+    u16 freeTileCount;                    // Number of free tiles available
+    u16 foodPolicy;                       // SIM_FOOD_* used by every food placement of this game
+#if SIM_FOOD_REGIONS
+    SimRegions regions;                   // Reachable food candidates (kept only for non-uniform policies)
+#endif
+    Portal portals[NUM_PORTALS];          // Array of portal pairs
+    u32 seed;                             // Seed the game was started with
+    u32 rngState;                         // xorshift32 generator state
+    u32 cellHash;                         // Incremental Zobrist hash of wall, body, head and food cells
+    u32 stepCount;                        // Logic steps since game start
+} SimState;
+
+void simInitKeys(void);                   // Fills the Zobrist key table (call once at startup)
+void simInitGame(SimState* s, u32 seed);  // Resets game-wide state and builds level 1 (uniform food)
+void simInitGameEx(SimState* s, u32 seed, u16 foodPolicy); // Same with a SIM_FOOD_* placement policy
+void simInitLevel(SimState* s);           // Builds portals, maze, free tile list and food for currentLevel
+u16 simStep(SimState* s, u16 dir);        // Advances one logic step; returns SIM_EVENT_* flags
+void simTrimTail(SimState* s);            // Removes the last body segment (used when growth must be undone)
+u16 simRandom(SimState* s);               // Next 16-bit value from the game's generator
+u16 simPlaceFood(SimState* s);            // Moves the food as the policy does after a meal; SIM_EVENT_WIN if no free tile
+void simNextHead(const SimState* s, u16 dir, Point* head); // Head position after a move (portals applied)
+u16 simIsBlocked(const SimState* s, s16 x, s16 y); // TRUE if moving the head onto (x, y) is fatal
+u16 simIsWall(const SimState* s, s16 x, s16 y); // TRUE if (x, y) is a maze wall tile (any x, y)
+u16 simWallRun(const WallSegment* w, u16* k); // Next run of wall tiles from tile *k on: moves *k to it, returns its length
+u32 simHash(const SimState* s);           // Full state hash (cells mixed with score/level/direction)
+u16 simEndCause(const SimState* s, u16 events); // SIM_CAUSE_* of a step that returned DEAD or WIN
+
+// Free cell bitmap (the SIM_FREE_BITMAP food placement; always available to the benchmarks)
+void simFreeMapClear(FreeMap* m);
+u16 simFreeMapAdd(FreeMap* m, s16 x, s16 y);    // Marks (x, y) free; FALSE if it already was
+u16 simFreeMapRemove(FreeMap* m, s16 x, s16 y); // Marks (x, y) taken; FALSE if it already was
+void simFreeMapSelect(const FreeMap* m, u16 rank, Point* p); // Free cell number rank in row-major order
+
+// Grid kernels (the hot loops of collision, flood fill setup, food pick and playfield drawing). Fills
+// write whole longs: dst must be word aligned and count must cover a multiple of 4 bytes
+void simFillBytes(u8* dst, u8 value, u16 count);   // count bytes set to value
+void simFillWords(u16* dst, u16 value, u16 count); // count words set to value
+void simStampRun(u16* dst, u16 value, u16 length, u16 stride); // length words, stride words apart
+u16 simBodyHit(const Point* body, u16 count, s16 x, s16 y); // TRUE if one of count segments is (x, y)
+#if SIM_ASM
+// The C versions stay in the ROM under a C suffix, as the benchmark screen's reference
+void simFillBytesC(u8* dst, u8 value, u16 count);
+void simFillWordsC(u16* dst, u16 value, u16 count);
+void simStampRunC(u16* dst, u16 value, u16 length, u16 stride);
+u16 simBodyHitC(const Point* body, u16 count, s16 x, s16 y);
+void simFreeMapSelectC(const FreeMap* m, u16 rank, Point* p);
+#endif
+#ifndef SIM_HOST
+extern const u8 simPopcount8[256];        // Set bits per byte value (rank select in C and assembly)
+#endif
+
+extern const char* const simCauseNames[SIM_CAUSE_COUNT]; // Short names for traces and reports
+extern const char* const simFoodPolicyNames[SIM_FOOD_COUNT];
+
+// Direction tables indexed by DIR_* (sim core, policies, ROM input and head sprite code)
+extern const s8 simDirDX[4];              // Column step
+extern const s8 simDirDY[4];              // Row step
+extern const s16 simDirCell[4];           // Step of a row-major cell index (y * GRID_WIDTH + x)
+extern const u8 simDirOpposite[4];        // Reverse direction (the move a snake can never take)
+
+#endif // _SIM_H_
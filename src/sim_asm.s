@@ -0,0 +1,157 @@
+/*
+ * 68000 versions of the sim core's grid kernels (SIM_ASM=1, see sim.h)
+ *
+ * Overview:
+ * Drop-in replacements for the C kernels of sim.c with the same results: block fills store eight longs
+ * per MOVEM, scans and runs loop on DBRA/DBEQ with post-increment addressing. The C versions stay in
+ * the ROM as simXxxC and the benchmark screen (BENCH=1) times both on the same inputs.
+ *
+ * Calling convention (m68k-elf GCC): arguments on the stack in 4-byte slots (16-bit values in the low
+ * word, at +2), result in d0, d0-d1/a0-a1 free to use, every other register preserved.
+ */
+
+#if SIM_ASM
+
+/* Layouts from sim.h (checked by the _Static_asserts in sim.c) */
+#define FREE_MAP_ROW_COUNT 140      /* offsetof(FreeMap, rowCount) */
+
+        .text
+
+/*
+ * void simFillBytes(u8* dst, u8 value, u16 count)
+ * void simFillWords(u16* dst, u16 value, u16 count)
+ * Both spread value over a long and share the fill: leftover longs one by one, then 32 bytes per MOVEM,
+ * from the end of the buffer down (MOVEM only stores with predecrement)
+ */
+        .globl  simFillBytes
+        .globl  simFillWords
+
+simFillBytes:
+        move.b  11(%sp),%d0
+        move.b  %d0,%d1
+        lsl.w   #8,%d0
+        move.b  %d1,%d0             /* d0.w = value:value */
+        moveq   #0,%d1
+        move.w  14(%sp),%d1
+        lsr.w   #2,%d1              /* d1 = longs */
+        bra.s   fillLongs
+
+simFillWords:
+        move.w  10(%sp),%d0
+        moveq   #0,%d1
+        move.w  14(%sp),%d1
+        lsr.w   #1,%d1              /* d1 = longs */
+
+fillLongs:
+        movea.w %d0,%a1
+        swap    %d0
+        move.w  %a1,%d0             /* d0.l = value word twice */
+        movea.l 4(%sp),%a0
+        adda.l  %d1,%a0
+        adda.l  %d1,%a0
+        adda.l  %d1,%a0
+        adda.l  %d1,%a0             /* a0 = dst + longs * 4 */
+        movem.l %d2-%d7,-(%sp)
+        move.w  %d1,%d2
+        andi.w  #7,%d2
+        lsr.w   #3,%d1              /* d1 = blocks of 8 longs, d2 = leftover longs */
+        bra.s   2f
+1:      move.l  %d0,-(%a0)
+2:      dbra    %d2,1b
+        move.l  %d0,%d2
+        move.l  %d0,%d3
+        move.l  %d0,%d4
+        move.l  %d0,%d5
+        move.l  %d0,%d6
+        move.l  %d0,%d7
+        movea.l %d0,%a1
+        bra.s   4f
+3:      movem.l %d0/%d2-%d7/%a1,-(%a0)
+4:      dbra    %d1,3b
+        movem.l (%sp)+,%d2-%d7
+        rts
+
+/*
+ * void simStampRun(u16* dst, u16 value, u16 length, u16 stride)
+ * One word store and one address add per tile (stride 1: a row run, GRID_WIDTH: a column run)
+ */
+        .globl  simStampRun
+
+simStampRun:
+        movea.l 4(%sp),%a0
+        move.w  10(%sp),%d0
+        move.w  14(%sp),%d1
+        movea.w 18(%sp),%a1
+        adda.w  %a1,%a1             /* a1 = stride in bytes */
+        bra.s   2f
+1:      move.w  %d0,(%a0)
+        adda.w  %a1,%a0
+2:      dbra    %d1,1b
+        rts
+
+/*
+ * u16 simBodyHit(const Point* body, u16 count, s16 x, s16 y)
+ * A Point is one long (x high word, y low word): one CMP.L per segment, the loop ends on DBEQ
+ */
+        .globl  simBodyHit
+
+simBodyHit:
+        movea.l 4(%sp),%a0
+        move.w  10(%sp),%d1
+        move.w  14(%sp),%d0
+        swap    %d0
+        move.w  18(%sp),%d0         /* d0 = (x, y) as a Point */
+        subq.w  #1,%d1
+        bcs.s   2f                  /* No segment */
+1:      cmp.l   (%a0)+,%d0
+        dbeq    %d1,1b
+        bne.s   2f
+        moveq   #1,%d0
+        rts
+2:      moveq   #0,%d0
+        rts
+
+/*
+ * void simFreeMapSelect(const FreeMap* m, u16 rank, Point* p)
+ * Skips rows by rowCount[], bytes by simPopcount8[], then shifts the bits of one byte out through the
+ * carry; rank must be below the number of free cells
+ */
+        .globl  simFreeMapSelect
+
+simFreeMapSelect:
+        movem.l %d2-%d3,-(%sp)
+        movea.l 12(%sp),%a0         /* a0 = m->bits[0] */
+        move.w  18(%sp),%d0         /* d0 = rank */
+        lea     FREE_MAP_ROW_COUNT(%a0),%a1
+        moveq   #0,%d1
+1:      move.b  (%a1)+,%d1
+        sub.w   %d1,%d0
+        bcc.s   1b                  /* rank >= rowCount[y]: next row */
+        add.w   %d1,%d0             /* Rank within row y (below 40 from here on) */
+        move.l  %a1,%d2
+        sub.l   %a0,%d2
+        subi.w  #FREE_MAP_ROW_COUNT+1,%d2 /* d2 = y */
+        move.w  %d2,%d3
+        lsl.w   #2,%d3
+        add.w   %d2,%d3
+        adda.w  %d3,%a0             /* a0 = m->bits[y] (FREE_MAP_ROW_BYTES = 5) */
+        lea     simPopcount8,%a1
+        moveq   #-8,%d3
+2:      addq.w  #8,%d3              /* d3 = x of the byte */
+        move.b  (%a0)+,%d1
+        sub.b   (%a1,%d1.w),%d0
+        bcc.s   2b                  /* rank >= popcount: next byte */
+        add.b   (%a1,%d1.w),%d0     /* Rank within the byte */
+        subq.w  #1,%d3
+3:      addq.w  #1,%d3
+        add.b   %d1,%d1             /* Carry = bit of x */
+        bcc.s   3b
+        subq.b  #1,%d0
+        bcc.s   3b                  /* Free but rank > 0: keep going */
+        movea.l 20(%sp),%a0
+        move.w  %d3,(%a0)+          /* p->x */
+        move.w  %d2,(%a0)           /* p->y */
+        movem.l (%sp)+,%d2-%d3
+        rts
+
+#endif
@@ -0,0 +1,115 @@
+// Imitation learning dataset files (see dataset.h)
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "nn.h"
+
+_Static_assert(sizeof(DatasetHeader) == 32, "dataset header layout");
+_Static_assert(sizeof(DatasetRecord) == 32, "dataset record layout");
+_Static_assert(NN_INPUTS <= 64, "features must fit the 64-bit bitset");
+
+static void initHeader(DatasetHeader* h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, DATASET_MAGIC, sizeof(h->magic));
+    h->version = DATASET_VERSION;
+    h->headerSize = sizeof(DatasetHeader);
+    h->recordSize = sizeof(DatasetRecord);
+    h->featureCount = NN_INPUTS;
+}
+
+void datasetRecord(const SimState* s, u16 action, u16 source, DatasetRecord* r) {
+    u8 active[NN_INPUTS];
+    const u16 count = nnFeatures(s, active);
+    memset(r, 0, sizeof(*r));
+    for (u16 i = 0; i < count; i++) r->features |= (uint64_t)1 << active[i];
+    r->seed = s->seed;
+    r->step = s->stepCount;
+    r->score = s->score;
+    r->headX = s->snakeBody[0].x;
+    r->headY = s->snakeBody[0].y;
+    r->foodX = s->food.x;
+    r->foodY = s->food.y;
+    r->direction = s->direction;
+    r->action = action;
+    r->legal = nnLegalMask(s);
+    r->source = source;
+    r->length = s->snakeLength;
+    r->level = s->currentLevel;
+}
+
+int datasetAppend(const char* path, const DatasetRecord* records, size_t count) {
+    DatasetHeader expected;
+    DatasetHeader h;
+    initHeader(&expected);
+    FILE* f = fopen(path, "a+b");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    if (size == 0) {
+        fwrite(&expected, sizeof(expected), 1, f);
+    } else {
+        rewind(f);
+        if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(&h, &expected, sizeof(h)) != 0 ||
+            (size - (long)sizeof(h)) % sizeof(DatasetRecord) != 0) {
+            fprintf(stderr, "%s: not a dataset with this record layout\n", path);
+            fclose(f);
+            return -1;
+        }
+        fseek(f, 0, SEEK_END);
+    }
+    const size_t written = fwrite(records, sizeof(DatasetRecord), count, f);
+    if (fclose(f) != 0 || written != count) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int datasetOpen(const char* path, Dataset* ds) {
+    DatasetHeader expected;
+    struct stat st;
+    initHeader(&expected);
+    memset(ds, 0, sizeof(*ds));
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(DatasetHeader)) {
+        fprintf(stderr, "%s: too small for a dataset\n", path);
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    if (memcmp(map, &expected, sizeof(expected)) != 0) {
+        fprintf(stderr, "%s: not a dataset with this record layout\n", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    ds->map = map;
+    ds->mapSize = st.st_size;
+    ds->records = (const DatasetRecord*)((const char*)map + sizeof(DatasetHeader));
+    ds->count = (st.st_size - sizeof(DatasetHeader)) / sizeof(DatasetRecord);
+    return 0;
+}
+
+void datasetClose(Dataset* ds) {
+    if (ds->map) munmap(ds->map, ds->mapSize);
+    memset(ds, 0, sizeof(*ds));
+}
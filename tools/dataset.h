@@ -0,0 +1,66 @@
+// Imitation learning dataset: fixed-size (observation, action) records in a flat binary file
+//
+// Overview:
+// File = one DatasetHeader followed by DatasetRecord entries, all little-endian and 32-byte aligned. No
+// record count is stored: it is (file size - header) / record size, so producers simply append records
+// (several exports can go into one file) and consumers mmap() the file and index records directly,
+// without any parsing. datasetAppend() creates the file (and header) on first use and refuses to append
+// to files with a different layout.
+//
+// The observation is the nn.h input vector as a bitset plus the raw positions, so a trainer can either
+// use the cartridge features directly or build its own from head, food, direction and length.
+
+#ifndef _DATASET_H_
+#define _DATASET_H_
+
+#include <stddef.h>
+
+#include "sim.h"
+
+#define DATASET_MAGIC "SNKDATA1"
+#define DATASET_VERSION 1
+
+// Where a record came from
+#define DATASET_SOURCE_HUMAN 0 // ROM replay of a human game
+#define DATASET_SOURCE_AI 1    // Search AI (host self-play or ROM demo replay)
+#define DATASET_SOURCE_NN 2    // Neural network policy
+#define DATASET_SOURCE_GREEDY 3 // Greedy baseline
+
+typedef struct {
+    char magic[8];             // DATASET_MAGIC
+    u32 version;               // DATASET_VERSION
+    u32 headerSize;            // sizeof(DatasetHeader): records start here
+    u32 recordSize;            // sizeof(DatasetRecord)
+    u32 featureCount;          // NN_INPUTS encoded in DatasetRecord.features
+    u8 reserved[8];
+} DatasetHeader;
+
+typedef struct {
+    uint64_t features;         // Bit i set = nn.h input i active
+    u32 seed;                  // Game seed
+    u32 step;                  // Step index within the game
+    u16 score;                 // Score before the move
+    u8 headX, headY;           // Head position
+    u8 foodX, foodY;           // Food position
+    u8 direction;              // Current direction (DIR_*)
+    u8 action;                 // Direction taken (DIR_*): the label
+    u8 legal;                  // Non-reversing, non-colliding moves (bit per DIR_*)
+    u8 source;                 // DATASET_SOURCE_*
+    u8 length;                 // Snake length
+    u8 level;                  // Current level
+    u8 reserved[4];
+} DatasetRecord;
+
+typedef struct {
+    const DatasetRecord* records; // Mapped records
+    size_t count;              // Number of records
+    void* map;                 // mmap() base (header included)
+    size_t mapSize;
+} Dataset;
+
+void datasetRecord(const SimState* s, u16 action, u16 source, DatasetRecord* r); // Fills one record from a state
+int datasetAppend(const char* path, const DatasetRecord* records, size_t count); // 0 on success
+int datasetOpen(const char* path, Dataset* ds); // Maps a dataset read-only; 0 on success
+void datasetClose(Dataset* ds);
+
+#endif // _DATASET_H_
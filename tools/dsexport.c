@@ -0,0 +1,254 @@
+// Exports (observation, action) pairs into an imitation learning dataset (see dataset.h)
+//
+// Two sources:
+// - Host self-play: plays -n seeded games with a policy in parallel and appends every step.
+// - ROM replays: each file argument is an SRAM dump holding a replay (see ../src/replay.h). The game is
+//   re-simulated from its seed and moves, the final state hash is checked, and every step is appended
+//   with the replay's policy as source (human games are the interesting ones).
+// Records are appended in game order, so the output does not depend on -t.
+//
+// Usage: dsexport -o data.bin [-p ai|nn|greedy] [-n games] [-m maxSteps] [-t threads] [-s seed] [-q]
+//        dsexport -o data.bin replay.srm...
+//        dsexport -w replay.srm [-p policy] [-m maxSteps] [-s seed]   (write one host game as a replay dump)
+//        dsexport -T replay.srm...                                    (per-step trace only, no dataset)
+// -T prints "<hash> <step>" after every step of the replays or the -w game, the same lines as a DEBUG_TRACE
+// ROM logs, so a desync shows up at the first differing step.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "play.h"
+#include "replay.h"
+#include "runner.h"
+#include "sram.h"
+
+typedef struct {
+    DatasetRecord* records;
+    size_t count;
+    size_t capacity;
+} RecordBuffer;
+
+typedef struct {
+    uint64_t baseSeed;
+    u32 maxSteps;
+    u16 policy;                // PLAY_POLICY_*
+    RecordBuffer* games;       // One buffer per game, written only by its job
+} Export;
+
+static int trace;              // -T: print the per-step hash trace (replays and -w only)
+
+static void push(RecordBuffer* b, const DatasetRecord* r) {
+    if (b->count == b->capacity) {
+        b->capacity = b->capacity ? b->capacity * 2 : 4096;
+        b->records = realloc(b->records, b->capacity * sizeof(DatasetRecord));
+        if (!b->records) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    b->records[b->count++] = *r;
+}
+
+// Same line as the ROM's DEBUG_TRACE log (main.c debugStep())
+static void traceStep(const SimState* s) {
+    if (trace) printf("%08X %u\n", simHash(s), s->stepCount);
+}
+
+static u16 policyMove(const SimState* s, u16 policy) {
+    if (policy == PLAY_POLICY_GREEDY) return playGreedyMove(s);
+    if (policy == PLAY_POLICY_NN) return nnChooseMove(s, &nnDefaultModel);
+    return aiChooseMove(s, &aiDefaultWeights);
+}
+
+static u16 policySource(u16 policy) {
+    if (policy == PLAY_POLICY_GREEDY) return DATASET_SOURCE_GREEDY;
+    if (policy == PLAY_POLICY_NN) return DATASET_SOURCE_NN;
+    return DATASET_SOURCE_AI;
+}
+
+static void exportGame(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    Export* e = user;
+    RecordBuffer* b = &e->games[job];
+    SimState s;
+    DatasetRecord r;
+    simInitGame(&s, (u32)runnerJobSeed(e->baseSeed, job));
+    while (s.stepCount < e->maxSteps) {
+        const u16 dir = policyMove(&s, e->policy);
+        datasetRecord(&s, dir, policySource(e->policy), &r);
+        push(b, &r);
+        const u16 events = simStep(&s, dir);
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+    }
+}
+
+// Re-simulates one replay into b; returns 0 if it is complete and its hash matches
+static int exportReplay(const char* path, RecordBuffer* b) {
+    size_t size;
+    u8* sram = sramLoad(path, REPLAY_OFS_MAGIC, REPLAY_MAGIC, &size);
+    if (!sram) {
+        fprintf(stderr, "%s: no replay found\n", path);
+        return -1;
+    }
+    const u32 seed = sramRead(sram, REPLAY_OFS_SEED, 4);
+    const u32 steps = sramRead(sram, REPLAY_OFS_STEPS, 4);
+    const u32 hash = sramRead(sram, REPLAY_OFS_HASH, 4);
+    const u16 policy = sram[REPLAY_OFS_POLICY];
+    const u16 spriteCap = sram[REPLAY_OFS_SPRITE_CAP];
+    const u16 cause = sram[REPLAY_OFS_CAUSE] < SIM_CAUSE_COUNT ? sram[REPLAY_OFS_CAUSE] : SIM_CAUSE_NONE;
+    const u16 version = sram[REPLAY_OFS_VERSION];
+    const u16 foodPolicy = version >= 2 ? sram[REPLAY_OFS_FOOD_POLICY] : SIM_FOOD_UNIFORM;
+    int rc = 0;
+    if (version < 1 || version > REPLAY_VERSION || foodPolicy >= SIM_FOOD_COUNT || steps == 0 ||
+        steps > REPLAY_MAX_STEPS || REPLAY_HEADER_SIZE + (steps + 3) / 4 > size) {
+        fprintf(stderr, "%s: incomplete or unsupported replay\n", path);
+        free(sram);
+        return -1;
+    }
+
+    SimState s;
+    DatasetRecord r;
+    const size_t first = b->count;
+    simInitGameEx(&s, seed, foodPolicy);
+    for (u32 i = 0; i < steps; i++) {
+        const u16 dir = (sram[REPLAY_HEADER_SIZE + (i >> 2)] >> ((i & 3) << 1)) & 3;
+        datasetRecord(&s, dir, policy, &r);
+        push(b, &r);
+        const u16 events = simStep(&s, dir);
+        if ((events & SIM_EVENT_GREW) && spriteCap && s.snakeLength > spriteCap) { // ROM ran out of sprites
+            simTrimTail(&s);
+            s.maxLength = spriteCap;
+        }
+        traceStep(&s);
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) {
+            if (i + 1 != steps) rc = -1;
+            break;
+        }
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+    }
+    if (steps < REPLAY_MAX_STEPS && simHash(&s) != hash) rc = -1; // Truncated replays cannot be checked
+    if (rc) {
+        fprintf(stderr, "%s: replay does not reproduce (hash %08X, expected %08X); skipped\n", path, simHash(&s), hash);
+        b->count = first;
+    } else {
+        fprintf(stderr, "%s: seed %08X, %u steps, score %u, policy %u, food %s, end %s\n", path, seed, steps, s.score,
+                policy, simFoodPolicyNames[foodPolicy], simCauseNames[cause]);
+    }
+    free(sram);
+    return rc;
+}
+
+// Writes one host game as an SRAM replay dump (packed bytes), mainly to test the ROM replay path
+static int writeReplay(const char* path, u32 seed, u16 policy, u32 maxSteps) {
+    static u8 sram[REPLAY_SRAM_SIZE];
+    SimState s;
+    u32 steps = 0;
+    u16 events = 0;
+    memset(sram, 0, sizeof(sram));
+    simInitGame(&s, seed);
+    while (steps < maxSteps && steps < REPLAY_MAX_STEPS) {
+        const u16 dir = policyMove(&s, policy);
+        sram[REPLAY_HEADER_SIZE + (steps >> 2)] |= dir << ((steps & 3) << 1);
+        steps++;
+        events = simStep(&s, dir);
+        traceStep(&s);
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+    }
+    const u32 fields[4] = { REPLAY_MAGIC, seed, steps, simHash(&s) };
+    for (u16 i = 0; i < 4; i++) {
+        for (u16 k = 0; k < 4; k++) sram[i * 4 + k] = fields[i] >> (24 - k * 8);
+    }
+    sram[REPLAY_OFS_SCORE] = s.score >> 8;
+    sram[REPLAY_OFS_SCORE + 1] = s.score & 0xFF;
+    sram[REPLAY_OFS_POLICY] = policySource(policy);
+    sram[REPLAY_OFS_VERSION] = REPLAY_VERSION;
+    sram[REPLAY_OFS_CAUSE] = simEndCause(&s, events);
+    sram[REPLAY_OFS_FOOD_POLICY] = s.foodPolicy;
+    FILE* f = fopen(path, "wb");
+    if (!f || fwrite(sram, sizeof(sram), 1, f) != 1) {
+        perror(path);
+        if (f) fclose(f);
+        return -1;
+    }
+    fclose(f);
+    fprintf(stderr, "%s: seed %08X, %u steps, score %u\n", path, seed, steps, s.score);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    Export e = { 1, 50000, PLAY_POLICY_AI, NULL };
+    u32 games = 100;
+    const char* outPath = NULL;
+    const char* replayOut = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:p:n:m:t:s:w:Tq")) != -1) {
+        switch (opt) {
+            case 'o': outPath = optarg; break;
+            case 'p':
+                if (!strcmp(optarg, "ai")) e.policy = PLAY_POLICY_AI;
+                else if (!strcmp(optarg, "nn")) e.policy = PLAY_POLICY_NN;
+                else if (!strcmp(optarg, "greedy")) e.policy = PLAY_POLICY_GREEDY;
+                else {
+                    fprintf(stderr, "unknown policy %s (ai, nn, greedy)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'n': games = (u32)strtoul(optarg, NULL, 0); break;
+            case 'm': e.maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': e.baseSeed = strtoull(optarg, NULL, 0); break;
+            case 'w': replayOut = optarg; break;
+            case 'T': trace = 1; break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s -o data.bin [-p ai|nn|greedy] [-n games] [-m maxSteps] [-t threads] [-s seed] "
+                                "[-q] [replay.srm...]\n       %s -w replay.srm [-p policy] [-m maxSteps] [-s seed] [-T]\n"
+                                "       %s -T replay.srm...\n",
+                        argv[0], argv[0], argv[0]);
+                return 2;
+        }
+    }
+    simInitKeys();
+    if (replayOut) return writeReplay(replayOut, (u32)runnerJobSeed(e.baseSeed, 0), e.policy, e.maxSteps) ? 1 : 0;
+    if (!outPath && !(trace && optind < argc)) {
+        fprintf(stderr, "-o is required\n");
+        return 2;
+    }
+
+    const size_t numBuffers = optind < argc ? (size_t)(argc - optind) : games;
+    RecordBuffer* buffers = calloc(numBuffers, sizeof(RecordBuffer));
+    if (!buffers) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int failed = 0;
+    if (optind < argc) {
+        for (size_t i = 0; i < numBuffers; i++) failed |= exportReplay(argv[optind + i], &buffers[i]) != 0;
+    } else {
+        RunnerResult res;
+        e.games = buffers;
+        cfg.seed = e.baseSeed;
+        if (runnerRun(&cfg, games, exportGame, &e, &res) != 0) {
+            fprintf(stderr, "runner failed\n");
+            return 1;
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < numBuffers; i++) {
+        if (outPath && buffers[i].count && datasetAppend(outPath, buffers[i].records, buffers[i].count) != 0) return 1;
+        total += buffers[i].count;
+        free(buffers[i].records);
+    }
+    free(buffers);
+    if (outPath) {
+        fprintf(stderr, "%zu records (%zu bytes) appended to %s\n", total, total * sizeof(DatasetRecord), outPath);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// Minimal ELF reader (see elf.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf.h"
+
+// Reads an n-byte field in the file's byte order (0 past the end)
+static uint64_t field(const Elf* e, uint64_t off, unsigned n) {
+    uint64_t v = 0;
+    if (off + n > e->size) return 0;
+    for (unsigned i = 0; i < n; i++) {
+        const unsigned b = e->big ? i : n - 1 - i;
+        v = (v << 8) | e->data[off + b];
+    }
+    return v;
+}
+
+// NUL-terminated string at off in a string table section ("" if out of range)
+static const char* string(const Elf* e, unsigned strtab, uint64_t off) {
+    ElfSection s;
+    if (!strtab || strtab >= e->shnum) return "";
+    elfSection(e, strtab, &s);
+    if (off >= s.size || s.offset + s.size > e->size) return "";
+    const char* p = (const char*)e->data + s.offset + off;
+    return memchr(p, 0, s.size - off) ? p : "";
+}
+
+int elfLoad(const char* path, Elf* e) {
+    FILE* f = fopen(path, "rb");
+    memset(e, 0, sizeof(*e));
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    e->size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    e->data = malloc(e->size ? e->size : 1);
+    const size_t got = fread(e->data, 1, e->size, f);
+    fclose(f);
+    if (got != e->size || e->size < 52 || memcmp(e->data, "\x7f" "ELF", 4)) {
+        fprintf(stderr, "%s: not an ELF file\n", path);
+        elfFree(e);
+        return -1;
+    }
+    e->is64 = e->data[4] == 2;
+    e->big = e->data[5] == 2;
+    e->shoff = field(e, e->is64 ? 0x28 : 0x20, e->is64 ? 8 : 4);
+    e->shentsize = (unsigned)field(e, e->is64 ? 0x3A : 0x2E, 2);
+    e->shnum = (unsigned)field(e, e->is64 ? 0x3C : 0x30, 2);
+    e->shstrndx = (unsigned)field(e, e->is64 ? 0x3E : 0x32, 2);
+    if (!e->shoff || e->shoff + (uint64_t)e->shentsize * e->shnum > e->size) {
+        fprintf(stderr, "%s: no section headers\n", path);
+        elfFree(e);
+        return -1;
+    }
+    for (unsigned i = 1; i < e->shnum; i++) {
+        ElfSection s;
+        elfSection(e, i, &s);
+        if (s.type == ELF_SHT_SYMTAB) e->symtab = i;
+    }
+    return 0;
+}
+
+void elfFree(Elf* e) {
+    free(e->data);
+    e->data = NULL;
+}
+
+void elfSection(const Elf* e, unsigned i, ElfSection* s) {
+    const uint64_t h = e->shoff + (uint64_t)i * e->shentsize;
+    const unsigned w = e->is64 ? 8 : 4;  // Width of flags, addr, offset and size
+    s->type = (uint32_t)field(e, h + 4, 4);
+    s->flags = field(e, h + 8, w);
+    s->addr = field(e, h + 8 + w, w);
+    s->offset = field(e, h + 8 + 2 * w, w);
+    s->size = field(e, h + 8 + 3 * w, w);
+    s->link = (uint32_t)field(e, h + 8 + 4 * w, 4);
+    s->name = i == e->shstrndx ? "" : string(e, e->shstrndx, field(e, h, 4));
+}
+
+unsigned elfSymbolCount(const Elf* e) {
+    ElfSection s;
+    if (!e->symtab) return 0;
+    elfSection(e, e->symtab, &s);
+    return (unsigned)(s.size / (e->is64 ? 24 : 16));
+}
+
+// ELF32: name, value, size, info, other, shndx; ELF64: name, info, other, shndx, value, size
+void elfSymbol(const Elf* e, unsigned i, ElfSymbol* sym) {
+    ElfSection s;
+    elfSection(e, e->symtab, &s);
+    const uint64_t p = s.offset + (uint64_t)i * (e->is64 ? 24 : 16);
+    const uint8_t info = (uint8_t)field(e, p + (e->is64 ? 4 : 12), 1);
+    sym->name = string(e, s.link, field(e, p, 4));
+    sym->value = e->is64 ? field(e, p + 8, 8) : field(e, p + 4, 4);
+    sym->size = e->is64 ? field(e, p + 16, 8) : field(e, p + 8, 4);
+    sym->type = info & 0xF;
+    sym->bind = info >> 4;
+    sym->shndx = (uint16_t)field(e, p + (e->is64 ? 6 : 14), 2);
+}
@@ -0,0 +1,64 @@
+// Minimal ELF reader for the ROM report tools (romreport, rambudget)
+//
+// Overview:
+// Loads a whole ELF file (linked ROM image or relocatable object) and reads its section headers and
+// symbol table in place. Both classes and byte orders are handled: the ROM ELF is 32-bit big-endian
+// (68000), and the same code reads host binaries, which is how the tools are checked without SGDK.
+
+#ifndef _ELF_H_
+#define _ELF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ELF_SHT_SYMTAB 2
+#define ELF_SHT_NOBITS 8
+#define ELF_SHF_WRITE 0x1
+#define ELF_SHF_ALLOC 0x2
+#define ELF_STT_NOTYPE 0
+#define ELF_STT_OBJECT 1
+#define ELF_STT_FILE 4
+#define ELF_STT_TLS 6
+#define ELF_STB_LOCAL 0
+
+typedef struct {
+    uint8_t* data;             // Whole file
+    size_t size;
+    int is64;                  // ELFCLASS64
+    int big;                   // ELFDATA2MSB (the 68000)
+    uint64_t shoff;            // Section header table
+    unsigned shentsize;
+    unsigned shnum;
+    unsigned shstrndx;         // Section holding the section names
+    unsigned symtab;           // SHT_SYMTAB section (0: none)
+} Elf;
+
+typedef struct {
+    const char* name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;             // Symbol table: its string table
+} ElfSection;
+
+typedef struct {
+    const char* name;
+    uint64_t value;
+    uint64_t size;
+    uint8_t type;              // ELF_STT_*
+    uint8_t bind;              // ELF_STB_LOCAL, global or weak
+    uint16_t shndx;            // Defining section (0: undefined, 0xFFF1: absolute, ...)
+} ElfSymbol;
+
+int elfLoad(const char* path, Elf* e);    // 0 on success (prints the error otherwise)
+void elfFree(Elf* e);
+void elfSection(const Elf* e, unsigned i, ElfSection* s);
+unsigned elfSymbolCount(const Elf* e);    // Entries of the symbol table (0 if stripped)
+void elfSymbol(const Elf* e, unsigned i, ElfSymbol* s);
+
+// RAM sections: allocated and writable (.data) or allocated without file contents (.bss)
+#define ELF_IS_RAM(s) (((s)->flags & ELF_SHF_ALLOC) && (((s)->flags & ELF_SHF_WRITE) || (s)->type == ELF_SHT_NOBITS))
+
+#endif // _ELF_H_
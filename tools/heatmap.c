@@ -0,0 +1,272 @@
+// Position heatmaps per level: where the head goes and where it dies (see ../src/heatmap.h)
+//
+// Two sources:
+// - Host self-play: plays -n seeded games with a policy in parallel, recording every step into a u16
+//   Heatmap that is folded into per-thread u32 totals at each level end.
+// - ROM SRAM: each file argument is an SRAM dump of a HEATMAP_SRAM=1 build; its level buckets are added
+//   (the last ROM bucket holds every level from HEATMAP_LEVELS on).
+// Prints one CSV row per level (visits, deaths, deadliest cell) and, with -o, writes one PPM image per
+// level: 8x8 pixels per cell like the screen, visits on a log colour ramp, deaths as red squares whose
+// brightness grows with the count.
+//
+// Usage: heatmap [-o prefix] [-p ai|nn|greedy] [-n games] [-m maxSteps] [-t threads] [-s seed] [-q]
+//        heatmap [-o prefix] sram.srm...
+//        heatmap -w sram.srm [-p policy] [-n games] ...   (write host totals as a ROM SRAM dump)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "heatmap.h"
+#include "play.h"
+#include "runner.h"
+#include "sram.h"
+
+#define MAX_LEVELS 32          // Host totals per level; the last one collects every level from here on
+#define CELL_PIXELS 8
+
+typedef struct {
+    u32 visits[HEATMAP_CELLS];
+    u32 deaths[HEATMAP_CELLS];
+} LevelTotals;
+
+typedef struct {
+    uint64_t baseSeed;
+    u32 maxSteps;
+    u16 policy;                // PLAY_POLICY_*
+    LevelTotals* totals;       // [threads][MAX_LEVELS], each thread adds only into its own block
+} Collect;
+
+static u16 policyMove(const SimState* s, u16 policy) {
+    if (policy == PLAY_POLICY_GREEDY) return playGreedyMove(s);
+    if (policy == PLAY_POLICY_NN) return nnChooseMove(s, &nnDefaultModel);
+    return aiChooseMove(s, &aiDefaultWeights);
+}
+
+static void fold(LevelTotals* totals, Heatmap* h, u16 level) {
+    LevelTotals* t = &totals[(level < MAX_LEVELS ? level : MAX_LEVELS) - 1];
+    for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+        t->visits[i] += h->visits[i];
+        t->deaths[i] += h->deaths[i];
+    }
+    heatmapClear(h);
+}
+
+static void collectGame(RunnerWorker* w, uint64_t job, void* user) {
+    Collect* c = user;
+    LevelTotals* totals = &c->totals[(size_t)runnerThreadIndex(w) * MAX_LEVELS];
+    SimState s;
+    Heatmap h;
+    heatmapClear(&h);
+    simInitGame(&s, (u32)runnerJobSeed(c->baseSeed, job));
+    while (s.stepCount < c->maxSteps) {
+        const u16 dir = policyMove(&s, c->policy);
+        const u16 events = simStep(&s, dir);
+        if (events & SIM_EVENT_DEAD) {
+            heatmapDeath(&h, &s, dir);
+            break;
+        }
+        HEATMAP_VISIT(&h, &s);
+        if (events & SIM_EVENT_WIN) break;
+        if (events & SIM_EVENT_LEVEL_UP) {
+            fold(totals, &h, s.currentLevel - 1);
+            simInitLevel(&s);
+        }
+    }
+    fold(totals, &h, s.currentLevel);
+}
+
+// Adds the level buckets of one ROM SRAM dump
+static int addSram(const char* path, LevelTotals* totals) {
+    size_t size;
+    u8* sram = sramLoad(path, HEATMAP_SRAM_BASE, HEATMAP_MAGIC, &size);
+    if (!sram || size < HEATMAP_SRAM_BASE + HEATMAP_SRAM_SIZE || sram[HEATMAP_SRAM_BASE + 4] != HEATMAP_VERSION) {
+        fprintf(stderr, "%s: no heatmap found\n", path);
+        free(sram);
+        return -1;
+    }
+    for (u16 b = 0; b < HEATMAP_LEVELS; b++) {
+        const u32 base = HEATMAP_SRAM_BASE + HEATMAP_SRAM_HEADER + (u32)b * HEATMAP_BUCKET_SIZE;
+        for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+            totals[b].visits[i] += sramRead(sram, base + i * 2, 2);
+            totals[b].deaths[i] += sramRead(sram, base + HEATMAP_CELLS * 2 + i * 2, 2);
+        }
+    }
+    free(sram);
+    return 0;
+}
+
+// Adds to a big-endian u16 SRAM counter, saturating like the ROM
+static void addSaturated(u8* p, u32 value) {
+    u32 sum = ((u32)p[0] << 8 | p[1]) + value;
+    if (sum > 0xFFFF) sum = 0xFFFF;
+    p[0] = sum >> 8;
+    p[1] = sum & 0xFF;
+}
+
+// Writes totals the way a ROM would have saved them (packed dump, saturated u16 counters)
+static int writeSram(const char* path, const LevelTotals* totals) {
+    const size_t size = HEATMAP_SRAM_BASE + HEATMAP_SRAM_SIZE;
+    u8* sram = calloc(size, 1);
+    if (!sram) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (u16 i = 0; i < 4; i++) sram[HEATMAP_SRAM_BASE + i] = (u8)(HEATMAP_MAGIC >> (24 - i * 8));
+    sram[HEATMAP_SRAM_BASE + 4] = HEATMAP_VERSION;
+    for (u16 level = 0; level < MAX_LEVELS; level++) {
+        const u16 b = level < HEATMAP_LEVELS ? level : HEATMAP_LEVELS - 1;
+        u8* base = sram + HEATMAP_SRAM_BASE + HEATMAP_SRAM_HEADER + (u32)b * HEATMAP_BUCKET_SIZE;
+        for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+            addSaturated(base + i * 2, totals[level].visits[i]);
+            addSaturated(base + (HEATMAP_CELLS + i) * 2, totals[level].deaths[i]);
+        }
+    }
+    FILE* f = fopen(path, "wb");
+    const int ok = f && fwrite(sram, size, 1, f) == 1;
+    if (f) fclose(f);
+    if (!ok) perror(path);
+    free(sram);
+    return ok ? 0 : -1;
+}
+
+static int render(const char* path, const LevelTotals* t) {
+    static u8 image[GRID_HEIGHT * CELL_PIXELS][GRID_WIDTH * CELL_PIXELS][3];
+    u32 maxVisits = 1;
+    u32 maxDeaths = 1;
+    for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+        if (t->visits[i] > maxVisits) maxVisits = t->visits[i];
+        if (t->deaths[i] > maxDeaths) maxDeaths = t->deaths[i];
+    }
+    for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+        u8 rgb[3] = { 40, 40, 40 };       // Never visited
+        if (t->visits[i]) {
+            const double v = log1p(t->visits[i]) / log1p(maxVisits);
+            rgb[0] = (u8)(255 * v);
+            rgb[1] = (u8)(200 * v);
+            rgb[2] = (u8)(32 + 96 * (1.0 - v));
+        }
+        const u8 death = t->deaths[i] ? (u8)(128 + 127 * t->deaths[i] / maxDeaths) : 0;
+        const u16 x0 = (i % GRID_WIDTH) * CELL_PIXELS;
+        const u16 y0 = (i / GRID_WIDTH) * CELL_PIXELS;
+        for (u16 y = 0; y < CELL_PIXELS; y++) {
+            for (u16 x = 0; x < CELL_PIXELS; x++) {
+                u8* px = image[y0 + y][x0 + x];
+                const u16 inner = x >= 2 && x < 6 && y >= 2 && y < 6;
+                px[0] = (death && inner) ? death : rgb[0];
+                px[1] = (death && inner) ? 0 : rgb[1];
+                px[2] = (death && inner) ? 0 : rgb[2];
+            }
+        }
+    }
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", GRID_WIDTH * CELL_PIXELS, GRID_HEIGHT * CELL_PIXELS);
+    const int ok = fwrite(image, sizeof(image), 1, f) == 1;
+    if (fclose(f) != 0 || !ok) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    Collect c = { 1, 50000, PLAY_POLICY_AI, NULL };
+    u32 games = 1000;
+    const char* prefix = NULL;
+    const char* sramOut = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:p:n:m:t:s:w:q")) != -1) {
+        switch (opt) {
+            case 'o': prefix = optarg; break;
+            case 'p':
+                if (!strcmp(optarg, "ai")) c.policy = PLAY_POLICY_AI;
+                else if (!strcmp(optarg, "nn")) c.policy = PLAY_POLICY_NN;
+                else if (!strcmp(optarg, "greedy")) c.policy = PLAY_POLICY_GREEDY;
+                else {
+                    fprintf(stderr, "unknown policy %s (ai, nn, greedy)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'n': games = (u32)strtoul(optarg, NULL, 0); break;
+            case 'm': c.maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': c.baseSeed = strtoull(optarg, NULL, 0); break;
+            case 'w': sramOut = optarg; break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-o prefix] [-p ai|nn|greedy] [-n games] [-m maxSteps] [-t threads] [-s seed] "
+                                "[-q] [sram.srm...]\n       %s -w sram.srm [-p policy] [-n games] ...\n",
+                        argv[0], argv[0]);
+                return 2;
+        }
+    }
+    simInitKeys();
+
+    LevelTotals* totals = calloc(MAX_LEVELS, sizeof(LevelTotals));
+    if (!totals) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int failed = 0;
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++) failed |= addSram(argv[i], totals) != 0;
+    } else {
+        RunnerResult res;
+        if (!cfg.threads) cfg.threads = runnerDefaultThreads();
+        cfg.seed = c.baseSeed;
+        c.totals = calloc((size_t)cfg.threads * MAX_LEVELS, sizeof(LevelTotals));
+        if (!c.totals) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (runnerRun(&cfg, games, collectGame, &c, &res) != 0) {
+            fprintf(stderr, "runner failed\n");
+            return 1;
+        }
+        for (unsigned k = 0; k < res.threads; k++) { // Integer sums: same totals for any -t
+            for (u16 l = 0; l < MAX_LEVELS; l++) {
+                const LevelTotals* src = &c.totals[(size_t)k * MAX_LEVELS + l];
+                for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+                    totals[l].visits[i] += src->visits[i];
+                    totals[l].deaths[i] += src->deaths[i];
+                }
+            }
+        }
+        free(c.totals);
+    }
+    if (sramOut) {
+        failed |= writeSram(sramOut, totals) != 0;
+        free(totals);
+        return failed ? 1 : 0;
+    }
+
+    printf("level,visits,deaths,deadliest_x,deadliest_y,deadliest_deaths\n");
+    for (u16 l = 0; l < MAX_LEVELS; l++) {
+        const LevelTotals* t = &totals[l];
+        uint64_t visits = 0;
+        uint64_t deaths = 0;
+        u16 worst = 0;
+        for (u16 i = 0; i < HEATMAP_CELLS; i++) {
+            visits += t->visits[i];
+            deaths += t->deaths[i];
+            if (t->deaths[i] > t->deaths[worst]) worst = i;
+        }
+        if (!visits && !deaths) continue;
+        printf("%u,%llu,%llu,%u,%u,%u\n", l + 1, (unsigned long long)visits, (unsigned long long)deaths,
+               worst % GRID_WIDTH, worst / GRID_WIDTH, t->deaths[worst]);
+        if (prefix) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s-level%02u.ppm", prefix, l + 1);
+            failed |= render(path, t) != 0;
+        }
+    }
+    free(totals);
+    return failed ? 1 : 0;
+}
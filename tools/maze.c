@@ -0,0 +1,206 @@
+// Level analysis for the host tools (see maze.h)
+
+#include <string.h>
+
+#include "maze.h"
+
+void mazeGenerate(SimState* s, u32 seed, u16 level) {
+    simInitGame(s, seed);
+    while (s->currentLevel < level) {
+        for (u16 i = 1; i < s->foodTarget; i++) simPlaceFood(s); // Food drawn after each meal but the last
+        s->currentLevel++;
+        s->foodEatenThisLevel = 0;
+        s->foodTarget = 5 + (s->currentLevel - 1) * 5; // As in simStep()
+        simInitLevel(s);
+    }
+}
+
+u16 mazeFoodSequence(SimState* s, Point* food, u16 max) {
+    u16 count = 0;
+    if (max > 0) food[count++] = s->food;
+    for (u16 i = s->foodEatenThisLevel + 1; i < s->foodTarget && count < max; i++) {
+        if (simPlaceFood(s) & SIM_EVENT_WIN) break;
+        food[count++] = s->food;
+    }
+    return count;
+}
+
+void mazeBuild(const SimState* s, Maze* m) {
+    memset(m->cell, MAZE_BLOCKED, sizeof(m->cell));
+    for (u16 y = 2; y < GRID_HEIGHT - 1; y++) memset(&m->cell[MAZE_CELL(1, y)], 0, GRID_WIDTH - 2);
+    for (u16 i = 0; i < NUM_PORTALS; i++) {
+        const Portal* p = &s->portals[i];
+        m->portalCell[i * 2] = MAZE_CELL(p->entry.x, p->entry.y);
+        m->portalCell[i * 2 + 1] = MAZE_CELL(p->exit.x, p->exit.y);
+        m->portalPartner[i * 2] = m->portalCell[i * 2 + 1];
+        m->portalPartner[i * 2 + 1] = m->portalCell[i * 2];
+        m->portalInward[i * 2] = (p->entry.y == 1) ? DIR_DOWN : DIR_RIGHT;
+        m->portalInward[i * 2 + 1] = (p->exit.y == GRID_HEIGHT - 1) ? DIR_UP : DIR_LEFT;
+        m->cell[m->portalCell[i * 2]] = MAZE_PORTAL;
+        m->cell[m->portalCell[i * 2 + 1]] = MAZE_PORTAL;
+    }
+    for (u16 i = 0; i < s->wallSegmentCount; i++) {
+        const WallSegment* w = &s->mazeWalls[i];
+        for (u16 k = 0; k < w->length; k++) {
+            if (!WALL_SKIPPED(w, k)) m->cell[MAZE_CELL(WALL_TILE_X(w, k), WALL_TILE_Y(w, k))] |= MAZE_BLOCKED;
+        }
+    }
+    for (u16 i = 1; i < s->snakeLength; i++) m->cell[MAZE_CELL(s->snakeBody[i].x, s->snakeBody[i].y)] |= MAZE_BLOCKED;
+}
+
+// Index of a portal tile in portalCell[]
+static u16 portalIndex(const Maze* m, u16 c) {
+    for (u16 i = 0; i < MAZE_PORTAL_CELLS; i++) {
+        if (m->portalCell[i] == c) return i;
+    }
+    return 0;
+}
+
+s16 mazeNeighbor(const Maze* m, u16 c, u16 dir) {
+    if ((m->cell[c] & MAZE_PORTAL) && dir != m->portalInward[portalIndex(m, c)]) return -1;
+    u16 n = c + simDirCell[dir];
+    if (m->cell[n] & MAZE_PORTAL) n = m->portalPartner[portalIndex(m, n)];
+    if (m->cell[n] & MAZE_BLOCKED) return -1;
+    return n;
+}
+
+u16 mazeDistances(const Maze* m, u16 start, u16* dist) {
+    u16 queue[MAZE_CELLS];
+    u16 head = 0;
+    u16 tail = 0;
+    for (u16 i = 0; i < MAZE_CELLS; i++) dist[i] = MAZE_UNREACHED;
+    dist[start] = 0;
+    queue[tail++] = start;
+    while (head < tail) {
+        const u16 c = queue[head++];
+        for (u16 dir = 0; dir < 4; dir++) {
+            const s16 n = mazeNeighbor(m, c, dir);
+            if (n < 0 || dist[n] != MAZE_UNREACHED) continue;
+            dist[n] = dist[c] + 1;
+            queue[tail++] = n;
+        }
+    }
+    return tail;
+}
+
+// Number of moves out of a cell
+static u16 exits(const Maze* m, u16 c) {
+    u16 count = 0;
+    for (u16 dir = 0; dir < 4; dir++) count += mazeNeighbor(m, c, dir) >= 0;
+    return count;
+}
+
+u16 mazeFreeCells(const Maze* m) {
+    u16 count = 0;
+    for (u16 c = 0; c < MAZE_CELLS; c++) count += !(m->cell[c] & MAZE_BLOCKED);
+    return count;
+}
+
+u16 mazeDeadEnds(const Maze* m) {
+    u16 count = 0;
+    for (u16 c = 0; c < MAZE_CELLS; c++) count += !m->cell[c] && exits(m, c) <= 1;
+    return count;
+}
+
+u16 mazePortalDistance(const Maze* m, Point p) {
+    u16 best = 0xFFFF;
+    for (u16 i = 0; i < MAZE_PORTAL_CELLS; i++) {
+        const u16 d = abs(p.x - (s16)MAZE_X(m->portalCell[i])) + abs(p.y - (s16)MAZE_Y(m->portalCell[i]));
+        if (d < best) best = d;
+    }
+    return best;
+}
+
+// Tarjan's low-link search over the undirected move graph (recursion depth is bounded by the cell count)
+typedef struct {
+    u16 link[MAZE_CELLS][6];   // Cells joined to each cell by a move in either direction
+    u8 links[MAZE_CELLS];
+    u16 order[MAZE_CELLS];     // Discovery order (0 = unvisited)
+    u16 low[MAZE_CELLS];       // Lowest order reachable through the DFS subtree plus one back edge
+    u16 next;
+    u16 count;
+} Tarjan;
+
+static void tarjanLink(Tarjan* t, u16 a, u16 b) {
+    for (u16 i = 0; i < t->links[a]; i++) {
+        if (t->link[a][i] == b) return;
+    }
+    t->link[a][t->links[a]++] = b;
+}
+
+static void tarjanVisit(Tarjan* t, u16 c, s16 parent) {
+    u16 children = 0;
+    u16 cut = FALSE;
+    t->order[c] = t->low[c] = ++t->next;
+    for (u16 i = 0; i < t->links[c]; i++) {
+        const u16 n = t->link[c][i];
+        if (n == parent) continue;
+        if (t->order[n]) {
+            if (t->order[n] < t->low[c]) t->low[c] = t->order[n];
+            continue;
+        }
+        children++;
+        tarjanVisit(t, n, c);
+        if (t->low[n] < t->low[c]) t->low[c] = t->low[n];
+        if (parent >= 0 && t->low[n] >= t->order[c]) cut = TRUE;
+    }
+    if (parent < 0 && children > 1) cut = TRUE;
+    t->count += cut;
+}
+
+u16 mazeArticulationPoints(const Maze* m, u16 start) {
+    static SIM_THREAD_LOCAL Tarjan t; // Too large for a worker thread's stack frame next to the recursion
+    memset(t.links, 0, sizeof(t.links));
+    memset(t.order, 0, sizeof(t.order));
+    for (u16 c = 0; c < MAZE_CELLS; c++) {
+        if (m->cell[c] & MAZE_BLOCKED) continue;
+        for (u16 dir = 0; dir < 4; dir++) {
+            const s16 n = mazeNeighbor(m, c, dir);
+            if (n < 0) continue;
+            tarjanLink(&t, c, n);
+            tarjanLink(&t, n, c);
+        }
+    }
+    t.next = 0;
+    t.count = 0;
+    tarjanVisit(&t, start, -1);
+    return t.count;
+}
+
+u16 mazeDeadEndCorridors(const Maze* m, u16* cells) {
+    u16 corridors = 0;
+    *cells = 0;
+    for (u16 c = 0; c < MAZE_CELLS; c++) {
+        if (m->cell[c] || exits(m, c) != 1) continue;
+        // Walk out of the dead end until the corridor opens into a junction
+        corridors++;
+        s16 prev = -1;
+        u16 cur = c;
+        for (;;) {
+            (*cells)++;
+            s16 next = -1;
+            for (u16 dir = 0; dir < 4 && next < 0; dir++) {
+                const s16 n = mazeNeighbor(m, cur, dir);
+                if (n >= 0 && n != prev) next = n;
+            }
+            if (next < 0 || exits(m, next) != 2 || next == (s16)c) break;
+            prev = cur;
+            cur = next;
+        }
+    }
+    return corridors;
+}
+
+u16 mazeFoodDistance(const Maze* m, const u16* dist, Point food, u16* landing) {
+    u16 c = MAZE_CELL(food.x, food.y);
+    *landing = c;
+    if (!(m->cell[c] & MAZE_PORTAL)) return dist[c];
+    // Food on a portal tile is eaten on the way in (head lands on the partner) or on landing
+    const u16 partner = m->portalPartner[portalIndex(m, c)];
+    if (dist[partner] < dist[c]) *landing = partner;
+    return dist[*landing];
+}
+
+void mazeClosePortals(Maze* m) {
+    for (u16 i = 0; i < MAZE_PORTAL_CELLS; i++) m->cell[m->portalCell[i]] = MAZE_BLOCKED;
+}
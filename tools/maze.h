@@ -0,0 +1,54 @@
+// Level analysis for the host tools: generated mazes as graphs
+//
+// Overview:
+// mazeGenerate() rebuilds the portals, walls and food of any (seed, level) without playing the game,
+// and the Maze* helpers look at the result as a graph of passable cells. Moves follow the game rules
+// (see ai.c): walls, borders and the snake body block, stepping onto a portal tile lands on its partner,
+// and a portal tile can only be left inward.
+//
+// Level probes:
+// simInitLevel() and food placement draw a fixed number of values from the game's generator, whatever
+// the player does, so the portals and walls of level N only depend on the seed. The probe replays
+// those draws with the snake parked at its start position. Walls therefore match the real game except
+// for tiles a moving snake would have covered, and food positions are a sample of the level's food
+// sequence (the free list order depends on where the snake went), not the exact one.
+//
+// Distances follow the directed moves. Articulation points join every move with its reverse, since a
+// portal jump is only undone the long way round (leave the landing tile inward, re-enter the portal).
+
+#ifndef _MAZE_H_
+#define _MAZE_H_
+
+#include "sim.h"
+
+#define MAZE_CELLS (GRID_WIDTH * GRID_HEIGHT)
+#define MAZE_BLOCKED 0x01      // Wall, border or body
+#define MAZE_PORTAL 0x02       // Portal tile
+#define MAZE_PORTAL_CELLS (NUM_PORTALS * 2)
+#define MAZE_UNREACHED 0xFFFF  // mazeDistances() value for cells the start cannot reach
+
+#define MAZE_CELL(x, y) ((u16)((y) * GRID_WIDTH + (x)))
+#define MAZE_X(c) ((c) % GRID_WIDTH)
+#define MAZE_Y(c) ((c) / GRID_WIDTH)
+
+typedef struct {
+    u8 cell[MAZE_CELLS];       // MAZE_* flags
+    u16 portalCell[MAZE_PORTAL_CELLS];    // Portal tiles (entry, exit per pair)
+    u16 portalPartner[MAZE_PORTAL_CELLS]; // Tile each portal lands on
+    u16 portalInward[MAZE_PORTAL_CELLS];  // Only legal direction out of each portal tile
+} Maze;
+
+void mazeGenerate(SimState* s, u32 seed, u16 level); // Level probe: level of a seeded game, snake at start
+u16 mazeFoodSequence(SimState* s, Point* food, u16 max); // Current food plus the level's remaining draws
+void mazeBuild(const SimState* s, Maze* m); // Graph of the state's level (body blocks, tail included)
+s16 mazeNeighbor(const Maze* m, u16 c, u16 dir); // Cell reached from c in dir, or -1 if blocked
+u16 mazeDistances(const Maze* m, u16 start, u16* dist); // BFS move counts from start; returns cells reached
+u16 mazeFreeCells(const Maze* m);         // Passable cells (portal tiles included)
+u16 mazeDeadEnds(const Maze* m);          // Passable non-portal cells with at most one exit
+u16 mazePortalDistance(const Maze* m, Point p); // Manhattan distance to the nearest portal tile
+u16 mazeArticulationPoints(const Maze* m, u16 start); // Cells whose loss splits the start's region
+u16 mazeDeadEndCorridors(const Maze* m, u16* cells); // Corridors ending in a dead end; cells gets their total length
+u16 mazeFoodDistance(const Maze* m, const u16* dist, Point food, u16* landing); // Moves to eat food (or MAZE_UNREACHED)
+void mazeClosePortals(Maze* m);           // Turns portal tiles into walls (for with/without portal comparisons)
+
+#endif // _MAZE_H_
@@ -0,0 +1,174 @@
+// Maze difficulty metrics: structural statistics of generated levels, for tuning the level curves
+//
+// For every level in -l from-to and every seed in [-f first, first + -n count), builds the level with
+// the maze.h level probe and measures it (one runner job per (level, seed)):
+//   walls            wall tiles (the generator places 5 + level segments)
+//   free, area       passable cells, and cells reachable from the head
+//   articulation     cells of the head's region whose loss would split it (chokepoints)
+//   dead_ends        corridors ending in a dead end, and their total length in cells
+//   food_target      food needed to finish the level
+//   food_path        mean moves between consecutive foods of the level's food draws (head first),
+//                    with portals and with portals closed; unreachable foods are skipped and counted
+// Output is CSV in (level, seed) order, so it does not depend on -t. -S prints one row per level with
+// means over the seeds instead.
+//
+// Usage: mazemetrics [-l from[-to]] [-f first] [-n count] [-S] [-t threads] [-q]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "maze.h"
+#include "runner.h"
+
+#define MAX_FOOD 256           // Food draws measured per level
+#define NUM_FIELDS 11          // Numeric fields of LevelMetrics (summary rows)
+
+typedef struct {
+    u16 walls;
+    u16 freeCells;
+    u16 area;
+    u16 articulation;
+    u16 deadEnds;              // Dead-end corridors
+    u16 deadEndCells;          // Cells in dead-end corridors
+    u16 foodTarget;
+    u16 foods;                 // Food draws measured
+    u16 unreachable;           // Foods the previous food (or the head) cannot reach
+    float foodPath;            // Mean moves between foods
+    float foodPathClosed;      // Same with portals closed
+} LevelMetrics;
+
+typedef struct {
+    u16 firstLevel;
+    u16 levels;
+    u32 firstSeed;
+    u32 seeds;
+    LevelMetrics* results;     // One slot per (level, seed) job
+} Metrics;
+
+// Mean moves along the food sequence; adds foods nothing can reach to *unreachable
+static float foodPath(const Maze* m, u16 start, const Point* food, u16 foods, u16* unreachable) {
+    u16 dist[MAZE_CELLS];
+    u32 total = 0;
+    u16 reached = 0;
+    u16 from = start;
+    for (u16 i = 0; i < foods; i++) {
+        u16 landing;
+        mazeDistances(m, from, dist);
+        const u16 d = mazeFoodDistance(m, dist, food[i], &landing);
+        if (d == MAZE_UNREACHED) {
+            (*unreachable)++;
+            continue;
+        }
+        total += d;
+        reached++;
+        from = landing;
+    }
+    return reached ? (float)total / reached : 0.0f;
+}
+
+static void measure(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    Metrics* mt = user;
+    LevelMetrics* r = &mt->results[job];
+    const u16 level = mt->firstLevel + job / mt->seeds;
+    const u32 seed = mt->firstSeed + job % mt->seeds;
+    SimState s;
+    Maze m;
+    u16 dist[MAZE_CELLS];
+    Point food[MAX_FOOD];
+    u16 ignored = 0;
+    mazeGenerate(&s, seed, level);
+    mazeBuild(&s, &m);
+    const u16 head = MAZE_CELL(s.snakeBody[0].x, s.snakeBody[0].y);
+    r->walls = s.wallCount;
+    r->freeCells = mazeFreeCells(&m);
+    r->area = mazeDistances(&m, head, dist);
+    r->articulation = mazeArticulationPoints(&m, head);
+    r->deadEnds = mazeDeadEndCorridors(&m, &r->deadEndCells);
+    r->foodTarget = s.foodTarget;
+    r->foods = mazeFoodSequence(&s, food, MAX_FOOD);
+    r->unreachable = 0;
+    r->foodPath = foodPath(&m, head, food, r->foods, &r->unreachable);
+    mazeClosePortals(&m);
+    r->foodPathClosed = foodPath(&m, head, food, r->foods, &ignored);
+}
+
+static void fields(const LevelMetrics* r, double* v) {
+    const double f[NUM_FIELDS] = { r->walls, r->freeCells, r->area, r->articulation, r->deadEnds, r->deadEndCells,
+                                   r->foodTarget, r->foods, r->unreachable, r->foodPath, r->foodPathClosed };
+    for (u16 i = 0; i < NUM_FIELDS; i++) v[i] = f[i];
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    Metrics mt = { 1, 10, 1, 1000, NULL };
+    int summary = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:f:n:St:q")) != -1) {
+        switch (opt) {
+            case 'l': {
+                char* end;
+                const unsigned long from = strtoul(optarg, &end, 0);
+                const unsigned long to = (*end == '-') ? strtoul(end + 1, NULL, 0) : from;
+                mt.firstLevel = (u16)from;
+                mt.levels = (to >= from) ? (u16)(to - from + 1) : 0;
+                break;
+            }
+            case 'f': mt.firstSeed = (u32)strtoul(optarg, NULL, 0); break;
+            case 'n': mt.seeds = (u32)strtoul(optarg, NULL, 0); break;
+            case 'S': summary = 1; break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-l from[-to]] [-f first] [-n count] [-S] [-t threads] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (mt.firstLevel < 1 || mt.levels < 1 || mt.firstLevel + mt.levels - 1 > 255 || mt.seeds < 1) {
+        fprintf(stderr, "levels must be in 1..255 and count >= 1\n");
+        return 2;
+    }
+
+    simInitKeys();
+    const uint64_t jobs = (uint64_t)mt.levels * mt.seeds;
+    mt.results = calloc(jobs, sizeof(LevelMetrics));
+    if (!mt.results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    RunnerResult res;
+    if (runnerRun(&cfg, jobs, measure, &mt, &res) != 0) {
+        fprintf(stderr, "runner failed\n");
+        return 1;
+    }
+
+    if (summary) {
+        printf("level,seeds,walls,free,area,articulation,dead_ends,dead_end_cells,food_target,foods,unreachable_food,"
+               "food_path,food_path_closed\n");
+        for (u16 l = 0; l < mt.levels; l++) {
+            double mean[NUM_FIELDS] = { 0 };
+            for (u32 i = 0; i < mt.seeds; i++) {
+                double v[NUM_FIELDS];
+                fields(&mt.results[(uint64_t)l * mt.seeds + i], v);
+                for (u16 k = 0; k < NUM_FIELDS; k++) mean[k] += v[k] / mt.seeds;
+            }
+            printf("%u,%u", mt.firstLevel + l, mt.seeds);
+            for (u16 k = 0; k < NUM_FIELDS; k++) printf(",%.2f", mean[k]);
+            printf("\n");
+        }
+    } else {
+        printf("level,seed,walls,free,area,articulation,dead_ends,dead_end_cells,food_target,foods,unreachable_food,"
+               "food_path,food_path_closed\n");
+        for (uint64_t j = 0; j < jobs; j++) {
+            const LevelMetrics* r = &mt.results[j];
+            printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.2f,%.2f\n", (unsigned)(mt.firstLevel + j / mt.seeds),
+                   (u32)(mt.firstSeed + j % mt.seeds), r->walls, r->freeCells, r->area, r->articulation, r->deadEnds,
+                   r->deadEndCells, r->foodTarget, r->foods, r->unreachable, r->foodPath, r->foodPathClosed);
+        }
+    }
+    fprintf(stderr, "%llu levels measured  threads %u  steals %llu  %.2fs\n", (unsigned long long)res.jobs,
+            res.threads, (unsigned long long)res.steals, res.seconds);
+    free(mt.results);
+    return 0;
+}
@@ -0,0 +1,324 @@
+// Monte Carlo tree search benchmark agent
+//
+// Plays seeded games with UCT search on top of the sim core and reports score against compute, as an
+// upper bound on what the cartridge AI could reach. Every search iteration clones the root state (one
+// struct copy, SimState has no pointers), walks the tree with UCB1, expands one node and finishes with
+// an epsilon-greedy rollout of at most -d steps. Nodes come from a per-thread arena that is reset in
+// O(1) before each move, so a search does no heap allocation at all. Playouts that hit the depth cap
+// credit the pending food by its A* distance, which keeps short playouts informative.
+//
+// The tree is open loop: nodes hold statistics for action sequences, not states. By default each
+// iteration reseeds the clone's food generator, so the agent cannot exploit knowledge of where the next
+// food will spawn; -o keeps the real generator (oracle mode, a looser bound).
+//
+// Usage: mcts [-b budgets] [-n games] [-m maxSteps] [-d depth] [-e epsilon%] [-c uct] [-t threads] [-s seed]
+//             [-o] [-a] [-q]
+//   -b  comma-separated iteration budgets per move (default 0,16,64,256); 0 = cartridge AI for reference
+//   -n  games per budget (default 8, game i uses the same seed for every budget)
+//   -m  step cap per game (default 3000)
+//   -d  playout depth cap (default 8)
+//   -e  percent of random playout moves (default 0)
+//   -c  UCB1 exploration constant (default 0.1; rewards are in [0, 1] and food dominates)
+//   -a  playouts use the cartridge AI instead of the greedy policy (slower, stronger)
+// Output: one CSV row per budget (budget,games,score_mean,score_sd,level_mean,steps_mean,ms_per_move)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "play.h"
+#include "runner.h"
+
+#define MAX_BUDGETS 16
+#define NODE_NONE 0            // Child index meaning "not expanded" (node 0 is always the root)
+#define DEATH_REWARD 0.0
+#define ALIVE_REWARD 0.1       // Share of the reward range for surviving the iteration
+#define FOOD_DISCOUNT 0.9      // Per-step discount of food reward (sooner is better)
+
+typedef struct {
+    u32 child[4];              // Arena index per direction (NODE_NONE = not expanded)
+    u32 visits;
+    double value;              // Sum of rollout rewards
+} MctsNode;
+
+// Bump allocator for search nodes: grows once per thread, reset per move
+typedef struct {
+    MctsNode* nodes;
+    u32 capacity;
+    u32 used;
+} MctsArena;
+
+typedef struct {
+    u32 budget;                // Iterations per move (0 = cartridge AI)
+    u32 depth;                 // Rollout depth cap
+    u32 epsilon;               // Percent of random rollout moves
+    double uct;                // Exploration constant
+    int oracle;                // Keep the real food generator in clones
+    int aiRollout;             // Playouts use the cartridge AI instead of the greedy policy
+} MctsConfig;
+
+typedef struct {
+    u16 score;
+    u16 level;
+    u32 steps;
+    double seconds;
+} GameResult;
+
+typedef struct {
+    MctsConfig cfg[MAX_BUDGETS];
+    u32 numBudgets;
+    u32 games;                 // Games per budget
+    u32 maxSteps;
+    uint64_t baseSeed;
+    GameResult* results;       // numBudgets * games slots, one per job
+} Bench;
+
+static _Thread_local MctsArena arena;
+
+static u32 arenaAlloc(void) {
+    MctsNode* n = &arena.nodes[arena.used];
+    memset(n, 0, sizeof(*n));
+    return arena.used++;
+}
+
+// Makes room for one search of the given budget; the only allocation, once per thread and size
+static void arenaReset(u32 budget) {
+    const u32 needed = budget + 1;
+    if (arena.capacity < needed) {
+        free(arena.nodes);
+        arena.nodes = malloc(sizeof(MctsNode) * needed);
+        if (!arena.nodes) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        arena.capacity = needed;
+    }
+    arena.used = 0;
+}
+
+static u32 nextRandom(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Steps the clone; level ups are built immediately like in playGame()
+static u16 step(SimState* s, u16 dir) {
+    const u16 events = simStep(s, dir);
+    if (events & SIM_EVENT_LEVEL_UP) simInitLevel(s);
+    return events;
+}
+
+static u16 policyMove(const SimState* s, const MctsConfig* cfg) {
+    return cfg->aiRollout ? aiChooseMove(s, &aiDefaultWeights) : playGreedyMove(s);
+}
+
+// Iteration reward in [0, 1]: discounted food eaten in the tree and the playout (capped at one), plus a
+// small bonus for surviving; food must dominate or the search circles safely instead of eating
+static double reward(u16 alive, double food) {
+    return (alive ? ALIVE_REWARD : DEATH_REWARD) + (1.0 - ALIVE_REWARD) * (food < 1.0 ? food : 1.0);
+}
+
+// Epsilon-greedy playout continuing the food count of the tree walk
+static double rollout(SimState* s, const MctsConfig* cfg, u32* rng, double food, double discount) {
+    for (u32 i = 0; i < cfg->depth; i++) {
+        u16 dir = policyMove(s, cfg);
+        if (nextRandom(rng) % 100 < cfg->epsilon) {
+            dir = nextRandom(rng) % 4;
+            if (dir == simDirOpposite[s->direction]) dir = s->direction;
+        }
+        const u16 events = step(s, dir);
+        if (events & SIM_EVENT_DEAD) return reward(FALSE, food);
+        if (events & SIM_EVENT_WIN) return 1.0;
+        if (events & SIM_EVENT_ATE) food += discount;
+        discount *= FOOD_DISCOUNT;
+    }
+    // Cut-off playout: credit the pending food as if reached along the shortest path (portals included)
+    const u16 dist = aiPathLength(s, s->snakeBody[0], s->food);
+    return reward(TRUE, dist == AI_NO_PATH ? food : food + discount * pow(FOOD_DISCOUNT, dist));
+}
+
+// UCB1 over the expanded children; unexpanded moves come first, the playout policy's choice before the
+// others so that shallow trees are not averaged over arbitrary (often fatal) expansions
+static u16 selectChild(const MctsNode* node, const SimState* s, const MctsConfig* cfg, u16* unexpanded) {
+    u16 best = s->direction;
+    double bestScore = -1.0;
+    const double logN = log((double)node->visits + 1.0);
+    *unexpanded = FALSE;
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (dir == simDirOpposite[s->direction]) continue;
+        if (node->child[dir] == NODE_NONE) {
+            const u16 preferred = policyMove(s, cfg);
+            *unexpanded = TRUE;
+            return node->child[preferred] == NODE_NONE ? preferred : dir;
+        }
+        const MctsNode* c = &arena.nodes[node->child[dir]];
+        const double score = c->value / c->visits + cfg->uct * sqrt(logN / c->visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+static u16 mctsChooseMove(const SimState* root, const MctsConfig* cfg, u32* rng) {
+    u32 path[512];
+    arenaReset(cfg->budget);
+    arenaAlloc();
+    for (u32 it = 0; it < cfg->budget; it++) {
+        SimState s = *root;
+        if (!cfg->oracle) s.rngState = nextRandom(rng) | 1;
+        u32 depth = 0;
+        u32 node = 0;
+        double food = 0.0;
+        double discount = 1.0;
+        double value = -1.0;
+        path[depth++] = node;
+
+        // Selection and expansion
+        for (;;) {
+            u16 unexpanded;
+            const u16 dir = selectChild(&arena.nodes[node], &s, cfg, &unexpanded);
+            if (unexpanded) {
+                const u32 child = arenaAlloc();
+                arena.nodes[node].child[dir] = child;
+                node = child;
+            } else {
+                node = arena.nodes[node].child[dir];
+            }
+            path[depth++] = node;
+            const u16 events = step(&s, dir);
+            if (events & SIM_EVENT_ATE) food += discount;
+            discount *= FOOD_DISCOUNT;
+            if (events & SIM_EVENT_DEAD) value = reward(FALSE, food);
+            else if (events & SIM_EVENT_WIN) value = 1.0;
+            if (value >= 0.0 || unexpanded || depth == sizeof(path) / sizeof(path[0])) break;
+        }
+
+        // Simulation and backpropagation
+        if (value < 0.0) value = rollout(&s, cfg, rng, food, discount);
+        for (u32 i = 0; i < depth; i++) {
+            arena.nodes[path[i]].visits++;
+            arena.nodes[path[i]].value += value;
+        }
+    }
+
+    // Most visited root move is the most robust choice; ties (small budgets) go to the better mean
+    const MctsNode* r = &arena.nodes[0];
+    u16 best = root->direction;
+    u32 bestVisits = 0;
+    double bestMean = -1.0;
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (r->child[dir] == NODE_NONE) continue;
+        const MctsNode* c = &arena.nodes[r->child[dir]];
+        const double mean = c->value / c->visits;
+        if (c->visits > bestVisits || (c->visits == bestVisits && mean > bestMean)) {
+            bestVisits = c->visits;
+            bestMean = mean;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void runGame(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    Bench* b = user;
+    const MctsConfig* cfg = &b->cfg[job / b->games];
+    const u32 seed = (u32)runnerJobSeed(b->baseSeed, job % b->games);
+    u32 rng = seed | 1;
+    SimState s;
+    const double start = now();
+    simInitGame(&s, seed);
+    while (s.stepCount < b->maxSteps) {
+        const u16 dir = cfg->budget ? mctsChooseMove(&s, cfg, &rng) : aiChooseMove(&s, &aiDefaultWeights);
+        if (step(&s, dir) & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+    }
+    GameResult* r = &b->results[job];
+    r->score = s.score;
+    r->level = s.currentLevel;
+    r->steps = s.stepCount;
+    r->seconds = now() - start;
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig rc = { 0, 1, 1 };
+    Bench b;
+    MctsConfig base = { 0, 8, 0, 0.1, 0, 0 };
+    const char* budgets = "0,16,64,256";
+    memset(&b, 0, sizeof(b));
+    b.games = 8;
+    b.maxSteps = 3000;
+    b.baseSeed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:n:m:d:e:c:t:s:oaq")) != -1) {
+        switch (opt) {
+            case 'b': budgets = optarg; break;
+            case 'n': b.games = (u32)strtoul(optarg, NULL, 0); break;
+            case 'm': b.maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 'd': base.depth = (u32)strtoul(optarg, NULL, 0); break;
+            case 'e': base.epsilon = (u32)strtoul(optarg, NULL, 0); break;
+            case 'c': base.uct = atof(optarg); break;
+            case 't': rc.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': b.baseSeed = strtoull(optarg, NULL, 0); break;
+            case 'o': base.oracle = 1; break;
+            case 'a': base.aiRollout = 1; break;
+            case 'q': rc.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-b budgets] [-n games] [-m maxSteps] [-d depth] [-e epsilon%%] [-c uct] "
+                                "[-t threads] [-s seed] [-o] [-a] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+    for (const char* p = budgets; *p && b.numBudgets < MAX_BUDGETS; p = strchr(p, ',') ? strchr(p, ',') + 1 : "") {
+        b.cfg[b.numBudgets] = base;
+        b.cfg[b.numBudgets++].budget = (u32)strtoul(p, NULL, 0);
+    }
+    if (!b.numBudgets || !b.games) {
+        fprintf(stderr, "need at least one budget and one game\n");
+        return 2;
+    }
+    rc.seed = b.baseSeed;
+
+    simInitKeys();
+    const uint64_t jobs = (uint64_t)b.numBudgets * b.games;
+    b.results = calloc(jobs, sizeof(GameResult));
+    RunnerResult res;
+    if (!b.results || runnerRun(&rc, jobs, runGame, &b, &res) != 0) {
+        fprintf(stderr, "run failed\n");
+        return 1;
+    }
+
+    printf("budget,games,score_mean,score_sd,level_mean,steps_mean,ms_per_move\n");
+    for (u32 i = 0; i < b.numBudgets; i++) {
+        double sum = 0.0, sumSq = 0.0, level = 0.0, steps = 0.0, seconds = 0.0;
+        for (u32 g = 0; g < b.games; g++) {
+            const GameResult* r = &b.results[i * b.games + g];
+            sum += r->score;
+            sumSq += (double)r->score * r->score;
+            level += r->level;
+            steps += r->steps;
+            seconds += r->seconds;
+        }
+        const double mean = sum / b.games;
+        const double var = sumSq / b.games - mean * mean;
+        printf("%u,%u,%.1f,%.1f,%.2f,%.0f,%.3f\n", b.cfg[i].budget, b.games, mean, var > 0.0 ? sqrt(var) : 0.0,
+               level / b.games, steps / b.games, steps > 0.0 ? seconds * 1000.0 / steps : 0.0);
+    }
+    fprintf(stderr, "%llu games  threads %u  steals %llu  %.2fs\n", (unsigned long long)res.jobs, res.threads,
+            (unsigned long long)res.steals, res.seconds);
+    free(b.results);
+    return 0;
+}
@@ -0,0 +1,422 @@
+// Trainer for the quantized MLP policy (see ../src/nn.h)
+//
+// 1. Plays seeded AI self-play games in parallel and records (features, AI move, legal moves) per step,
+//    or reads (observation, action) records from a dataset file (-d, see dataset.h), e.g. human replays.
+// 2. Trains a float 57-16-4 tanh MLP with masked softmax cross-entropy (plain SGD, shuffled samples).
+// 3. Quantizes: int8 input and output weights, int16 hidden biases, int32 output biases and a tanh
+//    lookup table matched to the input weight scale, exactly as nnForward() evaluates them.
+// 4. Reports float and quantized accuracy on held-out games, plays evaluation games with the quantized
+//    model and writes the generated header.
+//
+// Usage: nntrain [-n games | -d data.bin] [-m maxSteps] [-e epochs] [-r rate] [-v evalGames] [-t threads]
+//                [-s seed] [-o src/nn_weights.h] [-q]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "nn.h"
+#include "play.h"
+#include "runner.h"
+
+#define HOLDOUT_PERCENT 10     // Last games (or records, with -d) are held out for accuracy
+#define ACT_RANGE 4.0          // tanh table covers pre-activations in [-ACT_RANGE, ACT_RANGE)
+
+typedef struct {
+    u8 count;                  // Active inputs
+    u8 label;                  // AI move
+    u8 legal;                  // nnLegalMask()
+    u8 active[NN_INPUTS];      // Active input indices
+} Sample;
+
+typedef struct {
+    Sample* samples;
+    size_t count;
+    size_t capacity;
+} GameLog;
+
+typedef struct {
+    uint64_t baseSeed;
+    u32 maxSteps;
+    GameLog* logs;             // One per game, written only by its job
+    const NnModel* model;      // Evaluation model (NULL while recording)
+    u16* scores;               // Evaluation scores, one per game
+} Job;
+
+// Float model
+static float w1[NN_INPUTS][NN_HIDDEN];
+static float b1[NN_HIDDEN];
+static float w2[NN_HIDDEN][NN_OUTPUTS];
+static float b2[NN_OUTPUTS];
+
+// Quantized model
+static s8 qW1[NN_INPUTS][NN_HIDDEN];
+static s16 qB1[NN_HIDDEN];
+static s8 qAct[256];
+static s8 qW2[NN_HIDDEN][NN_OUTPUTS];
+static s32 qB2[NN_OUTPUTS];
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ull;
+
+static uint64_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static float uniform(float scale) {
+    return ((nextRandom() >> 11) * (1.0 / 9007199254740992.0) * 2.0 - 1.0) * scale;
+}
+
+static void recordGame(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    Job* j = user;
+    GameLog* log = &j->logs[job];
+    SimState s;
+    simInitGame(&s, (u32)runnerJobSeed(j->baseSeed, job));
+    while (s.stepCount < j->maxSteps) {
+        const u16 dir = aiChooseMove(&s, &aiDefaultWeights);
+        const u16 legal = nnLegalMask(&s);
+        if (legal & (1 << dir)) {
+            if (log->count == log->capacity) {
+                log->capacity = log->capacity ? log->capacity * 2 : 1024;
+                log->samples = realloc(log->samples, log->capacity * sizeof(Sample));
+                if (!log->samples) {
+                    fprintf(stderr, "out of memory\n");
+                    exit(1);
+                }
+            }
+            Sample* sm = &log->samples[log->count++];
+            sm->count = nnFeatures(&s, sm->active);
+            sm->label = dir;
+            sm->legal = legal;
+        }
+        const u16 events = simStep(&s, dir);
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+    }
+}
+
+// Loads the legal records of a dataset file into one log
+static int loadDataset(const char* path, GameLog* log) {
+    Dataset ds;
+    if (datasetOpen(path, &ds) != 0) return -1;
+    log->samples = malloc((ds.count ? ds.count : 1) * sizeof(Sample));
+    if (!log->samples) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < ds.count; i++) {
+        const DatasetRecord* r = &ds.records[i];
+        if (!(r->legal & (1 << r->action))) continue;
+        Sample* sm = &log->samples[log->count++];
+        sm->count = 0;
+        for (u16 k = 0; k < NN_INPUTS; k++) {
+            if (r->features & ((uint64_t)1 << k)) sm->active[sm->count++] = k;
+        }
+        sm->label = r->action;
+        sm->legal = r->legal;
+    }
+    datasetClose(&ds);
+    return 0;
+}
+
+static void evalGame(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    Job* j = user;
+    SimState s;
+    simInitGame(&s, (u32)runnerJobSeed(j->baseSeed, job));
+    while (s.stepCount < j->maxSteps) {
+        const u16 events = simStep(&s, nnChooseMove(&s, j->model));
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+    }
+    j->scores[job] = s.score;
+}
+
+// Float forward pass; returns the masked softmax in p
+static void forward(const Sample* sm, float* hidden, float* p) {
+    for (u16 j = 0; j < NN_HIDDEN; j++) hidden[j] = b1[j];
+    for (u16 i = 0; i < sm->count; i++) {
+        for (u16 j = 0; j < NN_HIDDEN; j++) hidden[j] += w1[sm->active[i]][j];
+    }
+    for (u16 j = 0; j < NN_HIDDEN; j++) hidden[j] = tanhf(hidden[j]);
+    float maxZ = -1e30f;
+    float z[NN_OUTPUTS];
+    for (u16 o = 0; o < NN_OUTPUTS; o++) {
+        z[o] = b2[o];
+        for (u16 j = 0; j < NN_HIDDEN; j++) z[o] += w2[j][o] * hidden[j];
+        if ((sm->legal & (1 << o)) && z[o] > maxZ) maxZ = z[o];
+    }
+    float sum = 0.0f;
+    for (u16 o = 0; o < NN_OUTPUTS; o++) {
+        p[o] = (sm->legal & (1 << o)) ? expf(z[o] - maxZ) : 0.0f;
+        sum += p[o];
+    }
+    for (u16 o = 0; o < NN_OUTPUTS; o++) p[o] /= sum;
+}
+
+static void trainSample(const Sample* sm, float rate) {
+    float hidden[NN_HIDDEN];
+    float p[NN_OUTPUTS];
+    float dHidden[NN_HIDDEN];
+    forward(sm, hidden, p);
+    p[sm->label] -= 1.0f;      // Softmax cross-entropy gradient
+    for (u16 j = 0; j < NN_HIDDEN; j++) {
+        float d = 0.0f;
+        for (u16 o = 0; o < NN_OUTPUTS; o++) {
+            d += w2[j][o] * p[o];
+            w2[j][o] -= rate * p[o] * hidden[j];
+        }
+        dHidden[j] = d * (1.0f - hidden[j] * hidden[j]);
+    }
+    for (u16 o = 0; o < NN_OUTPUTS; o++) b2[o] -= rate * p[o];
+    for (u16 j = 0; j < NN_HIDDEN; j++) b1[j] -= rate * dHidden[j];
+    for (u16 i = 0; i < sm->count; i++) {
+        for (u16 j = 0; j < NN_HIDDEN; j++) w1[sm->active[i]][j] -= rate * dHidden[j];
+    }
+}
+
+static u16 argmaxLegal(const float* p, u16 legal) {
+    u16 best = 0;
+    for (u16 o = 0; o < NN_OUTPUTS; o++) {
+        if ((legal & (1 << o)) && (!(legal & (1 << best)) || p[o] > p[best])) best = o;
+    }
+    return best;
+}
+
+static double accuracy(Sample* const* set, size_t n, int quantized, const NnModel* m) {
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Sample* sm = set[i];
+        u16 move;
+        if (quantized) {
+            s32 logits[NN_OUTPUTS];
+            float z[NN_OUTPUTS];
+            nnForward(m, sm->active, sm->count, logits);
+            for (u16 o = 0; o < NN_OUTPUTS; o++) z[o] = (float)logits[o];
+            move = argmaxLegal(z, sm->legal);
+        } else {
+            float hidden[NN_HIDDEN];
+            float p[NN_OUTPUTS];
+            forward(sm, hidden, p);
+            move = argmaxLegal(p, sm->legal);
+        }
+        hits += move == sm->label;
+    }
+    return n ? 100.0 * hits / n : 0.0;
+}
+
+static float maxAbs(const float* v, size_t n) {
+    float m = 1e-6f;
+    for (size_t i = 0; i < n; i++) m = fabsf(v[i]) > m ? fabsf(v[i]) : m;
+    return m;
+}
+
+static s32 quantize(float v, float scale, s32 lo, s32 hi) {
+    const s32 q = (s32)lrintf(v * scale);
+    return q < lo ? lo : (q > hi ? hi : q);
+}
+
+// Pre-activations are stored at scale s1; the table index is (pre-activation >> shift) + 128
+static u16 quantizeModel(void) {
+    const float s1 = 127.0f / maxAbs(&w1[0][0], NN_INPUTS * NN_HIDDEN);
+    const float s2 = 127.0f / maxAbs(&w2[0][0], NN_HIDDEN * NN_OUTPUTS);
+    u16 shift = 0;
+    while ((128 << (shift + 1)) / s1 <= ACT_RANGE) shift++;
+    for (u16 i = 0; i < NN_INPUTS; i++) {
+        for (u16 j = 0; j < NN_HIDDEN; j++) qW1[i][j] = quantize(w1[i][j], s1, -127, 127);
+    }
+    for (u16 j = 0; j < NN_HIDDEN; j++) qB1[j] = quantize(b1[j], s1, -32767, 32767);
+    for (u16 k = 0; k < 256; k++) {
+        const float h = (((s32)k - 128) * (1 << shift) + (1 << shift) / 2.0f) / s1;
+        qAct[k] = quantize(tanhf(h), 127.0f, -127, 127);
+    }
+    for (u16 j = 0; j < NN_HIDDEN; j++) {
+        for (u16 o = 0; o < NN_OUTPUTS; o++) qW2[j][o] = quantize(w2[j][o], s2, -127, 127);
+    }
+    for (u16 o = 0; o < NN_OUTPUTS; o++) qB2[o] = quantize(b2[o], s2 * 127.0f, -0x7FFFFFFF, 0x7FFFFFFF);
+    return shift;
+}
+
+// Writes a const array initializer; 2D arrays (nested) get one braced row per line
+static void writeArray(FILE* f, const char* decl, const s32* v, size_t n, size_t perLine, int nested) {
+    fprintf(f, "%s = {\n", decl);
+    for (size_t i = 0; i < n; i++) {
+        if (i % perLine == 0) fprintf(f, nested ? "    {" : "   ");
+        fprintf(f, " %d%s", v[i], (nested && (i % perLine == perLine - 1)) ? "" : ",");
+        if (i % perLine == perLine - 1 || i == n - 1) fprintf(f, nested ? " },\n" : "\n");
+    }
+    fprintf(f, "};\n");
+}
+
+static int writeHeader(const char* path, u16 shift, size_t samples, double acc, double score) {
+    s32 buf[NN_INPUTS * NN_HIDDEN];
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "// MLP policy weights (see nn.h)\n");
+    fprintf(f, "// Generated by tools/nntrain (%zu samples, held-out accuracy %.1f%%, mean score %.0f) -- regenerate rather than edit\n",
+            samples, acc, score);
+    fprintf(f, "\n#ifndef _NN_WEIGHTS_H_\n#define _NN_WEIGHTS_H_\n\n");
+    fprintf(f, "#define NN_ACT_SHIFT %u\n\n", shift);
+    for (size_t i = 0; i < NN_INPUTS * NN_HIDDEN; i++) buf[i] = (&qW1[0][0])[i];
+    writeArray(f, "static const s8 nnW1[NN_INPUTS][NN_HIDDEN]", buf, NN_INPUTS * NN_HIDDEN, NN_HIDDEN, 1);
+    for (size_t i = 0; i < NN_HIDDEN; i++) buf[i] = qB1[i];
+    writeArray(f, "static const s16 nnB1[NN_HIDDEN]", buf, NN_HIDDEN, NN_HIDDEN, 0);
+    for (size_t i = 0; i < 256; i++) buf[i] = qAct[i];
+    writeArray(f, "static const s8 nnAct[256]", buf, 256, 16, 0);
+    for (size_t i = 0; i < NN_HIDDEN * NN_OUTPUTS; i++) buf[i] = (&qW2[0][0])[i];
+    writeArray(f, "static const s8 nnW2[NN_HIDDEN][NN_OUTPUTS]", buf, NN_HIDDEN * NN_OUTPUTS, NN_OUTPUTS, 1);
+    for (size_t i = 0; i < NN_OUTPUTS; i++) buf[i] = qB2[i];
+    writeArray(f, "static const s32 nnB2[NN_OUTPUTS]", buf, NN_OUTPUTS, NN_OUTPUTS, 0);
+    fprintf(f, "\n#endif // _NN_WEIGHTS_H_\n");
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    u32 games = 200;
+    u32 evalGames = 100;
+    u32 epochs = 6;
+    float rate = 0.02f;
+    const char* outPath = NULL;
+    const char* dataPath = NULL;
+    Job job = { 1, 5000, NULL, NULL, NULL };
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:m:e:r:v:t:s:o:q")) != -1) {
+        switch (opt) {
+            case 'n': games = (u32)strtoul(optarg, NULL, 0); break;
+            case 'd': dataPath = optarg; break;
+            case 'm': job.maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 'e': epochs = (u32)strtoul(optarg, NULL, 0); break;
+            case 'r': rate = (float)atof(optarg); break;
+            case 'v': evalGames = (u32)strtoul(optarg, NULL, 0); break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': job.baseSeed = strtoull(optarg, NULL, 0); break;
+            case 'o': outPath = optarg; break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-n games | -d data.bin] [-m maxSteps] [-e epochs] [-r rate] [-v evalGames] [-t threads] "
+                                "[-s seed] [-o header] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+    if ((!dataPath && games < 2) || !evalGames) {
+        fprintf(stderr, "need at least 2 training games and 1 evaluation game\n");
+        return 2;
+    }
+    cfg.seed = job.baseSeed;
+    simInitKeys();
+
+    // 1. Dataset from AI self-play or from a dataset file
+    RunnerResult res;
+    size_t trainCount = 0;
+    size_t total = 0;
+    if (dataPath) {
+        games = 1;
+        job.logs = calloc(1, sizeof(GameLog));
+        if (!job.logs) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (loadDataset(dataPath, &job.logs[0]) != 0) return 1;
+        total = job.logs[0].count;
+        trainCount = total - total * HOLDOUT_PERCENT / 100;
+        res.seconds = 0.0;
+    } else {
+        job.logs = calloc(games, sizeof(GameLog));
+        if (!job.logs) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (runnerRun(&cfg, games, recordGame, &job, &res) != 0) {
+            fprintf(stderr, "runner failed\n");
+            return 1;
+        }
+        const u32 trainGames = games - (games * HOLDOUT_PERCENT + 99) / 100;
+        for (u32 g = 0; g < games; g++) {
+            total += job.logs[g].count;
+            if (g < trainGames) trainCount += job.logs[g].count;
+        }
+    }
+    if (!trainCount) {
+        fprintf(stderr, "no training samples\n");
+        return 1;
+    }
+    Sample** set = malloc(total * sizeof(Sample*));
+    if (!set) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t n = 0;
+    for (u32 g = 0; g < games; g++) {
+        for (size_t i = 0; i < job.logs[g].count; i++) set[n++] = &job.logs[g].samples[i];
+    }
+    fprintf(stderr, "%zu samples (%zu train) from %s in %.1fs\n", total, trainCount, dataPath ? dataPath : "self-play", res.seconds);
+
+    // 2. Float training
+    for (u16 i = 0; i < NN_INPUTS; i++) {
+        for (u16 j = 0; j < NN_HIDDEN; j++) w1[i][j] = uniform(1.0f / sqrtf(8.0f));
+    }
+    for (u16 j = 0; j < NN_HIDDEN; j++) {
+        for (u16 o = 0; o < NN_OUTPUTS; o++) w2[j][o] = uniform(1.0f / sqrtf(NN_HIDDEN));
+    }
+    Sample** order = malloc(trainCount * sizeof(Sample*));
+    if (!order) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    memcpy(order, set, trainCount * sizeof(Sample*));
+    for (u32 e = 0; e < epochs; e++) {
+        for (size_t i = trainCount; i > 1; i--) {
+            const size_t k = nextRandom() % i;
+            Sample* t = order[i - 1];
+            order[i - 1] = order[k];
+            order[k] = t;
+        }
+        const float r = rate / (1.0f + e);
+        for (size_t i = 0; i < trainCount; i++) trainSample(order[i], r);
+        fprintf(stderr, "epoch %u  train %.1f%%  held-out %.1f%%\n", e, accuracy(set, trainCount, 0, NULL),
+                accuracy(set + trainCount, total - trainCount, 0, NULL));
+    }
+
+    // 3. Quantization, checked against the exact integer kernel
+    const u16 shift = quantizeModel();
+    const NnModel model = { &qW1[0][0], qB1, qAct, shift, &qW2[0][0], qB2 };
+    const double acc = accuracy(set + trainCount, total - trainCount, 1, &model);
+    fprintf(stderr, "quantized held-out accuracy %.1f%% (act shift %u)\n", acc, shift);
+
+    // 4. Evaluation games on seeds disjoint from the dataset
+    job.model = &model;
+    job.baseSeed = ~job.baseSeed;
+    job.scores = calloc(evalGames, sizeof(u16));
+    if (!job.scores) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    if (runnerRun(&cfg, evalGames, evalGame, &job, &res) != 0) {
+        fprintf(stderr, "runner failed\n");
+        return 1;
+    }
+    double score = 0.0;
+    for (u32 g = 0; g < evalGames; g++) score += job.scores[g];
+    score /= evalGames;
+    printf("samples %zu  held-out accuracy %.1f%%  mean score %.1f over %u games\n", total, acc, score, evalGames);
+
+    int rc = 0;
+    if (outPath) rc = writeHeader(outPath, shift, total, acc, score);
+    for (u32 g = 0; g < games; g++) free(job.logs[g].samples);
+    free(job.logs);
+    free(job.scores);
+    free(order);
+    free(set);
+    return rc ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+// Shared game driver for the host tools (see play.h)
+
+#include "play.h"
+
+// Among the non-reversing moves that survive, take the one closest to the food
+u16 playGreedyMove(const SimState* s) {
+    u16 best = s->direction;
+    s32 bestDist = 0x7FFFFFFF;
+    for (u16 dir = 0; dir < 4; dir++) {
+        if (dir == simDirOpposite[s->direction]) continue;
+        Point head;
+        simNextHead(s, dir, &head);
+        if (simIsBlocked(s, head.x, head.y)) continue;
+        const s32 dist = abs(head.x - s->food.x) + abs(head.y - s->food.y);
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+// Plays a seeded game until death, a full board or maxSteps; levels are built immediately on level up
+u16 playGame(SimState* s, u32 seed, u16 foodPolicy, u16 policy, const AiWeights* w, u32 maxSteps) {
+    u16 events = 0;
+    simInitGameEx(s, seed, foodPolicy);
+    while (s->stepCount < maxSteps) {
+        u16 dir;
+        if (policy == PLAY_POLICY_GREEDY) dir = playGreedyMove(s);
+        else if (policy == PLAY_POLICY_NN) dir = nnChooseMove(s, &nnDefaultModel);
+        else dir = aiChooseMove(s, w);
+        events = simStep(s, dir);
+        if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+        if (events & SIM_EVENT_LEVEL_UP) simInitLevel(s);
+    }
+    return events;
+}
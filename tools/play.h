@@ -0,0 +1,17 @@
+// Shared game driver for the host tools
+
+#ifndef _PLAY_H_
+#define _PLAY_H_
+
+#include "ai.h"
+#include "nn.h"
+#include "sim.h"
+
+#define PLAY_POLICY_AI 0       // aiChooseMove() with the given weights
+#define PLAY_POLICY_GREEDY 1   // Closest-to-food surviving move (baseline)
+#define PLAY_POLICY_NN 2       // nnChooseMove() with the ROM model
+
+u16 playGreedyMove(const SimState* s);    // Baseline policy
+u16 playGame(SimState* s, u32 seed, u16 foodPolicy, u16 policy, const AiWeights* w, u32 maxSteps); // Plays to the end; returns final events
+
+#endif // _PLAY_H_
@@ -0,0 +1,430 @@
+// RAM and stack budget of a ROM build: where the 64KB go, and how deep the stack can get
+//
+// RAM: every data and bss symbol of the linked ELF (rom.out) with its size and module, plus per-module
+// totals. A symbol's module comes from the object files given on the command line (the one object that
+// defines the name), else from the file symbol the linker keeps in front of a module's static symbols.
+// Bytes of the RAM sections not covered by a sized symbol (alignment, assembly labels) are listed as
+// "(unattributed)".
+//
+// Stack: GCC's call graph files (-fcallgraph-info=su, one .ci per object) give each function's frame and
+// its direct calls. The worst depth of an entry function is its frame, a return address and the deepest
+// callee, recursively. An indirect call (state table, callbacks) is assumed to reach any function no
+// other function calls directly, except the entries and interrupt handlers. Each interrupt handler adds
+// its own worst depth and an exception entry allowance on top of the entries' worst depth. Functions
+// without stack information (SGDK library, assembly) count -u bytes each, recursion counts one frame,
+// and both are named in the report.
+//
+// Prints CSV (kind, name, bytes, detail) and exits with status 1 when a budget is exceeded, so a build
+// step fails: make -f rom.mk budget (see ../rom.mk). A missing entry or interrupt function also fails, and
+// so does a stack budget without any .ci file (an LTO build writes none).
+//
+// Usage: rambudget [-r ramBudget] [-s stackBudget] [-e entry]... [-i interrupt]... [-u unknownFrame]
+//                  [-n symbols] rom.out [object.o | callgraph.ci]...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "elf.h"
+
+#define RETURN_ADDRESS 4       // Pushed by every JSR/BSR (counted even if a frame already includes it)
+#define INTERRUPT_ENTRY 64     // Exception frame plus the registers SGDK's dispatcher saves before the handler
+#define MAX_ROOTS 8
+#define MAX_LINE 1024
+#define DEPTH_UNKNOWN 0xFFFFFFFFu
+
+typedef struct {
+    char* name;
+    char* module;              // NULL: defined in several objects (a static name used twice)
+} Definition;
+
+typedef struct {
+    char* name;
+    char* module;
+    uint64_t size;
+} RamSymbol;
+
+typedef struct {
+    char* title;               // Global name, or "file:name" for a static function
+    unsigned frame;
+    int known;                 // Frame size read from a .ci node (not just referenced)
+    int dynamic;               // Frame has a dynamic part (alloca, VLA)
+    int called;                // Some function calls it directly
+    int* callees;              // Node indexes; INDIRECT for an indirect call
+    unsigned calleeCount;
+    unsigned calleeCap;
+    uint32_t depth;            // Worst depth from here (DEPTH_UNKNOWN: not computed yet)
+    int visiting;              // On the current search path (recursion)
+    int next;                  // Deepest callee (-1: none)
+} Node;
+
+typedef struct {
+    Node* nodes;
+    unsigned count;
+    unsigned cap;
+    int* indirect;             // Targets assumed for an indirect call
+    unsigned indirectCount;
+    unsigned unknownFrame;
+    int recursive;             // Some path closed a cycle
+} Graph;
+
+#define INDIRECT (-2)
+
+static Definition* defs;
+static unsigned defCount, defCap;
+
+static char* copyString(const char* s, size_t n) {
+    char* c = malloc(n + 1);
+    memcpy(c, s, n);
+    c[n] = 0;
+    return c;
+}
+
+// "out/src/main.o" -> "main"
+static char* moduleName(const char* path) {
+    const char* base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char* dot = strrchr(base, '.');
+    return copyString(base, dot ? (size_t)(dot - base) : strlen(base));
+}
+
+// Records the symbols an object file defines; a name defined by two objects gets no module
+static int addObject(const char* path) {
+    Elf e;
+    if (elfLoad(path, &e)) return -1;
+    char* module = moduleName(path);
+    const unsigned n = elfSymbolCount(&e);
+    for (unsigned i = 1; i < n; i++) {
+        ElfSymbol s;
+        elfSymbol(&e, i, &s);
+        if (!s.shndx || s.type == ELF_STT_FILE || !*s.name) continue;
+        unsigned k = 0;
+        while (k < defCount && strcmp(defs[k].name, s.name)) k++;
+        if (k < defCount) {
+            if (defs[k].module && strcmp(defs[k].module, module)) defs[k].module = NULL;
+            continue;
+        }
+        if (defCount == defCap) defs = realloc(defs, sizeof(Definition) * (defCap = defCap ? defCap * 2 : 256));
+        defs[defCount].name = copyString(s.name, strlen(s.name));
+        defs[defCount++].module = module;
+    }
+    elfFree(&e);
+    return 0;
+}
+
+static const char* definedIn(const char* name) {
+    for (unsigned k = 0; k < defCount; k++) {
+        if (!strcmp(defs[k].name, name)) return defs[k].module;
+    }
+    return NULL;
+}
+
+static int bySizeDown(const void* a, const void* b) {
+    const RamSymbol* x = a;
+    const RamSymbol* y = b;
+    if (x->size != y->size) return x->size < y->size ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+// Lists the RAM symbols and module totals; returns the RAM taken by .data and .bss
+static uint64_t reportRam(const Elf* e, unsigned topSymbols) {
+    const unsigned n = elfSymbolCount(e);
+    RamSymbol* syms = calloc(n ? n : 1, sizeof(RamSymbol));
+    unsigned count = 0;
+    uint64_t sectionBytes = 0, symbolBytes = 0;
+    const char* file = NULL;
+    for (unsigned i = 0; i < e->shnum; i++) {
+        ElfSection s;
+        elfSection(e, i, &s);
+        if (ELF_IS_RAM(&s)) sectionBytes += s.size;
+    }
+    for (unsigned i = 1; i < n; i++) {
+        ElfSymbol s;
+        ElfSection sec;
+        elfSymbol(e, i, &s);
+        if (s.type == ELF_STT_FILE) {
+            file = s.name;
+            continue;
+        }
+        if (s.bind != ELF_STB_LOCAL) file = NULL;   // Globals follow all the locals
+        if (!s.size || !s.shndx || s.shndx >= e->shnum) continue;
+        if (s.type != ELF_STT_OBJECT && s.type != ELF_STT_TLS && s.type != ELF_STT_NOTYPE) continue;
+        elfSection(e, s.shndx, &sec);
+        if (!ELF_IS_RAM(&sec)) continue;
+        const char* module = definedIn(s.name);
+        RamSymbol* r = &syms[count++];
+        r->name = copyString(s.name, strlen(s.name));
+        r->module = module ? copyString(module, strlen(module)) : file ? moduleName(file) : copyString("?", 1);
+        r->size = s.size;
+        symbolBytes += s.size;
+    }
+    qsort(syms, count, sizeof(RamSymbol), bySizeDown);
+
+    // Module totals, largest first (a module's symbols are summed in the order of its largest one)
+    RamSymbol* modules = calloc(count + 1, sizeof(RamSymbol));
+    unsigned moduleCount = 0;
+    for (unsigned i = 0; i < count; i++) {
+        unsigned k = 0;
+        while (k < moduleCount && strcmp(modules[k].name, syms[i].module)) k++;
+        if (k == moduleCount) modules[moduleCount++].name = syms[i].module;
+        modules[k].size += syms[i].size;
+    }
+    if (sectionBytes > symbolBytes) {
+        modules[moduleCount].name = "(unattributed)";
+        modules[moduleCount++].size = sectionBytes - symbolBytes;
+    }
+    qsort(modules, moduleCount, sizeof(RamSymbol), bySizeDown);
+    for (unsigned k = 0; k < moduleCount; k++) {
+        printf("module,%s,%llu,%.1f%%\n", modules[k].name, (unsigned long long)modules[k].size,
+               sectionBytes ? 100.0 * modules[k].size / sectionBytes : 0.0);
+    }
+    for (unsigned i = 0; i < count && i < topSymbols; i++) {
+        printf("symbol,%s,%llu,%s\n", syms[i].name, (unsigned long long)syms[i].size, syms[i].module);
+    }
+    for (unsigned i = 0; i < count; i++) {
+        free(syms[i].name);
+        free(syms[i].module);
+    }
+    free(modules);
+    free(syms);
+    return sectionBytes;
+}
+
+static int findNode(const Graph* g, const char* title) {
+    for (unsigned i = 0; i < g->count; i++) {
+        if (!strcmp(g->nodes[i].title, title)) return (int)i;
+    }
+    return -1;
+}
+
+static int addNode(Graph* g, const char* title) {
+    const int found = findNode(g, title);
+    if (found >= 0) return found;
+    if (g->count == g->cap) g->nodes = realloc(g->nodes, sizeof(Node) * (g->cap = g->cap ? g->cap * 2 : 256));
+    Node* n = &g->nodes[g->count];
+    memset(n, 0, sizeof(*n));
+    n->title = copyString(title, strlen(title));
+    n->depth = DEPTH_UNKNOWN;
+    n->next = -1;
+    return (int)g->count++;
+}
+
+// Entry or handler by name: a global title, or the ":name" end of a static one
+static int findFunction(const Graph* g, const char* name) {
+    const size_t len = strlen(name);
+    const int exact = findNode(g, name);
+    if (exact >= 0) return exact;
+    for (unsigned i = 0; i < g->count; i++) {
+        const size_t t = strlen(g->nodes[i].title);
+        if (t > len && g->nodes[i].title[t - len - 1] == ':' && !strcmp(g->nodes[i].title + t - len, name)) return (int)i;
+    }
+    return -1;
+}
+
+// Value of key: "..." on a .ci line
+static int quoted(const char* line, const char* key, char* out, size_t n) {
+    const char* p = strstr(line, key);
+    if (!p) return 0;
+    p += strlen(key);
+    const char* end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= n) return 0;
+    memcpy(out, p, end - p);
+    out[end - p] = 0;
+    return 1;
+}
+
+// Reads the nodes (frame sizes) and edges (direct and indirect calls) of one .ci file
+static int addCallGraph(Graph* g, const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[MAX_LINE], a[MAX_LINE / 2], b[MAX_LINE / 2];
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "node:", 5) && quoted(line, "title: \"", a, sizeof(a))) {
+            const int i = addNode(g, a);
+            const char* bytes = strstr(line, " bytes (");
+            if (!bytes) continue;                   // Declared only, or the indirect call placeholder
+            const char* p = bytes;
+            while (p > line && p[-1] >= '0' && p[-1] <= '9') p--;
+            g->nodes[i].frame = (unsigned)strtoul(p, NULL, 10);
+            g->nodes[i].known = 1;
+            g->nodes[i].dynamic = !!strstr(bytes, "dynamic");
+        } else if (!strncmp(line, "edge:", 5) && quoted(line, "sourcename: \"", a, sizeof(a)) &&
+                   quoted(line, "targetname: \"", b, sizeof(b))) {
+            const int from = addNode(g, a);
+            const int to = strcmp(b, "__indirect_call") ? addNode(g, b) : INDIRECT;
+            Node* n = &g->nodes[from];
+            unsigned k = 0;
+            while (k < n->calleeCount && n->callees[k] != to) k++;
+            if (k < n->calleeCount) continue;       // Same call from another line
+            if (n->calleeCount == n->calleeCap) {
+                n->callees = realloc(n->callees, sizeof(int) * (n->calleeCap = n->calleeCap ? n->calleeCap * 2 : 8));
+            }
+            n->callees[n->calleeCount++] = to;
+            if (to >= 0) g->nodes[to].called = 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static uint32_t depth(Graph* g, int i);
+
+static uint32_t calleeDepth(Graph* g, int c, int* best) {
+    if (c != INDIRECT) return depth(g, c);
+    uint32_t worst = 0;
+    for (unsigned k = 0; k < g->indirectCount; k++) {
+        const uint32_t d = depth(g, g->indirect[k]);
+        if (d > worst) {
+            worst = d;
+            *best = g->indirect[k];
+        }
+    }
+    return worst;
+}
+
+// Worst stack depth from entering node i (memoized; a cycle counts its frames once)
+static uint32_t depth(Graph* g, int i) {
+    Node* n = &g->nodes[i];
+    if (n->depth != DEPTH_UNKNOWN) return n->depth;
+    if (n->visiting) {
+        g->recursive = 1;
+        return 0;
+    }
+    n->visiting = 1;
+    uint32_t worst = 0;
+    for (unsigned k = 0; k < n->calleeCount; k++) {
+        int best = n->callees[k];
+        const uint32_t d = calleeDepth(g, n->callees[k], &best);
+        if (d > worst) {
+            worst = d;
+            n->next = best;
+        }
+    }
+    n->visiting = 0;
+    n->depth = (n->known ? n->frame : g->unknownFrame) + RETURN_ADDRESS + worst;
+    return n->depth;
+}
+
+// Prints a root's worst depth and the call chain that reaches it; -1 if the root is not in the call graph
+static int reportRoot(Graph* g, const char* kind, const char* name, uint32_t extra, uint32_t* out) {
+    const int root = findFunction(g, name);
+    if (root < 0) {
+        fprintf(stderr, "%s: not in the call graph\n", name);
+        return -1;
+    }
+    const uint32_t d = depth(g, root) + extra;
+    printf("%s,%s,%u,", kind, name, d);
+    for (int i = root, first = 1; i >= 0; i = g->nodes[i].next, first = 0) {
+        const Node* n = &g->nodes[i];
+        const char* colon = strrchr(n->title, ':');
+        printf("%s%s(%u%s)", first ? "" : " > ", colon ? colon + 1 : n->title, n->known ? n->frame : g->unknownFrame,
+               n->known ? (n->dynamic ? "+dynamic" : "") : "?");
+    }
+    printf("\n");
+    *out = d;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* entries[MAX_ROOTS];
+    const char* interrupts[MAX_ROOTS];
+    unsigned entryCount = 0, interruptCount = 0;
+    uint64_t ramBudget = 0, stackBudget = 0;
+    unsigned topSymbols = 20;
+    Graph g = { 0 };
+    g.unknownFrame = 128;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:s:e:i:u:n:")) != -1) {
+        switch (opt) {
+            case 'r': ramBudget = strtoull(optarg, NULL, 0); break;
+            case 's': stackBudget = strtoull(optarg, NULL, 0); break;
+            case 'e': if (entryCount < MAX_ROOTS) entries[entryCount++] = optarg; break;
+            case 'i': if (interruptCount < MAX_ROOTS) interrupts[interruptCount++] = optarg; break;
+            case 'u': g.unknownFrame = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'n': topSymbols = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-r ramBudget] [-s stackBudget] [-e entry]... [-i interrupt]... "
+                                "[-u unknownFrame] [-n symbols] rom.out [object.o | callgraph.ci]...\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [options] rom.out [object.o | callgraph.ci]...\n", argv[0]);
+        return 2;
+    }
+    if (!entryCount) entries[entryCount++] = "main";
+    for (int i = optind + 1; i < argc; i++) {
+        const char* ext = strrchr(argv[i], '.');
+        if (ext && !strcmp(ext, ".ci")) {
+            if (addCallGraph(&g, argv[i])) return 1;
+        } else if (addObject(argv[i])) return 1;
+    }
+    Elf e;
+    if (elfLoad(argv[optind], &e)) return 1;
+
+    printf("kind,name,bytes,detail\n");
+    const uint64_t ram = reportRam(&e, topSymbols);
+    elfFree(&e);
+    int failed = 0;
+    printf("ram,total,%llu,budget %llu\n", (unsigned long long)ram, (unsigned long long)ramBudget);
+    if (ramBudget && ram > ramBudget) {
+        fprintf(stderr, "RAM over budget: %llu > %llu bytes\n", (unsigned long long)ram, (unsigned long long)ramBudget);
+        failed = 1;
+    }
+    if (!g.count) {                               // -flto writes no .ci files
+        if (stackBudget) {
+            fprintf(stderr, "no call graph (.ci files): the stack budget cannot be checked\n");
+            failed = 1;
+        }
+        return failed;
+    }
+
+    // Indirect call targets: functions with a frame that nothing calls directly (roots excluded)
+    g.indirect = malloc(sizeof(int) * g.count);
+    for (unsigned i = 0; i < g.count; i++) {
+        const Node* n = &g.nodes[i];
+        int root = 0;
+        for (unsigned k = 0; k < entryCount; k++) root |= findFunction(&g, entries[k]) == (int)i;
+        for (unsigned k = 0; k < interruptCount; k++) root |= findFunction(&g, interrupts[k]) == (int)i;
+        if (n->known && !n->called && !root) g.indirect[g.indirectCount++] = (int)i;
+    }
+    uint32_t stack = 0;
+    for (unsigned k = 0; k < entryCount; k++) {
+        uint32_t d;
+        if (reportRoot(&g, "stack", entries[k], 0, &d)) failed = 1;
+        else if (d > stack) stack = d;
+    }
+    for (unsigned k = 0; k < interruptCount; k++) {
+        uint32_t d;
+        if (reportRoot(&g, "interrupt", interrupts[k], INTERRUPT_ENTRY, &d)) failed = 1;
+        else stack += d;
+    }
+    unsigned unknown = 0;
+    for (unsigned i = 0; i < g.count; i++) {
+        const Node* n = &g.nodes[i];
+        if (n->depth == DEPTH_UNKNOWN) continue;  // Not reachable from the roots
+        if (n->known && n->dynamic) printf("dynamic,%s,%u,frame has a dynamic part\n", n->title, n->frame);
+        unknown += !n->known;
+    }
+    if (unknown) {                                // One row: the SGDK library alone has dozens
+        printf("unknown,%u functions,%u,", unknown, g.unknownFrame);
+        for (unsigned i = 0, first = 1; i < g.count; i++) {
+            const Node* n = &g.nodes[i];
+            if (n->depth == DEPTH_UNKNOWN || n->known) continue;
+            printf("%s%s", first ? "" : " ", n->title);
+            first = 0;
+        }
+        printf("\n");
+    }
+    if (g.recursive) printf("recursion,,0,cycles counted once\n");
+    printf("stack,total,%u,budget %llu\n", stack, (unsigned long long)stackBudget);
+    if (stackBudget && stack > stackBudget) {
+        fprintf(stderr, "stack over budget: %u > %llu bytes\n", stack, (unsigned long long)stackBudget);
+        failed = 1;
+    }
+    return failed;
+}
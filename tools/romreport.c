@@ -0,0 +1,111 @@
+// ROM build report: ROM and RAM use from the linked ELF, plus the benchmark screen's timings
+//
+// Reads the ELF that SGDK links before it is converted to rom.bin (out/rom.out) and sums its allocated
+// sections: code, constants and the initial .data image take ROM; .data and .bss take RAM (the 68000
+// stack, which grows down from the end of RAM, comes on top). With -l it also reads a BENCH=1 ROM's
+// debug console log, whose "bench,<case>,<ref>,<new>,<mismatches>" lines come from src/bench.c.
+// Prints CSV in long form (profile, metric, value) so the reports of several builds concatenate into
+// one table: make -f rom.mk report (see ../rom.mk).
+//
+// Any ELF class and byte order is accepted, so the tool can be checked against host binaries too.
+//
+// Usage: romreport [-p profile] [-r rom.bin] [-l bench.log] [-n] rom.out
+//        (-n: no CSV header line)
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "elf.h"
+
+#define MAX_LINE 256
+
+// "FREE STEP" -> "free_step"
+static void metricName(const char* in, char* out, size_t n) {
+    size_t k = 0;
+    for (; *in && k + 1 < n; in++) out[k++] = isalnum((unsigned char)*in) ? (char)tolower((unsigned char)*in) : '_';
+    out[k] = 0;
+}
+
+// Copies the bench lines of a debug log (anything before "bench," on a line is the emulator's prefix)
+static int reportBench(const char* profile, const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[MAX_LINE];
+    int cases = 0;
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        const char* p = strstr(line, "bench,");
+        char name[64], metric[64];
+        unsigned ref, opt, mismatches;
+        if (!p || sscanf(p, "bench,%63[^,],%u,%u,%u", name, &ref, &opt, &mismatches) != 4) continue;
+        metricName(name, metric, sizeof(metric));
+        printf("%s,bench_%s_ref_cycles,%u\n", profile, metric, ref);
+        printf("%s,bench_%s_cycles,%u\n", profile, metric, opt);
+        if (mismatches) printf("%s,bench_%s_mismatches,%u\n", profile, metric, mismatches);
+        cases++;
+    }
+    fclose(f);
+    if (!cases) fprintf(stderr, "%s: no bench lines\n", path);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* profile = "default";
+    const char* romPath = NULL;
+    const char* logPath = NULL;
+    int header = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:r:l:n")) != -1) {
+        switch (opt) {
+            case 'p': profile = optarg; break;
+            case 'r': romPath = optarg; break;
+            case 'l': logPath = optarg; break;
+            case 'n': header = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-p profile] [-r rom.bin] [-l bench.log] [-n] rom.out\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: %s [-p profile] [-r rom.bin] [-l bench.log] [-n] rom.out\n", argv[0]);
+        return 2;
+    }
+    Elf e;
+    if (elfLoad(argv[optind], &e)) return 1;
+
+    uint64_t romUsed = 0, ramData = 0, ramBss = 0;
+    for (unsigned i = 0; i < e.shnum; i++) {
+        ElfSection s;
+        elfSection(&e, i, &s);
+        if (!(s.flags & ELF_SHF_ALLOC)) continue;
+        if (s.type == ELF_SHT_NOBITS) ramBss += s.size;
+        else {
+            romUsed += s.size;              // .data: its initial image is copied from ROM at boot
+            if (s.flags & ELF_SHF_WRITE) ramData += s.size;
+        }
+    }
+    if (header) printf("profile,metric,value\n");
+    if (romPath) {
+        FILE* f = fopen(romPath, "rb");
+        if (!f) {
+            perror(romPath);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        printf("%s,rom_file_bytes,%ld\n", profile, ftell(f)); // Padded by SGDK's build
+        fclose(f);
+    }
+    printf("%s,rom_used_bytes,%llu\n", profile, (unsigned long long)romUsed);
+    printf("%s,ram_data_bytes,%llu\n", profile, (unsigned long long)ramData);
+    printf("%s,ram_bss_bytes,%llu\n", profile, (unsigned long long)ramBss);
+    printf("%s,ram_bytes,%llu\n", profile, (unsigned long long)(ramData + ramBss));
+    if (logPath && reportBench(profile, logPath)) return 1;
+    elfFree(&e);
+    return 0;
+}
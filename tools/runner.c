@@ -0,0 +1,266 @@
+// Parallel job runner for the host tools (see runner.h)
+
+#include "runner.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RANGE_BEGIN(r) ((r) >> 32)
+#define RANGE_END(r) ((r) & 0xFFFFFFFFu)
+#define RANGE_PACK(b, e) (((uint64_t)(b) << 32) | (uint64_t)(e))
+
+struct RunnerWorker {
+    _Alignas(64) _Atomic uint64_t range;  // Packed [begin, end) of jobs owned by this worker
+    uint64_t rng[4];                      // xoshiro256** state
+    RunnerMetric metrics[RUNNER_MAX_METRICS];
+    uint64_t jobs;                        // Jobs executed by this worker
+    uint64_t steals;                      // Successful steals by this worker
+    unsigned index;                       // Worker index
+    struct Pool* pool;                    // Owning pool
+};
+
+typedef struct Pool {
+    RunnerWorker* workers;
+    unsigned threads;
+    RunnerJobFn fn;
+    void* user;
+    uint64_t numJobs;
+    int progress;
+    _Alignas(64) _Atomic uint64_t done;   // Jobs finished (termination and progress)
+} Pool;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl64(uint64_t v, int k) {
+    return (v << k) | (v >> (64 - k));
+}
+
+static uint64_t xoshiro(uint64_t* s) {
+    const uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// Advances a xoshiro256** state by 2^128 steps (one non-overlapping stream per worker)
+static void xoshiroJump(uint64_t* s) {
+    static const uint64_t JUMP[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                     0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & (1ull << b)) {
+                s0 ^= s[0];
+                s1 ^= s[1];
+                s2 ^= s[2];
+                s3 ^= s[3];
+            }
+            xoshiro(s);
+        }
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
+
+unsigned runnerDefaultThreads(void) {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return n > RUNNER_MAX_THREADS ? RUNNER_MAX_THREADS : (unsigned)n;
+}
+
+uint64_t runnerRandom(RunnerWorker* w) {
+    return xoshiro(w->rng);
+}
+
+uint64_t runnerJobSeed(uint64_t base, uint64_t job) {
+    uint64_t x = base ^ (job * 0xD1B54A32D192ED03ull);
+    return splitmix64(&x);
+}
+
+unsigned runnerThreadIndex(const RunnerWorker* w) {
+    return w->index;
+}
+
+void runnerRecord(RunnerWorker* w, unsigned metric, double value) {
+    if (metric >= RUNNER_MAX_METRICS) return;
+    RunnerMetric* m = &w->metrics[metric];
+    if (m->count == 0 || value < m->min) m->min = value;
+    if (m->count == 0 || value > m->max) m->max = value;
+    m->count++;
+    m->sum += value;
+    m->sumSq += value * value;
+}
+
+double runnerMean(const RunnerMetric* m) {
+    return m->count ? m->sum / m->count : 0.0;
+}
+
+double runnerStdDev(const RunnerMetric* m) {
+    if (m->count < 2) return 0.0;
+    const double mean = m->sum / m->count;
+    const double var = m->sumSq / m->count - mean * mean;
+    return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+// Takes the next job from the front of the worker's own range
+static int popOwn(RunnerWorker* w, uint64_t* job) {
+    uint64_t r = atomic_load_explicit(&w->range, memory_order_acquire);
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        const uint64_t next = RANGE_PACK(RANGE_BEGIN(r) + 1, RANGE_END(r));
+        if (atomic_compare_exchange_weak_explicit(&w->range, &r, next,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            *job = RANGE_BEGIN(r);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Moves the back half of a random victim's range into the (empty) range of the thief
+static int steal(RunnerWorker* w) {
+    Pool* pool = w->pool;
+    const unsigned start = (unsigned)(runnerRandom(w) % pool->threads);
+    for (unsigned k = 0; k < pool->threads; k++) {
+        RunnerWorker* victim = &pool->workers[(start + k) % pool->threads];
+        if (victim == w) continue;
+        uint64_t r = atomic_load_explicit(&victim->range, memory_order_acquire);
+        while (RANGE_BEGIN(r) < RANGE_END(r)) {
+            const uint64_t b = RANGE_BEGIN(r);
+            const uint64_t e = RANGE_END(r);
+            const uint64_t mid = b + (e - b) / 2; // Victim keeps [b, mid), thief takes [mid, e)
+            if (atomic_compare_exchange_weak_explicit(&victim->range, &r, RANGE_PACK(b, mid),
+                                                      memory_order_acq_rel, memory_order_acquire)) {
+                atomic_store_explicit(&w->range, RANGE_PACK(mid, e), memory_order_release);
+                w->steals++;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void reportProgress(Pool* pool, double start, double* lastReport) {
+    const double t = now();
+    if (t - *lastReport < 1.0) return;
+    *lastReport = t;
+    const uint64_t done = atomic_load_explicit(&pool->done, memory_order_relaxed);
+    fprintf(stderr, "\r%llu/%llu jobs (%.1f%%), %.1f jobs/s   ",
+            (unsigned long long)done, (unsigned long long)pool->numJobs,
+            pool->numJobs ? 100.0 * done / pool->numJobs : 100.0, done / (t - start));
+}
+
+static void* workerMain(void* arg) {
+    RunnerWorker* w = arg;
+    Pool* pool = w->pool;
+    const double start = now();
+    double lastReport = start;
+    const int reports = pool->progress && w->index == 0;
+    for (;;) {
+        uint64_t job;
+        if (popOwn(w, &job)) {
+            pool->fn(w, job, pool->user);
+            w->jobs++;
+            atomic_fetch_add_explicit(&pool->done, 1, memory_order_release);
+            if (reports) reportProgress(pool, start, &lastReport);
+            continue;
+        }
+        if (steal(w)) continue;
+        if (atomic_load_explicit(&pool->done, memory_order_acquire) >= pool->numJobs) break;
+        if (reports) reportProgress(pool, start, &lastReport);
+        sched_yield(); // Remaining jobs are all running elsewhere
+    }
+    if (reports) fprintf(stderr, "\n");
+    return NULL;
+}
+
+int runnerRun(const RunnerConfig* cfg, uint64_t numJobs, RunnerJobFn fn, void* user, RunnerResult* out) {
+    if (numJobs > 0xFFFFFFFFull) return -1; // Ranges pack 32-bit job indices
+    unsigned threads = cfg->threads ? cfg->threads : runnerDefaultThreads();
+    if (threads > RUNNER_MAX_THREADS) threads = RUNNER_MAX_THREADS;
+    if (threads == 0) threads = 1;
+
+    Pool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.workers = aligned_alloc(64, sizeof(RunnerWorker) * threads);
+    if (!pool.workers) return -1;
+    memset(pool.workers, 0, sizeof(RunnerWorker) * threads);
+    pool.threads = threads;
+    pool.fn = fn;
+    pool.user = user;
+    pool.numJobs = numJobs;
+    pool.progress = cfg->progress;
+    atomic_init(&pool.done, 0);
+
+    // Even initial split; stealing rebalances uneven jobs
+    uint64_t rngSeed = cfg->seed;
+    uint64_t rng[4];
+    for (int i = 0; i < 4; i++) rng[i] = splitmix64(&rngSeed);
+    for (unsigned i = 0; i < threads; i++) {
+        RunnerWorker* w = &pool.workers[i];
+        const uint64_t b = numJobs * i / threads;
+        const uint64_t e = numJobs * (i + 1) / threads;
+        atomic_init(&w->range, RANGE_PACK(b, e));
+        memcpy(w->rng, rng, sizeof(rng));
+        xoshiroJump(rng);
+        w->index = i;
+        w->pool = &pool;
+    }
+
+    const double start = now();
+    pthread_t tids[RUNNER_MAX_THREADS];
+    unsigned started = 1;
+    for (unsigned i = 1; i < threads; i++, started++) {
+        // On failure keep going with fewer threads; stealing drains the ranges of missing workers
+        if (pthread_create(&tids[i], NULL, workerMain, &pool.workers[i]) != 0) break;
+    }
+    workerMain(&pool.workers[0]);
+    for (unsigned i = 1; i < started; i++) pthread_join(tids[i], NULL);
+
+    if (out) {
+        memset(out, 0, sizeof(*out));
+        out->threads = started;
+        out->seconds = now() - start;
+        for (unsigned i = 0; i < threads; i++) {
+            const RunnerWorker* w = &pool.workers[i];
+            out->jobs += w->jobs;
+            out->steals += w->steals;
+            for (unsigned m = 0; m < RUNNER_MAX_METRICS; m++) {
+                const RunnerMetric* src = &w->metrics[m];
+                RunnerMetric* dst = &out->metrics[m];
+                if (src->count == 0) continue;
+                if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+                if (dst->count == 0 || src->max > dst->max) dst->max = src->max;
+                dst->count += src->count;
+                dst->sum += src->sum;
+                dst->sumSq += src->sumSq;
+            }
+        }
+    }
+    free(pool.workers);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Parallel job runner for the host tools
+//
+// Overview:
+// Runs numJobs independent jobs (games, seeds, mazes) on a pool of worker threads. Job lengths vary
+// wildly (a game can end at step 5 or step 50,000), so jobs are not pre-assigned: each worker owns a
+// range of job indices and takes jobs from its front, and an idle worker steals the back half of a
+// random victim's range. Ranges are packed into one 64-bit word and updated with compare-and-swap, so
+// there are no locks on the hot path.
+//
+// Randomness:
+// - runnerRandom(): per-thread xoshiro256** stream (streams are jump()-separated, never overlap).
+//   Use it for work whose result may depend on scheduling (random search, sampling).
+// - runnerJobSeed(): seed derived from (base seed, job index) only. Use it whenever results must be
+//   reproducible regardless of thread count (self-play, seed scans).
+//
+// Results:
+// Jobs either write into their own slot of a caller-owned array (indexed by job, no sharing), or call
+// runnerRecord() to accumulate a scalar metric into per-worker, cache-line aligned accumulators that
+// are merged once all workers have finished.
+
+#ifndef _RUNNER_H_
+#define _RUNNER_H_
+
+#include <stdint.h>
+
+#define RUNNER_MAX_THREADS 256 // Upper bound on worker threads
+#define RUNNER_MAX_METRICS 8   // Scalar metrics per run (see runnerRecord)
+
+typedef struct RunnerWorker RunnerWorker;
+
+// Job callback: job is in [0, numJobs); user is passed through from runnerRun()
+typedef void (*RunnerJobFn)(RunnerWorker* w, uint64_t job, void* user);
+
+typedef struct {
+    unsigned threads;          // Worker threads (0 = all online CPUs)
+    uint64_t seed;             // Base seed for thread streams and job seeds
+    int progress;              // Non-zero: print progress to stderr about once per second
+} RunnerConfig;
+
+typedef struct {
+    uint64_t count;            // Number of recorded values
+    double sum;                // Sum of values
+    double sumSq;              // Sum of squared values
+    double min;                // Smallest value
+    double max;                // Largest value
+} RunnerMetric;
+
+typedef struct {
+    RunnerMetric metrics[RUNNER_MAX_METRICS]; // Merged metrics
+    uint64_t jobs;             // Jobs executed
+    uint64_t steals;           // Successful steals (load balancing activity)
+    unsigned threads;          // Threads actually used
+    double seconds;            // Wall-clock time of the run
+} RunnerResult;
+
+unsigned runnerDefaultThreads(void);      // Number of online CPUs (at least 1)
+int runnerRun(const RunnerConfig* cfg, uint64_t numJobs, RunnerJobFn fn, void* user, RunnerResult* out); // 0 on success
+uint64_t runnerRandom(RunnerWorker* w);   // Next value of the worker's own stream
+uint64_t runnerJobSeed(uint64_t base, uint64_t job); // Scheduling-independent per-job seed
+void runnerRecord(RunnerWorker* w, unsigned metric, double value); // Accumulates a value (no locks)
+unsigned runnerThreadIndex(const RunnerWorker* w); // 0 .. threads-1
+double runnerMean(const RunnerMetric* m); // Mean of a merged metric (0 if empty)
+double runnerStdDev(const RunnerMetric* m); // Standard deviation of a merged metric
+
+#endif // _RUNNER_H_
@@ -0,0 +1,240 @@
+// Seed search: finds game seeds whose generated level matches a query
+//
+// Scans seeds [-f first, first + -n count) for one level (-l), building each level with the maze.h
+// level probe (portals, walls and the level's food draws) and measuring it: cells reachable from the
+// head, unreachable pockets, dead-end cells and the closest any food comes to a portal tile. Seeds
+// whose metrics pass every query option are printed as CSV, in seed order. Seeds are simInitGame()
+// seeds, so a match can be replayed directly (selfplay, dsexport -w, or a ROM build with a fixed seed).
+//
+// Metrics are cached by (seed, level): within a run, and across runs with -C. The cache file starts
+// with a fingerprint of the level generator, so it is dropped automatically when generation changes.
+// A repeated query over cached seeds does not generate a single level.
+//
+// Queries (all optional, combined with AND):
+//   -D n  at most n dead-end cells          ("level 10 with no dead ends": -l 10 -D 0)
+//   -F n  no food within n cells of a portal ("food never within 3 cells of a portal": -F 3)
+//   -A n  at least n cells reachable from the head
+//   -U n  at most n free cells unreachable from the head
+//
+// Usage: seedsearch [-l level] [-f first] [-n count] [-D n] [-F n] [-A n] [-U n] [-k maxMatches]
+//                   [-C cache.bin] [-t threads] [-q]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "maze.h"
+#include "runner.h"
+
+#define CACHE_MAGIC 0x5345454B // "SEEK"
+#define CACHE_VERSION 1        // Bump when the metrics below change meaning
+#define FINGERPRINT_SEED 0x5EED5EED
+#define FINGERPRINT_LEVEL 12
+#define MAX_FOOD 256           // Food draws measured per level (targets stay far below on real levels)
+
+typedef struct {
+    u32 seed;
+    u16 level;
+    u16 used;                  // Cache slot in use (always 1 in files)
+    u16 area;                  // Cells reachable from the head (portal tiles included)
+    u16 freeCells;             // Passable cells
+    u16 deadEnds;              // Passable cells with at most one exit
+    u16 foodPortal;            // Smallest food to portal Manhattan distance over the level's food draws
+    u32 hash;                  // simHash() of the generated level
+} LevelInfo;
+
+typedef struct {
+    LevelInfo* slots;
+    size_t capacity;           // Power of two
+    size_t count;
+} Cache;
+
+typedef struct {
+    LevelInfo* infos;          // One slot per job
+} Scan;
+
+static size_t cacheSlot(const Cache* c, u32 seed, u16 level) {
+    uint64_t h = ((uint64_t)level << 32 | seed) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    size_t i = h & (c->capacity - 1);
+    while (c->slots[i].used && (c->slots[i].seed != seed || c->slots[i].level != level)) {
+        i = (i + 1) & (c->capacity - 1);
+    }
+    return i;
+}
+
+static void cacheInsert(Cache* c, const LevelInfo* info);
+
+static void cacheGrow(Cache* c) {
+    Cache old = *c;
+    c->capacity = old.capacity ? old.capacity * 2 : 4096;
+    c->slots = calloc(c->capacity, sizeof(LevelInfo));
+    c->count = 0;
+    if (!c->slots) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.slots[i].used) cacheInsert(c, &old.slots[i]);
+    }
+    free(old.slots);
+}
+
+static void cacheInsert(Cache* c, const LevelInfo* info) {
+    if ((c->count + 1) * 2 > c->capacity) cacheGrow(c);
+    const size_t i = cacheSlot(c, info->seed, info->level);
+    if (!c->slots[i].used) c->count++;
+    c->slots[i] = *info;
+    c->slots[i].used = 1;
+}
+
+static const LevelInfo* cacheFind(const Cache* c, u32 seed, u16 level) {
+    if (!c->capacity) return NULL;
+    const size_t i = cacheSlot(c, seed, level);
+    return c->slots[i].used ? &c->slots[i] : NULL;
+}
+
+// Generator fingerprint: hash of one fixed probe level mixed with the metrics version
+static u32 fingerprint(void) {
+    SimState s;
+    mazeGenerate(&s, FINGERPRINT_SEED, FINGERPRINT_LEVEL);
+    return simHash(&s) ^ CACHE_VERSION;
+}
+
+// Loads cached records; returns FALSE if the file is missing or stale (it is then rewritten)
+static u16 cacheLoad(Cache* c, const char* path, u32 print) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return FALSE;
+    u32 header[2];
+    u16 valid = fread(header, sizeof(header), 1, f) == 1 && header[0] == CACHE_MAGIC && header[1] == print;
+    if (valid) {
+        LevelInfo info;
+        while (fread(&info, sizeof(info), 1, f) == 1) cacheInsert(c, &info);
+    } else {
+        fprintf(stderr, "ignoring cache %s (different format or level generator)\n", path);
+    }
+    fclose(f);
+    return valid;
+}
+
+// Appends new records to a valid cache file, or starts a new one
+static void cacheAppend(const char* path, u16 valid, u32 print, const LevelInfo* infos, size_t count) {
+    FILE* f = fopen(path, valid ? "ab" : "wb");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    if (!valid) {
+        const u32 header[2] = { CACHE_MAGIC, print };
+        fwrite(header, sizeof(header), 1, f);
+    }
+    fwrite(infos, sizeof(LevelInfo), count, f);
+    if (fclose(f) != 0) perror(path);
+}
+
+static void measureLevel(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    LevelInfo* info = &((Scan*)user)->infos[job];
+    SimState s;
+    Maze m;
+    u16 dist[MAZE_CELLS];
+    Point food[MAX_FOOD];
+    mazeGenerate(&s, info->seed, info->level);
+    info->hash = simHash(&s);
+    mazeBuild(&s, &m);
+    info->area = mazeDistances(&m, MAZE_CELL(s.snakeBody[0].x, s.snakeBody[0].y), dist);
+    info->freeCells = mazeFreeCells(&m);
+    info->deadEnds = mazeDeadEnds(&m);
+    info->foodPortal = 0xFFFF;
+    const u16 foods = mazeFoodSequence(&s, food, MAX_FOOD);
+    for (u16 i = 0; i < foods; i++) {
+        const u16 d = mazePortalDistance(&m, food[i]);
+        if (d < info->foodPortal) info->foodPortal = d;
+    }
+    info->used = 1;
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    u16 level = 1;
+    u32 first = 1;
+    u32 count = 10000;
+    long maxDeadEnds = -1;
+    long foodClearance = -1;
+    long minArea = -1;
+    long maxUnreachable = -1;
+    unsigned long maxMatches = 0;
+    const char* cachePath = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:f:n:D:F:A:U:k:C:t:q")) != -1) {
+        switch (opt) {
+            case 'l': level = (u16)strtoul(optarg, NULL, 0); break;
+            case 'f': first = (u32)strtoul(optarg, NULL, 0); break;
+            case 'n': count = (u32)strtoul(optarg, NULL, 0); break;
+            case 'D': maxDeadEnds = strtol(optarg, NULL, 0); break;
+            case 'F': foodClearance = strtol(optarg, NULL, 0); break;
+            case 'A': minArea = strtol(optarg, NULL, 0); break;
+            case 'U': maxUnreachable = strtol(optarg, NULL, 0); break;
+            case 'k': maxMatches = strtoul(optarg, NULL, 0); break;
+            case 'C': cachePath = optarg; break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-l level] [-f first] [-n count] [-D n] [-F n] [-A n] [-U n] [-k maxMatches] "
+                                "[-C cache.bin] [-t threads] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (level < 1 || level > 255) {
+        fprintf(stderr, "level must be in 1..255\n");
+        return 2;
+    }
+
+    simInitKeys();
+    const u32 print = fingerprint();
+    Cache cache = { 0 };
+    const u16 cacheValid = cachePath ? cacheLoad(&cache, cachePath, print) : FALSE;
+
+    // Levels missing from the cache become runner jobs
+    Scan scan = { malloc(sizeof(LevelInfo) * (count ? count : 1)) };
+    if (!scan.infos) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t missing = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (cacheFind(&cache, first + i, level)) continue;
+        memset(&scan.infos[missing], 0, sizeof(LevelInfo));
+        scan.infos[missing].seed = first + i;
+        scan.infos[missing].level = level;
+        missing++;
+    }
+    RunnerResult res = { 0 };
+    if (missing && runnerRun(&cfg, missing, measureLevel, &scan, &res) != 0) {
+        fprintf(stderr, "runner failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < missing; i++) cacheInsert(&cache, &scan.infos[i]);
+    if (cachePath && missing) cacheAppend(cachePath, cacheValid, print, scan.infos, missing);
+    free(scan.infos);
+
+    unsigned long matches = 0;
+    printf("seed,level,area,free,dead_ends,food_portal,hash\n");
+    for (u32 i = 0; i < count && (!maxMatches || matches < maxMatches); i++) {
+        const LevelInfo* info = cacheFind(&cache, first + i, level);
+        if (maxDeadEnds >= 0 && info->deadEnds > maxDeadEnds) continue;
+        if (foodClearance >= 0 && info->foodPortal <= foodClearance) continue;
+        if (minArea >= 0 && info->area < minArea) continue;
+        if (maxUnreachable >= 0 && info->freeCells - info->area > maxUnreachable) continue;
+        printf("%u,%u,%u,%u,%u,%u,%08X\n", info->seed, info->level, info->area, info->freeCells, info->deadEnds,
+               info->foodPortal, info->hash);
+        matches++;
+    }
+    fprintf(stderr, "%lu matches in %u seeds (level %u): %u cached, %zu generated in %.2fs\n", matches, count, level,
+            count - (u32)missing, missing, res.seconds);
+    free(cache.slots);
+    return 0;
+}
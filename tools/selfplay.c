@@ -0,0 +1,164 @@
+// Batch self-play on the host: plays many seeded games in parallel and reports score statistics
+//
+// Usage: selfplay [-n games] [-t threads] [-s seed] [-m maxSteps] [-w f,a,t,p] [-f food] [-g] [-N] [-c] [-q]
+//   -n  number of games (default 1000)
+//   -t  worker threads (default: all CPUs)
+//   -s  base seed; game i uses runnerJobSeed(seed, i), so results do not depend on -t
+//   -m  step cap per game (default 50000)
+//   -w  AI weights food,area,tail,portal (default: ai_weights.h)
+//   -f  food placement policy: uniform (default), reachable or distant (see SIM_FOOD_* in sim.h)
+//   -g  play the greedy baseline policy instead of the AI
+//   -N  play the quantized neural network policy (nn_weights.h) instead of the AI
+//   -c  print one CSV line per game (index,seed,score,level,length,steps,hash,cause) in game order
+//   -q  no progress output
+// With the AI policy it also prints the AI's scratch buffer high-water marks over all games (see aiPeaks()).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "play.h"
+#include "runner.h"
+
+#define METRIC_SCORE 0
+#define METRIC_LEVEL 1
+#define METRIC_STEPS 2
+#define METRIC_AI_OPEN 3       // Per game AI scratch peaks (aiPeaks())
+#define METRIC_AI_QUEUE 4
+#define METRIC_AI_EXPANDED 5
+
+typedef struct {
+    u32 seed;
+    u16 score;
+    u16 level;
+    u16 length;
+    u32 steps;
+    u32 hash;
+    u16 cause;                 // SIM_CAUSE_* that ended the game
+} GameResult;
+
+typedef struct {
+    uint64_t baseSeed;
+    u32 maxSteps;
+    u16 foodPolicy;            // SIM_FOOD_*
+    u16 policy;                // PLAY_POLICY_*
+    AiWeights weights;         // AI weights
+    GameResult* results;       // One slot per game, written only by the job that owns it
+} SelfPlay;
+
+static void runGame(RunnerWorker* w, uint64_t job, void* user) {
+    SelfPlay* sp = user;
+    SimState s;
+    const u32 seed = (u32)runnerJobSeed(sp->baseSeed, job);
+    AiPeaks peaks;
+    aiPeaks(&peaks);                                      // Drops the previous game's marks of this worker
+    const u16 events = playGame(&s, seed, sp->foodPolicy, sp->policy, &sp->weights, sp->maxSteps);
+    GameResult* r = &sp->results[job];
+    r->seed = seed;
+    r->score = s.score;
+    r->level = s.currentLevel;
+    r->length = s.snakeLength;
+    r->steps = s.stepCount;
+    r->hash = simHash(&s);
+    r->cause = simEndCause(&s, events);
+    runnerRecord(w, METRIC_SCORE, s.score);
+    runnerRecord(w, METRIC_LEVEL, s.currentLevel);
+    runnerRecord(w, METRIC_STEPS, s.stepCount);
+    aiPeaks(&peaks);
+    runnerRecord(w, METRIC_AI_OPEN, peaks.open);
+    runnerRecord(w, METRIC_AI_QUEUE, peaks.queue);
+    runnerRecord(w, METRIC_AI_EXPANDED, peaks.expanded);
+}
+
+int main(int argc, char** argv) {
+    RunnerConfig cfg = { 0, 1, 1 };
+    uint64_t games = 1000;
+    SelfPlay sp = { 1, 50000, SIM_FOOD_UNIFORM, PLAY_POLICY_AI, aiDefaultWeights, NULL };
+    int csv = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:s:m:w:f:gNcq")) != -1) {
+        switch (opt) {
+            case 'n': games = strtoull(optarg, NULL, 0); break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': sp.baseSeed = strtoull(optarg, NULL, 0); break;
+            case 'm': sp.maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 'w': {
+                int f, a, t, p;
+                if (sscanf(optarg, "%d,%d,%d,%d", &f, &a, &t, &p) != 4) {
+                    fprintf(stderr, "-w expects food,area,tail,portal\n");
+                    return 2;
+                }
+                sp.weights.food = f;
+                sp.weights.area = a;
+                sp.weights.tail = t;
+                sp.weights.portal = p;
+                break;
+            }
+            case 'f':
+                for (sp.foodPolicy = 0; sp.foodPolicy < SIM_FOOD_COUNT; sp.foodPolicy++) {
+                    if (!strcmp(optarg, simFoodPolicyNames[sp.foodPolicy])) break;
+                }
+                if (sp.foodPolicy == SIM_FOOD_COUNT) {
+                    fprintf(stderr, "unknown food policy %s (uniform, reachable, distant)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'g': sp.policy = PLAY_POLICY_GREEDY; break;
+            case 'N': sp.policy = PLAY_POLICY_NN; break;
+            case 'c': csv = 1; break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-n games] [-t threads] [-s seed] [-m maxSteps] [-w f,a,t,p] [-f food] [-g] [-N] [-c] [-q]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    cfg.seed = sp.baseSeed;
+
+    sp.results = calloc(games ? games : 1, sizeof(GameResult));
+    if (!sp.results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    simInitKeys();
+
+    RunnerResult res;
+    if (runnerRun(&cfg, games, runGame, &sp, &res) != 0) {
+        fprintf(stderr, "runner failed\n");
+        return 1;
+    }
+
+    if (csv) {
+        printf("game,seed,score,level,length,steps,hash,cause\n");
+        for (uint64_t i = 0; i < games; i++) {
+            const GameResult* r = &sp.results[i];
+            printf("%llu,%u,%u,%u,%u,%u,%08X,%s\n", (unsigned long long)i, r->seed, r->score, r->level,
+                   r->length, r->steps, r->hash, simCauseNames[r->cause]);
+        }
+    }
+    const RunnerMetric* score = &res.metrics[METRIC_SCORE];
+    const RunnerMetric* level = &res.metrics[METRIC_LEVEL];
+    const RunnerMetric* steps = &res.metrics[METRIC_STEPS];
+    fprintf(stderr, "games %llu  threads %u  steals %llu  %.2fs  (%.0f games/s, %.0f steps/s)\n",
+            (unsigned long long)res.jobs, res.threads, (unsigned long long)res.steals, res.seconds,
+            res.jobs / res.seconds, steps->sum / res.seconds);
+    fprintf(stderr, "score mean %.1f sd %.1f min %.0f max %.0f\n",
+            runnerMean(score), runnerStdDev(score), score->min, score->max);
+    fprintf(stderr, "level mean %.2f max %.0f  steps mean %.0f max %.0f\n",
+            runnerMean(level), level->max, runnerMean(steps), steps->max);
+    if (sp.policy == PLAY_POLICY_AI) {
+        fprintf(stderr, "ai scratch peak: open %.0f  queue %.0f  expanded %.0f  (buffers hold %u cells)\n",
+                res.metrics[METRIC_AI_OPEN].max, res.metrics[METRIC_AI_QUEUE].max,
+                res.metrics[METRIC_AI_EXPANDED].max, GRID_WIDTH * GRID_HEIGHT);
+    }
+    u32 causes[SIM_CAUSE_COUNT] = { 0 };
+    for (uint64_t i = 0; i < games; i++) causes[sp.results[i].cause]++;
+    fprintf(stderr, "ends:");
+    for (u16 c = 0; c < SIM_CAUSE_COUNT; c++) {
+        if (causes[c]) fprintf(stderr, "  %s %u", c == SIM_CAUSE_NONE ? "step_cap" : simCauseNames[c], causes[c]);
+    }
+    fprintf(stderr, "\n");
+    free(sp.results);
+    return 0;
+}
@@ -0,0 +1,347 @@
+// Hot-path microbenchmarks: optimized sim core code vs the reference versions kept in ../src/bench.c
+//
+// Samples game states from AI self-play (one every few steps, across levels), then times each case's
+// reference and optimized implementation on the same states and inputs, and checks that both give the
+// same results. The free cases replay the free set changes of the same games level by level instead;
+// eat plays reachable policy games and times each step once, as a step cannot be repeated in place.
+// Single-threaded on purpose: it measures per-call cost, not throughput. The ROM runs the same cases on
+// the 68000 (BENCH=1, see ../src/bench.h).
+//
+// Cases: collision, free (free_step and free_pick), eat
+//
+// Usage: simbench [-c case] [-n states] [-r repeat] [-m maxSteps] [-s seed]
+// Prints one CSV row per case and variant (ns per operation, speedup over the reference).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "play.h"
+#include "runner.h"
+
+#define SAMPLE_EVERY 7         // Steps between sampled states
+#define EAT_REPEAT 3           // Timed runs of each eat case step (fastest kept)
+
+typedef u16 (*BlockedFn)(const SimState* s, s16 x, s16 y);
+
+typedef struct {
+    SimState* states;
+    u32 count;
+    u32 repeat;
+} Bench;
+
+typedef struct {
+    BenchFreeList list;                  // Free set at level start (after the first food)
+    FreeMap map;
+    u32 firstOp;                         // This level's steps are ops[firstOp .. firstOp + opCount)
+    u32 opCount;
+} FreeLevel;
+
+typedef struct {
+    FreeLevel* levels;
+    u32 levelCount;
+    BenchFreeOp* ops;
+    u32 opCount;
+    u32 steps;
+} FreeTrace;
+
+static volatile u32 sink;              // Keeps the timed results alive
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Plays AI games from consecutive job seeds until count states are sampled
+static SimState* sampleStates(u32 count, u32 maxSteps, uint64_t seed) {
+    SimState* states = malloc(sizeof(SimState) * count);
+    SimState s;
+    u32 n = 0;
+    if (!states) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (uint64_t game = 0; n < count; game++) {
+        simInitGame(&s, (u32)runnerJobSeed(seed, game));
+        while (n < count && s.stepCount < maxSteps) {
+            if (s.stepCount % SAMPLE_EVERY == 0) states[n++] = s;
+            const u16 events = simStep(&s, aiChooseMove(&s, &aiDefaultWeights));
+            if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+            if (events & SIM_EVENT_LEVEL_UP) simInitLevel(&s);
+        }
+    }
+    return states;
+}
+
+static void report(const char* name, const char* variant, double seconds, double ops, double refSeconds) {
+    printf("%s,%s,%.2f,%.2f\n", name, variant, seconds * 1e9 / ops, refSeconds / seconds);
+}
+
+// Times fn on every state's head moves; each state is repeated back to back, hot in cache as in a game
+static double timeBlocked(const Bench* b, BlockedFn fn) {
+    double total = 0.0;
+    u32 acc = 0;
+    for (u32 i = 0; i < b->count; i++) {
+        const SimState* s = &b->states[i];
+        Point p[4];
+        for (u16 dir = 0; dir < 4; dir++) simNextHead(s, dir, &p[dir]);
+        const double start = now();
+        for (u32 r = 0; r < b->repeat; r++) {
+            for (u16 dir = 0; dir < 4; dir++) acc += fn(s, p[dir].x, p[dir].y);
+        }
+        total += now() - start;
+    }
+    sink += acc;
+    return total;
+}
+
+// Collision queries for the four moves out of the head (what simStep() and the policies ask)
+static u32 benchCollision(const Bench* b) {
+    u32 mismatches = 0;
+    for (u32 i = 0; i < b->count; i++) {
+        const SimState* s = &b->states[i];
+        for (u16 dir = 0; dir < 4; dir++) {
+            Point p;
+            simNextHead(s, dir, &p);
+            mismatches += simIsBlocked(s, p.x, p.y) != benchRefIsBlocked(s, p.x, p.y);
+        }
+    }
+    const double ops = 4.0 * b->count * b->repeat;
+    const double ref = timeBlocked(b, benchRefIsBlocked);
+    const double opt = timeBlocked(b, simIsBlocked);
+    report("collision", "reference", ref, ops, ref);
+    report("collision", "row_index_bbox", opt, ops, ref);
+    return mismatches;
+}
+
+// Plays the same AI games as sampleStates() and records every level's start set and per-step changes
+static void traceFree(FreeTrace* t, u32 steps, u32 maxSteps, uint64_t seed) {
+    u32 levelCap = 16;
+    t->levels = malloc(sizeof(FreeLevel) * levelCap);
+    t->ops = malloc(sizeof(BenchFreeOp) * ((size_t)steps * 4));
+    t->levelCount = t->opCount = t->steps = 0;
+    SimState s;
+    for (uint64_t game = 0; t->steps < steps; game++) {
+        simInitGame(&s, (u32)runnerJobSeed(seed, game));
+        u16 levelStart = TRUE;
+        while (t->steps < steps && s.stepCount < maxSteps) {
+            if (levelStart) {
+                if (t->levelCount == levelCap) t->levels = realloc(t->levels, sizeof(FreeLevel) * (levelCap *= 2));
+                FreeLevel* l = &t->levels[t->levelCount++];
+                benchFreeCells(&s, &l->list, &l->map);
+                l->firstOp = t->opCount;
+                l->opCount = 0;
+                levelStart = FALSE;
+            }
+            const SimState before = s;
+            const u16 events = simStep(&s, aiChooseMove(&s, &aiDefaultWeights));
+            if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+            if (events & SIM_EVENT_LEVEL_UP) {
+                simInitLevel(&s);
+                levelStart = TRUE;
+                continue;
+            }
+            const u16 n = benchFreeOps(&before, &s, events, &t->ops[t->opCount]);
+            t->opCount += n;
+            t->levels[t->levelCount - 1].opCount += n;
+            t->steps++;
+        }
+    }
+}
+
+// Replays every level's ops on a copy of its start set (list or bitmap); returns the timed seconds
+static double timeFreeStep(const FreeTrace* t, u32 repeat, u16 bitmap, u32* mismatches) {
+    static BenchFreeList list;
+    static FreeMap map;
+    double total = 0.0;
+    for (u32 r = 0; r < repeat; r++) {
+        for (u32 i = 0; i < t->levelCount; i++) {
+            const FreeLevel* l = &t->levels[i];
+            const BenchFreeOp* op = &t->ops[l->firstOp];
+            const BenchFreeOp* end = op + l->opCount;
+            list = l->list;
+            map = l->map;
+            const double start = now();
+            if (bitmap) {
+                for (; op < end; op++) {
+                    if (op->remove) simFreeMapRemove(&map, op->p.x, op->p.y);
+                    else simFreeMapAdd(&map, op->p.x, op->p.y);
+                }
+            } else {
+                for (; op < end; op++) {
+                    if (op->remove) benchRefFreeRemove(&list, op->p);
+                    else benchRefFreeAdd(&list, op->p);
+                }
+            }
+            total += now() - start;
+            if (r == 0 && bitmap) {       // Both sets end up equal: replay the list too and compare
+                list = l->list;
+                for (op = &t->ops[l->firstOp]; op < end; op++) {
+                    if (op->remove) benchRefFreeRemove(&list, op->p);
+                    else benchRefFreeAdd(&list, op->p);
+                }
+                *mismatches += !benchFreeSame(&list, &map);
+            }
+        }
+    }
+    return total;
+}
+
+// Food picks at every 7th rank of each level's start set: list index vs bitmap rank select
+static double timeFreePick(const FreeTrace* t, u32 repeat, u16 bitmap, u32* ops, u32* mismatches) {
+    double total = 0.0;
+    u32 acc = 0;
+    *ops = 0;
+    for (u32 i = 0; i < t->levelCount; i++) {
+        const FreeLevel* l = &t->levels[i];
+        const double start = now();
+        for (u32 r = 0; r < repeat; r++) {
+            for (u16 k = 0; k < l->list.count; k += 7) {
+                Point p;
+                if (bitmap) simFreeMapSelect(&l->map, k, &p);
+                else p = l->list.tiles[k];
+                acc += p.x + p.y;
+            }
+        }
+        total += now() - start;
+        *ops += repeat * ((l->list.count + 6) / 7);
+        if (bitmap) {                     // Ranks follow row-major order, as the start list does
+            for (u16 k = 0; k < l->list.count; k++) {
+                Point p;
+                simFreeMapSelect(&l->map, k, &p);
+                *mismatches += p.x != l->list.tiles[k].x || p.y != l->list.tiles[k].y;
+            }
+        }
+    }
+    sink += acc;
+    return total;
+}
+
+// Free set upkeep per step and per food pick: SIM_FREE_BITMAP's bitmap vs the freeTiles[] list
+static u32 benchFree(u32 steps, u32 repeat, u32 maxSteps, uint64_t seed) {
+    FreeTrace t;
+    u32 mismatches = 0;
+    u32 pickOps = 0;
+    traceFree(&t, steps, maxSteps, seed);
+    const double ref = timeFreeStep(&t, repeat, FALSE, &mismatches);
+    const double opt = timeFreeStep(&t, repeat, TRUE, &mismatches);
+    report("free_step", "list", ref, (double)t.steps * repeat, ref);
+    report("free_step", "bitmap", opt, (double)t.steps * repeat, ref);
+    const double refPick = timeFreePick(&t, repeat, FALSE, &pickOps, &mismatches);
+    const double optPick = timeFreePick(&t, repeat, TRUE, &pickOps, &mismatches);
+    report("free_pick", "list", refPick, pickOps, refPick);
+    report("free_pick", "bitmap", optPick, pickOps, refPick);
+    fprintf(stderr, "free set: list %zu bytes, bitmap %zu bytes; %u steps over %u levels\n",
+            sizeof(((SimState*)0)->freeTileCount) + sizeof(Point) * (MAX_FREE_TILES + NUM_PORTALS * 2),
+            sizeof(FreeMap) + sizeof(u16), t.steps, t.levelCount);
+    free(t.levels);
+    free(t.ops);
+    return mismatches;
+}
+
+#if SIM_FOOD_REGIONS
+// Steps of reachable policy AI games: simStep() with its region upkeep vs the same step under the uniform
+// policy plus the reference search per food (the placement the regions replaced). Each step is timed
+// EAT_REPEAT times on copies and the fastest run kept, so the worst step on stderr is the step's own cost
+// (a step has to fit in a frame on the 68000). Reported per food, as the search is the cost the upkeep
+// spreads over the steps in between
+static u32 benchEat(u32 steps, u32 maxSteps, uint64_t seed) {
+    static u8 reached[GRID_WIDTH * GRID_HEIGHT];
+    static SimState s, ref, run;
+    double refTotal = 0.0, optTotal = 0.0, refWorst = 0.0, optWorst = 0.0;
+    u32 foods = 0, held = 0, done = 0, mismatches = 0;
+    Point food;
+    for (uint64_t game = 0; done < steps; game++) {
+        simInitGameEx(&s, (u32)runnerJobSeed(seed, game), SIM_FOOD_REACHABLE);
+        while (done < steps && s.stepCount < maxSteps) {
+            const u16 dir = aiChooseMove(&s, &aiDefaultWeights);
+            double refStep = 1e9, optStep = 1e9;
+            ref = s;
+            ref.foodPolicy = SIM_FOOD_UNIFORM;
+            for (u32 r = 0; r < EAT_REPEAT; r++) {
+                run = ref;
+                double start = now();
+                const u16 events = simStep(&run, dir);
+                if ((events & SIM_EVENT_ATE) && !(events & (SIM_EVENT_LEVEL_UP | SIM_EVENT_WIN))) {
+                    sink += benchRefPlaceFood(&run, (u16)done, reached, &food);
+                }
+                refStep = fmin(refStep, now() - start);
+                run = s;
+                start = now();
+                sink += simStep(&run, dir);
+                optStep = fmin(optStep, now() - start);
+            }
+            refTotal += refStep;
+            optTotal += optStep;
+            refWorst = fmax(refWorst, refStep);
+            optWorst = fmax(optWorst, optStep);
+            done++;
+            const u16 events = simStep(&s, dir);
+            if (events & (SIM_EVENT_DEAD | SIM_EVENT_WIN)) break;
+            if (events & SIM_EVENT_LEVEL_UP) {
+                simInitLevel(&s);
+                continue;
+            }
+            if (events & SIM_EVENT_ATE) foods++;
+            if (events & SIM_EVENT_NO_FOOD) held++;
+            if ((events & (SIM_EVENT_ATE | SIM_EVENT_FOOD)) && s.food.y) { // New food must be reachable
+                benchRefPlaceFood(&s, 0, reached, &food);
+                mismatches += !reached[s.food.y * GRID_WIDTH + s.food.x];
+            }
+        }
+    }
+    if (!foods) foods = 1;
+    report("eat", "search", refTotal, foods, refTotal);
+    report("eat", "regions", optTotal, foods, refTotal);
+    fprintf(stderr, "eat: %u steps, %u foods, %u held back; worst step %.0f ns search, %.0f ns regions\n", done,
+            foods, held, refWorst * 1e9, optWorst * 1e9);
+    return mismatches;
+}
+#endif
+
+int main(int argc, char** argv) {
+    const char* only = NULL;
+    u32 count = 3000;
+    u32 maxSteps = 20000;
+    uint64_t seed = 1;
+    Bench b = { NULL, 0, 200 };
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:r:m:s:")) != -1) {
+        switch (opt) {
+            case 'c': only = optarg; break;
+            case 'n': count = (u32)strtoul(optarg, NULL, 0); break;
+            case 'r': b.repeat = (u32)strtoul(optarg, NULL, 0); break;
+            case 'm': maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 's': seed = strtoull(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-c case] [-n states] [-r repeat] [-m maxSteps] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (count < 1 || b.repeat < 1) {
+        fprintf(stderr, "states and repeat must be >= 1\n");
+        return 2;
+    }
+    simInitKeys();
+    b.states = sampleStates(count, maxSteps, seed);
+    b.count = count;
+
+    u32 mismatches = 0;
+    printf("case,variant,ns_per_op,speedup\n");
+    if (!only || !strcmp(only, "collision")) mismatches += benchCollision(&b);
+    if (!only || !strcmp(only, "free")) mismatches += benchFree(count * SAMPLE_EVERY, b.repeat, maxSteps, seed);
+#if SIM_FOOD_REGIONS
+    if (!only || !strcmp(only, "eat")) mismatches += benchEat(count * SAMPLE_EVERY, maxSteps, seed);
+#endif
+    free(b.states);
+    if (mismatches) {
+        fprintf(stderr, "%u results differ from the reference\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Cartridge SRAM dumps on the host (see sram.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sram.h"
+
+u8* sramLoad(const char* path, u32 offset, u32 magic, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long raw = ftell(f);
+    rewind(f);
+    u8* data = malloc(raw > 0 ? raw : 1);
+    if (!data || fread(data, 1, raw, f) != (size_t)raw) {
+        fclose(f);
+        free(data);
+        fprintf(stderr, "%s: read failed\n", path);
+        return NULL;
+    }
+    fclose(f);
+    for (u16 start = 0; start < 2; start++) {
+        for (u16 stride = 1; stride <= 2; stride++) {
+            const long first = start + (long)offset * stride;
+            if (raw < first + 4 * stride) continue;
+            u16 match = TRUE;
+            for (u16 i = 0; i < 4; i++) match &= data[first + i * stride] == (u8)(magic >> (24 - i * 8));
+            if (!match) continue;
+            *size = (raw - start + stride - 1) / stride;
+            for (size_t i = 0; i < *size; i++) data[i] = data[start + i * stride];
+            return data;
+        }
+    }
+    free(data);
+    return NULL;
+}
+
+u32 sramRead(const u8* sram, u32 offset, u16 bytes) {
+    u32 v = 0;
+    for (u16 i = 0; i < bytes; i++) v = (v << 8) | sram[offset + i];
+    return v;
+}
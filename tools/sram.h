@@ -0,0 +1,17 @@
+// Cartridge SRAM dumps on the host
+//
+// The ROM uses odd-byte SRAM (see rom_head.c), and emulators save it either packed (one file byte per
+// SRAM byte) or interleaved (the unused even bytes are kept). sramLoad() detects the layout from a
+// known magic value and returns the logical bytes as SGDK's SRAM_* offsets address them.
+
+#ifndef _SRAM_H_
+#define _SRAM_H_
+
+#include <stddef.h>
+
+#include "sim.h"
+
+u8* sramLoad(const char* path, u32 offset, u32 magic, size_t* size); // malloc'd bytes, or NULL if magic not found
+u32 sramRead(const u8* sram, u32 offset, u16 bytes); // Big-endian value of 1 to 4 bytes
+
+#endif // _SRAM_H_
@@ -0,0 +1,397 @@
+// Genetic tuner for the AI heuristic weights
+//
+// Evolves AiWeights (food, area, tail, portal) with a generational GA: elitism, tournament selection,
+// uniform crossover and bounded random mutation. Fitness is the mean score over a fixed seed set, so
+// every individual is judged on the same levels. Each (weights, seed) game is a runner job; results
+// are cached by (weights, seed), within a run and optionally across runs (-C file), so re-evaluating
+// elites or duplicate children never re-simulates a game. Individual 0 starts from fixed weights, not from
+// the header being regenerated, so a run depends only on its options (recorded in the header it writes).
+// The cache file header carries a fingerprint of the sim/AI code and build flags, so a cache written by a
+// different build is ignored.
+//
+// Usage: tuner [-p population] [-g generations] [-k seeds] [-m maxSteps] [-t threads] [-s seed]
+//              [-C cache.bin] [-o src/ai_weights.h] [-q]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "play.h"
+#include "runner.h"
+
+#define SEED_SET_BASE 0x5EED5EEDull // Fixed seed set shared by every run (fitness stays comparable)
+#define TOURNAMENT_SIZE 3
+#define ELITES 2
+#define MUTATION_RATE 30       // Percent chance per gene
+
+#define CACHE_MAGIC 0x324E5554 // "TUN2"
+#define CACHE_VERSION 1        // Bump when the cached fitness changes meaning
+#define FINGERPRINT_SEED 0x5EED5EED
+#define FINGERPRINT_STEPS 4000 // Long enough to cross several levels, portals and deaths
+#define BUILD_DEFINES ((u32)SIM_FREE_BITMAP | (u32)AI_LANDMARKS << 8)
+
+typedef struct {
+    s16 lo;
+    s16 hi;
+    s16 step;                  // Max mutation delta
+} GeneRange;
+
+// Gene order: food, area, tail, portal (matches AiWeights)
+static const GeneRange geneRange[4] = {
+    { 0, 60, 6 },
+    { 0, 30, 3 },
+    { 0, 2000, 150 },
+    { -300, 300, 40 },
+};
+
+// Individual 0 of every run (the weights the first tuned header started from)
+static const AiWeights startWeights = { 33, 27, 1953, 95 };
+
+typedef struct {
+    AiWeights w;
+    double fitness;            // Mean score over the seed set
+    double steps;              // Mean steps (reported only)
+} Individual;
+
+// Fitness cache: open addressing on (packed weights, seed)
+typedef struct {
+    uint64_t weights;
+    u32 seed;
+    u16 score;
+    u16 used;
+    u32 steps;
+} CacheEntry;
+
+typedef struct {
+    CacheEntry* slots;
+    size_t capacity;           // Power of two
+    size_t count;
+    uint64_t hits;
+    uint64_t misses;
+} Cache;
+
+// One game to simulate; written only by the job that owns it
+typedef struct {
+    AiWeights w;
+    u32 seed;
+    u16 score;
+    u32 steps;
+} Eval;
+
+typedef struct {
+    Eval* evals;
+    u32 maxSteps;
+} EvalBatch;
+
+static uint64_t rngState = 1;
+
+static uint64_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static s16 randomIn(s16 lo, s16 hi) {
+    return lo + (s16)(nextRandom() % (u32)(hi - lo + 1));
+}
+
+static s16* gene(AiWeights* w, int i) {
+    switch (i) {
+        case 0: return &w->food;
+        case 1: return &w->area;
+        case 2: return &w->tail;
+        default: return &w->portal;
+    }
+}
+
+static uint64_t packWeights(const AiWeights* w) {
+    return ((uint64_t)(u16)w->food << 48) | ((uint64_t)(u16)w->area << 32) |
+           ((uint64_t)(u16)w->tail << 16) | (u16)w->portal;
+}
+
+static size_t cacheSlot(const Cache* c, uint64_t weights, u32 seed) {
+    uint64_t h = weights ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ull);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    size_t i = h & (c->capacity - 1);
+    while (c->slots[i].used && (c->slots[i].weights != weights || c->slots[i].seed != seed)) {
+        i = (i + 1) & (c->capacity - 1);
+    }
+    return i;
+}
+
+static void cacheInsert(Cache* c, uint64_t weights, u32 seed, u16 score, u32 steps);
+
+static void cacheGrow(Cache* c) {
+    Cache old = *c;
+    c->capacity = old.capacity ? old.capacity * 2 : 4096;
+    c->slots = calloc(c->capacity, sizeof(CacheEntry));
+    c->count = 0;
+    if (!c->slots) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.slots[i].used) cacheInsert(c, old.slots[i].weights, old.slots[i].seed, old.slots[i].score, old.slots[i].steps);
+    }
+    free(old.slots);
+}
+
+static void cacheInsert(Cache* c, uint64_t weights, u32 seed, u16 score, u32 steps) {
+    if ((c->count + 1) * 2 > c->capacity) cacheGrow(c);
+    const size_t i = cacheSlot(c, weights, seed);
+    if (!c->slots[i].used) c->count++;
+    c->slots[i].weights = weights;
+    c->slots[i].seed = seed;
+    c->slots[i].score = score;
+    c->slots[i].steps = steps;
+    c->slots[i].used = 1;
+}
+
+static const CacheEntry* cacheFind(const Cache* c, uint64_t weights, u32 seed) {
+    if (!c->capacity) return NULL;
+    const size_t i = cacheSlot(c, weights, seed);
+    return c->slots[i].used ? &c->slots[i] : NULL;
+}
+
+// Sim/AI fingerprint: final hash of one fixed probe game mixed with the build defines and cache version.
+// Any change to maze generation, food placement or the AI search changes the probe game.
+static u32 fingerprint(void) {
+    static const AiWeights probe = { 20, 10, 500, 0 };
+    SimState s;
+    playGame(&s, FINGERPRINT_SEED, SIM_FOOD_UNIFORM, PLAY_POLICY_AI, &probe, FINGERPRINT_STEPS);
+    return simHash(&s) ^ BUILD_DEFINES ^ CACHE_VERSION << 24;
+}
+
+// Cache file: raw CacheEntry records after a header of magic, fingerprint and step cap (it changes scores)
+static void cacheLoad(Cache* c, const char* path, u32 print, u32 maxSteps) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return;
+    u32 header[3];
+    if (fread(header, sizeof(header), 1, f) == 1 && header[0] == CACHE_MAGIC && header[1] == print &&
+        header[2] == maxSteps) {
+        CacheEntry e;
+        while (fread(&e, sizeof(e), 1, f) == 1) cacheInsert(c, e.weights, e.seed, e.score, e.steps);
+    } else {
+        fprintf(stderr, "ignoring cache %s (different format, sim/AI build or step cap)\n", path);
+    }
+    fclose(f);
+}
+
+static void cacheSave(const Cache* c, const char* path, u32 print, u32 maxSteps) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    const u32 header[3] = { CACHE_MAGIC, print, maxSteps };
+    fwrite(header, sizeof(header), 1, f);
+    for (size_t i = 0; i < c->capacity; i++) {
+        if (c->slots[i].used) fwrite(&c->slots[i], sizeof(CacheEntry), 1, f);
+    }
+    fclose(f);
+}
+
+static void runEval(RunnerWorker* w, uint64_t job, void* user) {
+    (void)w;
+    EvalBatch* batch = user;
+    Eval* e = &batch->evals[job];
+    SimState s;
+    playGame(&s, e->seed, SIM_FOOD_UNIFORM, PLAY_POLICY_AI, &e->w, batch->maxSteps);
+    e->score = s.score;
+    e->steps = s.stepCount;
+}
+
+// Scores every individual on every seed, simulating only (weights, seed) pairs missing from the cache;
+// returns non-zero when allocation or the runner fails
+static int evaluate(Individual* pop, int popSize, const u32* seeds, int numSeeds, u32 maxSteps,
+                     const RunnerConfig* cfg, Cache* cache) {
+    Eval* evals = malloc(sizeof(Eval) * popSize * numSeeds);
+    if (!evals) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    size_t n = 0;
+    for (int i = 0; i < popSize; i++) {
+        const uint64_t key = packWeights(&pop[i].w);
+        for (int k = 0; k < numSeeds; k++) {
+            if (cacheFind(cache, key, seeds[k])) {
+                cache->hits++;
+                continue;
+            }
+            // Duplicates inside this batch are simulated once
+            int dup = 0;
+            for (size_t j = 0; j < n && !dup; j++) {
+                dup = evals[j].seed == seeds[k] && packWeights(&evals[j].w) == key;
+            }
+            if (dup) continue;
+            evals[n].w = pop[i].w;
+            evals[n].seed = seeds[k];
+            n++;
+        }
+    }
+    cache->misses += n;
+    EvalBatch batch = { evals, maxSteps };
+    RunnerResult res;
+    if (runnerRun(cfg, n, runEval, &batch, &res) != 0) {
+        fprintf(stderr, "runner failed\n");
+        free(evals);
+        return -1;
+    }
+    for (size_t j = 0; j < n; j++) {
+        cacheInsert(cache, packWeights(&evals[j].w), evals[j].seed, evals[j].score, evals[j].steps);
+    }
+    free(evals);
+
+    for (int i = 0; i < popSize; i++) {
+        const uint64_t key = packWeights(&pop[i].w);
+        double score = 0.0;
+        double steps = 0.0;
+        for (int k = 0; k < numSeeds; k++) {
+            const CacheEntry* e = cacheFind(cache, key, seeds[k]);
+            score += e->score;
+            steps += e->steps;
+        }
+        pop[i].fitness = score / numSeeds;
+        pop[i].steps = steps / numSeeds;
+    }
+    return 0;
+}
+
+static int byFitness(const void* a, const void* b) {
+    const double fa = ((const Individual*)a)->fitness;
+    const double fb = ((const Individual*)b)->fitness;
+    return (fa < fb) - (fa > fb);
+}
+
+static const Individual* tournament(const Individual* pop, int popSize) {
+    const Individual* best = &pop[nextRandom() % popSize];
+    for (int i = 1; i < TOURNAMENT_SIZE; i++) {
+        const Individual* c = &pop[nextRandom() % popSize];
+        if (c->fitness > best->fitness) best = c;
+    }
+    return best;
+}
+
+static void breed(const Individual* a, const Individual* b, Individual* child) {
+    for (int g = 0; g < 4; g++) {
+        s16 v = *gene((AiWeights*)((nextRandom() & 1) ? &a->w : &b->w), g);
+        if ((int)(nextRandom() % 100) < MUTATION_RATE) {
+            v += randomIn(-geneRange[g].step, geneRange[g].step);
+            if (v < geneRange[g].lo) v = geneRange[g].lo;
+            if (v > geneRange[g].hi) v = geneRange[g].hi;
+        }
+        *gene(&child->w, g) = v;
+    }
+}
+
+// The header records the options that reproduce it
+static int writeHeader(const char* path, const Individual* best, int popSize, int generations, int numSeeds,
+                       u32 maxSteps, uint64_t seed) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "// AI heuristic weights\n");
+    fprintf(f, "// Generated by tools/tuner -p %d -g %d -k %d -m %u -s %llu (individual 0: %d,%d,%d,%d)\n",
+            popSize, generations, numSeeds, maxSteps, (unsigned long long)seed, startWeights.food, startWeights.area,
+            startWeights.tail, startWeights.portal);
+    fprintf(f, "// Regenerate rather than edit\n");
+    fprintf(f, "\n#ifndef _AI_WEIGHTS_H_\n#define _AI_WEIGHTS_H_\n\n");
+    fprintf(f, "#define AI_WEIGHT_FOOD %-7d // Per step of path length to food\n", best->w.food);
+    fprintf(f, "#define AI_WEIGHT_AREA %-7d // Per reachable cell\n", best->w.area);
+    fprintf(f, "#define AI_WEIGHT_TAIL %-7d // Tail reachable\n", best->w.tail);
+    fprintf(f, "#define AI_WEIGHT_PORTAL %-5d // Move goes through a portal\n", best->w.portal);
+    fprintf(f, "\n#endif // _AI_WEIGHTS_H_\n");
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int popSize = 48;
+    int generations = 20;
+    int numSeeds = 24;
+    u32 maxSteps = 5000;
+    const char* cachePath = NULL;
+    const char* outPath = NULL;
+    RunnerConfig cfg = { 0, 1, 1 };
+    int opt;
+    while ((opt = getopt(argc, argv, "p:g:k:m:t:s:C:o:q")) != -1) {
+        switch (opt) {
+            case 'p': popSize = atoi(optarg); break;
+            case 'g': generations = atoi(optarg); break;
+            case 'k': numSeeds = atoi(optarg); break;
+            case 'm': maxSteps = (u32)strtoul(optarg, NULL, 0); break;
+            case 't': cfg.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': rngState = strtoull(optarg, NULL, 0) | 1; break;
+            case 'C': cachePath = optarg; break;
+            case 'o': outPath = optarg; break;
+            case 'q': cfg.progress = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-p population] [-g generations] [-k seeds] [-m maxSteps] [-t threads] "
+                                "[-s seed] [-C cache.bin] [-o header] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (popSize < ELITES + 1 || numSeeds < 1 || generations < 1) {
+        fprintf(stderr, "population must be > %d, seeds and generations >= 1\n", ELITES);
+        return 2;
+    }
+
+    const uint64_t runSeed = rngState;      // -s as given, for the header
+    simInitKeys();
+    u32* seeds = malloc(sizeof(u32) * numSeeds);
+    if (!seeds) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int k = 0; k < numSeeds; k++) seeds[k] = (u32)runnerJobSeed(SEED_SET_BASE, k);
+    Cache cache = { 0 };
+    const u32 print = cachePath ? fingerprint() : 0;
+    if (cachePath) cacheLoad(&cache, cachePath, print, maxSteps);
+
+    // Initial population: the fixed start weights plus random individuals
+    Individual* pop = calloc(popSize, sizeof(Individual));
+    Individual* next = calloc(popSize, sizeof(Individual));
+    if (!pop || !next) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    pop[0].w = startWeights;
+    for (int i = 1; i < popSize; i++) {
+        for (int g = 0; g < 4; g++) *gene(&pop[i].w, g) = randomIn(geneRange[g].lo, geneRange[g].hi);
+    }
+
+    for (int gen = 0; gen < generations; gen++) {
+        if (evaluate(pop, popSize, seeds, numSeeds, maxSteps, &cfg, &cache) != 0) return 1;
+        qsort(pop, popSize, sizeof(Individual), byFitness);
+        double mean = 0.0;
+        for (int i = 0; i < popSize; i++) mean += pop[i].fitness;
+        printf("gen %2d  best %.1f (steps %.0f)  mean %.1f  weights %d,%d,%d,%d  cache %llu hits / %llu sims\n",
+               gen, pop[0].fitness, pop[0].steps, mean / popSize, pop[0].w.food, pop[0].w.area, pop[0].w.tail,
+               pop[0].w.portal, (unsigned long long)cache.hits, (unsigned long long)cache.misses);
+        fflush(stdout);
+        if (gen == generations - 1) break;
+
+        for (int i = 0; i < ELITES; i++) next[i] = pop[i];
+        for (int i = ELITES; i < popSize; i++) breed(tournament(pop, popSize), tournament(pop, popSize), &next[i]);
+        Individual* t = pop;
+        pop = next;
+        next = t;
+    }
+
+    printf("best weights: -w %d,%d,%d,%d  fitness %.1f\n", pop[0].w.food, pop[0].w.area, pop[0].w.tail,
+           pop[0].w.portal, pop[0].fitness);
+    int rc = 0;
+    if (outPath) rc = writeHeader(outPath, &pop[0], popSize, generations, numSeeds, maxSteps, runSeed);
+    if (cachePath) cacheSave(&cache, cachePath, print, maxSteps);
+    free(pop);
+    free(next);
+    free(seeds);
+    free(cache.slots);
+    return rc ? 1 : 0;
+}